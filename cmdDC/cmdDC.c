@@ -41,6 +41,8 @@
 
 #define UDP_DISPLAY_COMM_PORT 48029
 #define UDP_BROADCAST_PORT    48028
+#define UDP_MULTICAST_GROUP   "239.255.48.28"
+#define UDP_MULTICAST_TTL     1
 #define UDP_REGULAR_PORT      48027
 #define UDP_CLIENTS_PORT      48026
 #define MS_TEN_MINUTES       600000
@@ -129,7 +131,7 @@ static gboolean cb_udp_registry_select_handler(PControlData pctrl);
 PIPBroadcastArray skn_get_default_interface_name_and_ipv4_address(char * intf, char * ipv4);
 gint skn_get_broadcast_ip_array(PIPBroadcastArray paB);
 gint skn_get_default_interface_name(char *pchDefaultInterfaceName);
-gboolean skn_udp_network_broadcast_all_interfaces(GSocket *gSock, PIPBroadcastArray pab);
+gboolean skn_udp_network_broadcast_all_interfaces(GSocket *gSock, PIPBroadcastArray pab, const gchar *service_name, gboolean multicast);
 gchar * skn_strip(gchar * alpha);
 
 /**
@@ -288,33 +290,47 @@ gint skn_get_default_interface_name(char *pchDefaultInterfaceName) {
 /**
  *  Send a registry request on the broadcast ip of all interfaces
  *
+ * - asks with "FIND name=<service_name>", so only that service answers
+ * - with multicast, sends to UDP_MULTICAST_GROUP out of each interface
+ *   instead, reaching only the locators that joined it
+ *
  * @param gSock         IN  GLib active/bound socket with broadcast enabled
- * @param ch_request    IN  Greetings message, anytext
- * @param ch_intfName   OUT Default Ethernet Interface Name
- * @param ch_ipAddress  OUT Default Ethernet IP Address
+ * @param paB           IN  Broadcast addresses of this machine's interfaces
+ * @param service_name  IN  Service wanted, a trailing '*' matches by prefix
+ * @param multicast     IN  Send to the group rather than broadcast
  * @return true on success,
  */
-gboolean skn_udp_network_broadcast_all_interfaces(GSocket *gSock, PIPBroadcastArray paB) {
+gboolean skn_udp_network_broadcast_all_interfaces(GSocket *gSock, PIPBroadcastArray paB, const gchar *service_name, gboolean multicast) {
     struct sockaddr_in remaddr; /* remote address */
     socklen_t addrlen = sizeof(remaddr); /* length of addresses */
-    gchar *request = "urn:rpilocator - Rpi Where Are You?";
+    struct in_addr ifaddr;
+    gchar request[SZ_RMTADDR_BUFF + 16];
     gint vIndex = 0;
     gint i_socket = g_socket_get_fd(gSock);
 
     g_print("[REGISTRY] Socket Bound to %s\n", paB->ipAddrStr[paB->defaultIndex]);
-
+    g_snprintf(request, sizeof(request), "FIND name=%s", service_name);
+    if (multicast) {
+        g_socket_set_multicast_ttl(gSock, UDP_MULTICAST_TTL);
+    }
 
     for (vIndex = 0; vIndex < paB->count; vIndex++) {
         memset(&remaddr, 0, sizeof(remaddr));
         remaddr.sin_family = AF_INET;
-        remaddr.sin_addr.s_addr = inet_addr(paB->broadAddrStr[vIndex]);
+        remaddr.sin_addr.s_addr = inet_addr(multicast ? UDP_MULTICAST_GROUP : paB->broadAddrStr[vIndex]);
         remaddr.sin_port = htons(UDP_BROADCAST_PORT);
 
+        ifaddr.s_addr = inet_addr(paB->ipAddrStr[vIndex]);
+        if (multicast && (setsockopt(i_socket, IPPROTO_IP, IP_MULTICAST_IF, &ifaddr, sizeof(ifaddr)) < 0)) {
+            g_warning("IP_MULTICAST_IF on %s; Failure code=%d, etext=%s", paB->ifNameStr[vIndex], errno, strerror(errno));
+            continue;
+        }
         if (sendto(i_socket, request, strlen(request), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
             g_warning("SendTo() Timed out; Failure code=%d, etext=%s", errno, strerror(errno));
             break;
         }
-        g_print("[REGISTRY] Query Broadcasted on %s:%s:%d\n", paB->ifNameStr[vIndex], paB->broadAddrStr[vIndex], UDP_BROADCAST_PORT);
+        g_print("[REGISTRY] Query %s on %s:%s:%d\n", (multicast ? "Multicast" : "Broadcasted"), paB->ifNameStr[vIndex],
+                (multicast ? UDP_MULTICAST_GROUP : paB->broadAddrStr[vIndex]), UDP_BROADCAST_PORT);
     }
 
     return(TRUE);
@@ -707,9 +723,9 @@ static gboolean cb_udp_registry_select_handler(PControlData pctrl) {
     if (g_list_length(pctrl->glRegistry) < 1) {
         pctrl->gRegistryQueries++;
 
-        if ((pctrl->gRegistryQueries % 15) == 0) {  // every 30 seconds redo query
+        if ((pctrl->gRegistryQueries == 1) || ((pctrl->gRegistryQueries % 15) == 0)) {  // no multicast answer, then every 30 seconds redo query
             g_print("[REGISTRY] Looking for [%s] in Rpi Registry every 30 seconds.  StandBy...\n", pctrl->ch_display_service_name);
-            skn_udp_network_broadcast_all_interfaces(pctrl->gBroadcastSocket, pctrl->paB);
+            skn_udp_network_broadcast_all_interfaces(pctrl->gBroadcastSocket, pctrl->paB, pctrl->ch_display_service_name, FALSE); // older locators are not in the group
         }
 
         return (G_SOURCE_CONTINUE);
@@ -847,8 +863,8 @@ int main(int argc, char **argv) {
     g_unix_signal_add (SIGTERM,(GSourceFunc) cb_unix_signal_handler, &cData.sigTerm);
 
     /*
-     * Broadcast Registry Request: 10.100.1.255 */
-    if ( skn_udp_network_broadcast_all_interfaces(gSock, cData.paB) ) {
+     * Multicast Registry Request: 239.255.48.28, broadcast if no locator answers */
+    if ( skn_udp_network_broadcast_all_interfaces(gSock, cData.paB, cData.ch_display_service_name, TRUE) ) {
         /*
          * Setup 2secTimer to find display_service before starting rest  */
         g_timeout_add (2000, (GSourceFunc)cb_udp_registry_select_handler, &cData);
@@ -54,6 +54,7 @@
 
 #define UDP_COMM_PORT      48029
 #define UDP_BROADCAST_PORT 48028
+#define UDP_MULTICAST_GROUP "239.255.48.28"
 #define UDP_REGULAR_PORT   48027
 #define MS_TEN_MINUTES    600000
 
@@ -71,6 +72,7 @@
 #define SKN_UDP_ANY_PORT 0
 #define ARY_MAX_INTF 8
 #define PLATFORM_ERROR -1
+#define SKN_REPLY_JITTER 50  // ms a registry reply is held back, at most
 
 typedef struct _ipBroadcastArray {
     char cbName[SZ_CHAR_BUFF];
@@ -143,6 +145,12 @@ typedef struct _controlData {
     gchar *pch_service_name;
 } ControlData, *PControlData;
 
+typedef struct _deferredReply {
+    GSocket *gSock;
+    GSocketAddress *gsRmtAddr;
+    gchar response[SZ_RESPONSE_BUFF];
+} DeferredReply, *PDeferredReply;
+
 enum _messages {
   MSGS_COLUMN_TIMESTAMP,
   COLUMN_NODE,
@@ -175,6 +183,7 @@ PIPBroadcastArray skn_get_default_interface_name_and_ipv4_address(char * intf, c
 gint skn_get_broadcast_ip_array(PIPBroadcastArray paB);
 gint skn_get_default_interface_name(char *pchDefaultInterfaceName);
 gboolean skn_udp_network_broadcast_all_interfaces(GSocket *gSock, PIPBroadcastArray pab);
+gint skn_udp_network_join_multicast_group(GSocket *gSock, PIPBroadcastArray paB);
 
 
 static gboolean cb_unix_signal_handler(PUSignalData psig);
@@ -183,6 +192,8 @@ static gboolean cb_registry_request_handler(PRegData msg, PControlData pctrl);
 static gboolean cb_message_request_handler(PMsgData msg, PControlData pctrl);
 static gboolean cb_udp_comm_request_handler(GSocket *socket, GIOCondition condition, PControlData pctrl);
 static gboolean cb_udp_broadcast_response_handler(GSocket *gSock, GIOCondition condition, PControlData pctrl);
+static gint skn_registry_query_response(const gchar *request, PControlData pctrl, gchar *response, gint size);
+static gboolean cb_udp_deferred_reply(PDeferredReply pdr);
 PPRegData udp_registry_response_parser(PRegData msg, gchar *response);
 
 
@@ -477,6 +488,35 @@ gint skn_get_default_interface_name(char *pchDefaultInterfaceName) {
     }
 
 }
+/**
+ * Join the discovery multicast group on every interface, so queries sent
+ * to the group reach this service as broadcast ones do
+ *
+ * @param gSock   IN  GLib socket bound to UDP_BROADCAST_PORT
+ * @param paB     IN  Interfaces of this machine
+ * @return count of interfaces joined
+ */
+gint skn_udp_network_join_multicast_group(GSocket *gSock, PIPBroadcastArray paB) {
+    GInetAddress *group = g_inet_address_new_from_string(UDP_MULTICAST_GROUP);
+    GError *error = NULL;
+    gint vIndex = 0;
+    gint joined = 0;
+
+    for (vIndex = 0; vIndex < paB->count; vIndex++) {
+        if (!g_socket_join_multicast_group(gSock, group, FALSE, paB->ifNameStr[vIndex], &error)) {
+            g_warning("[REGISTRY] Join multicast group %s on %s => %s", UDP_MULTICAST_GROUP, paB->ifNameStr[vIndex], error->message);
+            g_clear_error(&error);
+            continue;
+        }
+        joined++;
+    }
+    g_object_unref(group);
+
+    g_print("[REGISTRY] Multicast group %s joined on %d interfaces\n", UDP_MULTICAST_GROUP, joined);
+
+    return(joined);
+}
+
 /**
  *  Send a registry request on the broadcast ip of all interfaces
  *
@@ -547,6 +587,88 @@ static gboolean cb_registry_refresh(PControlData pctrl) {
     return ( G_SOURCE_CONTINUE );
 }
 
+/**
+ * Registry reply for a request
+ *
+ * A known-answer query, "QUERY want=<name> known=<ip>:<port>,...", gets
+ * only the entries it names and does not already know; "FIND name=<name>"
+ * does the same, a trailing '*' on name matching by prefix. Any other
+ * request gets both entries.
+ *
+ * Returns length of the reply, zero when there is nothing to send
+ */
+static gint skn_registry_query_response(const gchar *request, PControlData pctrl, gchar *response, gint size) {
+    gchar *names[2] = { "rpi_locator_service", pctrl->pch_service_name };
+    guint ports[2] = { UDP_BROADCAST_PORT, pctrl->gUDPPort };
+    gchar ** fields = NULL;
+    gchar ** known = NULL;
+    gchar *want = NULL;
+    gchar item[SZ_PARAMS_BUFF];
+    gint f_index = 0;
+    gint k_index = 0;
+    gint index = 0;
+    gint len = 0;
+    gboolean listed = FALSE;
+    gboolean find = (g_str_has_prefix(request, "FIND") && ((request[4] == 0) || g_ascii_isspace(request[4])));
+    gboolean prefix = FALSE;
+
+    if (find || (g_str_has_prefix(request, "QUERY") && ((request[5] == 0) || g_ascii_isspace(request[5])))) {
+        fields = g_strsplit_set(request, " \t\r\n", -1);
+        for (f_index = 0; fields[f_index] != NULL; f_index++) {
+            if (g_str_has_prefix(fields[f_index], (find ? "name=" : "want="))) {
+                want = &fields[f_index][5];
+            } else if (g_str_has_prefix(fields[f_index], "known=") && (known == NULL)) {
+                known = g_strsplit(&fields[f_index][6], ",", -1);
+            }
+        }
+    }
+    if (find && (want != NULL) && g_str_has_suffix(want, "*")) {
+        want[strlen(want) - 1] = 0;
+        prefix = TRUE;
+    }
+
+    response[0] = 0;
+    for (index = 0; index < 2; index++) {
+        if ((want != NULL) && (prefix ? !g_str_has_prefix(names[index], want) : (g_strcmp0(want, names[index]) != 0))) {
+            continue;
+        }
+        g_snprintf(item, sizeof(item), "%s:%u", pctrl->ch_this_ip, ports[index]);
+        listed = FALSE;
+        for (k_index = 0; (known != NULL) && (known[k_index] != NULL); k_index++) {
+            if (g_strcmp0(known[k_index], item) == 0) {
+                listed = TRUE;
+            }
+        }
+        if (!listed && (len < size)) {
+            len += g_snprintf(&response[len], size - len, "name=%s,ip=%s,port=%u|", names[index], pctrl->ch_this_ip, ports[index]);
+        }
+    }
+
+    g_strfreev(known);
+    g_strfreev(fields);
+
+    return (len < size ? len : size - 1);
+}
+
+/**
+ * Sends a registry reply held back by the jitter timeout, then frees it
+ */
+static gboolean cb_udp_deferred_reply(PDeferredReply pdr) {
+    GError *error = NULL;
+
+    g_socket_send_to (pdr->gSock, pdr->gsRmtAddr, pdr->response, strlen(pdr->response), NULL, &error);
+    if (error != NULL) {
+        g_message("gtkDS::cb_udp_deferred_reply() g_socket_send_to() => %s", error->message);
+        g_clear_error(&error);
+    }
+
+    g_object_unref(pdr->gsRmtAddr);
+    g_object_unref(pdr->gSock);
+    g_free(pdr);
+
+    return (G_SOURCE_REMOVE);
+}
+
 static gboolean cb_udp_broadcast_response_handler(GSocket *gSock, GIOCondition condition, PControlData pctrl) {
     GError *error = NULL;
     GSocketAddress *gsRmtAddr = NULL;
@@ -560,6 +682,7 @@ static gboolean cb_udp_broadcast_response_handler(GSocket *gSock, GIOCondition c
     gchar response[SZ_RESPONSE_BUFF];
     gint h_index = 0;
     gchar *converted = NULL;
+    PDeferredReply pdr = NULL;
 
     if ((condition & G_IO_HUP) || (condition & G_IO_ERR) || (condition & G_IO_NVAL)) {  /* SHUTDOWN THE MAIN LOOP */
         g_message("gtkDS::cb_udp_broadcast_response_handler(error) Operational Error / Shutdown Signaled => %s\n", skn_gio_condition_to_string(condition));
@@ -622,26 +745,23 @@ static gboolean cb_udp_broadcast_response_handler(GSocket *gSock, GIOCondition c
             }
             g_free(msgs);
         } else {
-            g_free(message);
-
             /* Format: name=rpi_locator_service,ip=10.100.1.19,port=48028|
              *         name=gtk_display_service,ip=10.100.1.19,port=48029|
+             * - only what a known-answer query is missing, if anything
+             * - held back a random 0..SKN_REPLY_JITTER ms, so a subnet of
+             *   responders does not answer in the same instant
              */
-
-            g_snprintf(response, sizeof(response),
-                       "name=rpi_locator_service,ip=%s,port=48028|name=%s,ip=%s,port=%d|",
-                       pctrl->ch_this_ip, pctrl->pch_service_name, pctrl->ch_this_ip, pctrl->gUDPPort);
-            /*
-             * Send Registry Response to caller */
-
-            g_print("[REGISTRY] Responding to Query: %s\n", response);
-
-            g_socket_send_to (gSock, gsRmtAddr, response, strlen(response), NULL, &error);
-            if (error != NULL) {  // gss_send = Number of bytes written (which may be less than size ), or -1 on error
-                g_error("g_socket_send_to() => %s", error->message);
-                g_free(message);
-                g_clear_error(&error);
+            if (skn_registry_query_response(message->ch_message, pctrl, response, sizeof(response)) == 0) {
+                g_print("[REGISTRY] Nothing new for Query: %s\n", message->ch_message);
+            } else {
+                g_print("[REGISTRY] Responding to Query: %s\n", response);
+                pdr = g_new0(DeferredReply, 1);
+                pdr->gSock = g_object_ref(gSock);
+                pdr->gsRmtAddr = g_object_ref(gsRmtAddr);
+                g_strlcpy(pdr->response, response, sizeof(pdr->response));
+                g_timeout_add(g_random_int_range(0, SKN_REPLY_JITTER + 1), (GSourceFunc) cb_udp_deferred_reply, pdr);
             }
+            g_free(message);
         }
     }
     g_free(stamp);
@@ -1546,6 +1666,7 @@ int main(int argc, char **argv) {
         g_clear_error(&error);
         exit(EXIT_FAILURE);
     }
+    skn_udp_network_join_multicast_group(cData.gbSock, paB);
 
     gBroadSource = g_socket_create_source(cData.gbSock, G_IO_IN, NULL);
         g_source_ref(gBroadSource);
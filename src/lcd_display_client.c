@@ -68,18 +68,21 @@ int main(int argc, char *argv[])
     PServiceRegistry psr = NULL;
     PRegistryEntry pre = NULL;
     PServiceRequest pnsr = NULL;
+    DiscoveryRequest discovery;
+    char *service_name = "lcd_display_service";
     int vIndex = 0;
     long host_update_cycle = 0;
 
     memset(registry, 0, sizeof(registry));
     memset(request, 0, sizeof(request));
-	strncpy(registry, "DisplayClient: Raspberry Pi where are you?", sizeof(registry) - 1);
 
     skn_program_name_and_description_set(
     		"lcd_display_client",
 			"Send messages to the Display Service."
 			);
 
+    gd_i_quorum = 1; // the first provider of the service ends discovery
+
 	/* Parse any command line options,
 	 * like request string override */
     if (skn_handle_locator_command_line(argc, argv) == EXIT_FAILURE) {
@@ -94,7 +97,6 @@ int main(int argc, char *argv[])
     }
 
 	skn_logger(SD_DEBUG, "Request  Message [%s]", request);
-	skn_logger(SD_DEBUG, "Registry Message [%s]", registry);
 
 	/* Initialize Signal handler */
 	signals_init();
@@ -109,15 +111,19 @@ int main(int argc, char *argv[])
     skn_logger(SD_NOTICE, "Application Active...");
 
 	/* Get the ServiceRegistry from Provider
+	 * - a locator on this host is read through shared memory, sending nothing
+	 * - returns once gd_i_quorum providers of service_name answer, or after 4 seconds
+	 * - tries the locator cached by the last run before broadcasting
+	 * - asks with FIND, so only providers of service_name answer
 	 * - could return null if error */
-	psr = service_registry_get_via_udp_broadcast(gd_i_socket, registry);
+    if (gd_pch_service_name != NULL) {
+        service_name = gd_pch_service_name;
+    }
+    snprintf(registry, sizeof(registry), "%s name=%s", SKN_FIND_REQUEST, service_name);
+	skn_logger(SD_DEBUG, "Registry Message [%s]", registry);
+	service_registry_discovery_init(&discovery, service_name, gd_i_quorum, 4.0);
+	psr = service_registry_discover_shared(gd_i_socket, registry, &discovery);
 	if (psr != NULL && service_registry_entry_count(psr) != 0) {
-	    char *service_name = "lcd_display_service";
-
-	    if (gd_pch_service_name != NULL) {
-	        service_name = gd_pch_service_name;
-	    }
-
 		/* find a single entry */
 		pre = service_registry_find_entry(psr, service_name);
 		if (pre != NULL) {
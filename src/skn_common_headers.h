@@ -26,11 +26,19 @@
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/time.h> // for clock_gettime()
+#include <sys/epoll.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <net/if.h>
 #include <ifaddrs.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <time.h>
 #include <stdarg.h>
 #include <math.h>
@@ -99,6 +107,10 @@
 #define ARY_MAX_INTF 8
 #define ARY_MAX_REGISTRY 128
 #define ARY_MAX_DM_LINES 24
+#define ARY_MAX_WORKERS 32
+#define ARY_MAX_BATCH 64
+#define ARY_MAX_RESOLVER 256
+#define ARY_MAX_EVENT_SOURCES 8
 #define SKN_RUN_MODE_RUN  0
 #define SKN_RUN_MODE_STOP 1
 
@@ -213,6 +225,59 @@
 
 
 
+/*
+ * Simulated LCD, --i2c-chipset=sim
+ * - an HD44780's display memory kept in RAM and written by the same cursor
+ *   moves and cell runs a real one gets, so the screen can be dumped or
+ *   compared with what the render loop believes it shows
+ * - counts the bytes each real bus would have carried for the same frames
+*/
+#define ARY_MAX_LCD_ROWS         4
+#define ARY_MAX_LCD_COLS         20
+#define SKN_SIM_DDRAM            128  // display memory, rows 0,2 from 0x00 and rows 1,3 from 0x40
+#define SKN_SIM_SERIAL_MOVE      4    // 0xFE 0x47 col row
+#define SKN_SIM_I2C_BYTES        26   // PCF8574 bus bytes per LCD byte: two nibbles, each
+                                      // pin change one addressed port write, RS included
+
+typedef struct _lcdSimulator {
+    char cbName[SZ_CHAR_BUFF];
+    unsigned char ddram[SKN_SIM_DDRAM];
+    int  row_address[ARY_MAX_LCD_ROWS];
+    int  address;                // the cursor, an index into ddram
+    unsigned long commands;      // cursor moves
+    unsigned long cells;         // characters written
+} LCDSimulator, *PLCDSimulator;
+
+/*
+ * Serial LCD link, --i2c-chipset=ser
+ * - a frame's cursor moves and cells are queued in tx and leave in one
+ *   non-blocking write as the frame ends
+ * - busy_until is when the backpack will have taken everything written:
+ *   each byte's time on the wire at --baud, or --pacing when the LCD is
+ *   slower, plus the settle time the datasheet gives a command
+ * - while bytes of the last frame are queued, or the backpack is busy, a
+ *   frame is deferred and its changes go out with the next
+*/
+#define SKN_SERIAL_BAUD          9600
+#define SKN_SERIAL_PACING        41     // us an HD44780 takes a character, 37us write and 4us address update
+#define SKN_MAX_SERIAL_PACING    10000
+#define SKN_SERIAL_SETTLE_CLEAR  1520   // us, clear display and return home
+#define SKN_SERIAL_SETTLE_EEPROM 3400   // us, the backpack saves contrast to its EEPROM
+#define SZ_SERIAL_TX             (ARY_MAX_LCD_ROWS * ARY_MAX_LCD_COLS * (SKN_SIM_SERIAL_MOVE + 1))  // every cell its own move
+
+typedef struct _serialLink {
+    char cbName[SZ_CHAR_BUFF];
+    char tx[SZ_SERIAL_TX];
+    int  tx_len;                 // queued, not yet written
+    double byte_time;            // seconds a byte
+    double settle;               // seconds the queued commands need beyond their bytes
+    double busy_until;           // CLOCK_MONOTONIC seconds
+    unsigned long writes;
+    unsigned long bytes;
+    unsigned long partial;       // writes the port took only part of
+    unsigned long errors;        // writes failed, their bytes dropped
+} SerialLink, *PSerialLink;
+
 typedef struct _IICLCD {
     char cbName[SZ_CHAR_BUFF];
     char ch_serial_port_name[SZ_CHAR_BUFF]; // SerialPort.open("/dev/ttyACM0", 9600, 8, 1, SerialPort::NONE)
@@ -237,6 +302,13 @@ typedef struct _IICLCD {
     int af_db6;
     int af_db7;
     int (*setup)(const int, const int);
+    void (*move)(struct _IICLCD *plcd, int row, int col);           // cursor to row, col
+    void (*put)(struct _IICLCD *plcd, const char *cells, int len);  // cells from the cursor on
+    int  (*ready)(struct _IICLCD *plcd);   // FALSE defers the frame, NULL always ready
+    void (*flush)(struct _IICLCD *plcd);   // ends a frame, NULL when move and put send at once
+    int  lost;                   // set when queued cells were dropped, the LCD no longer shows the shadow
+    PLCDSimulator sim;           // sim only
+    PSerialLink link;            // ser only
 } LCDDevice, *PLCDDevice;
 
 
@@ -251,26 +323,673 @@ typedef struct _ipBroadcastArray {
     int count; // index = count - 1
 } IPBroadcastArray, *PIPBroadcastArray;
 
+/*
+ * Interface cache
+ * - broadcast capable IPv4 addresses and the default route, in binary form,
+ *   rebuilt from netlink dumps whenever the kernel reports an address or
+ *   route change, so a lookup is one pointer read
+ * - a published snapshot is never written again; its slot is reused after
+ *   ARY_MAX_INTF_SNAPSHOTS - 1 newer ones, and rebuilds are at least
+ *   SKN_INTF_REBUILD_INTERVAL seconds apart, so a snapshot read stays valid
+ *   for seven seconds; a reader holds it for one batch or poll, and copies
+ *   out what is kept longer
+*/
+#define ARY_MAX_INTF_SNAPSHOTS    8
+#define SKN_INTF_NETLINK_BUFF     8192
+#define SKN_INTF_REBUILD_INTERVAL 1.0
+
+typedef struct _interfaceEntry {
+    char name[IF_NAMESIZE];      // address label, eth0 or eth0:1
+    int  index;                  // kernel ifindex
+    struct in_addr addr;
+    struct in_addr mask;
+    struct in_addr broadcast;
+} InterfaceEntry, *PInterfaceEntry;
+
+typedef struct _interfaceSnapshot {
+    unsigned long generation;    // 1 for the first load, bumped by each rebuild
+    int count;
+    int defaultIndex;            // entry on the default route, else 0
+    char defaultName[IF_NAMESIZE];   // empty without a default route
+    InterfaceEntry entry[ARY_MAX_INTF];
+} InterfaceSnapshot, *PInterfaceSnapshot;
+
+typedef struct _interfaceCache {
+    char cbName[SZ_CHAR_BUFF];
+    pthread_mutex_t lock;        // startup and rebuilds; readers never take it
+    pthread_t listener_thread;
+    long thread_complete;
+    int  shutdown;
+    int  nl_socket;              // subscribed to address and route changes
+    unsigned int seq;            // of the last dump request
+    PInterfaceSnapshot current;  // published with release, read with acquire
+    int  next;                   // slot the next rebuild fills
+    unsigned long events;        // netlink notifications received
+    unsigned long rebuilds;
+    unsigned long overruns;      // notifications lost to a full socket buffer
+    unsigned long deferred;      // changes held back to space the rebuilds
+    InterfaceSnapshot slot[ARY_MAX_INTF_SNAPSHOTS];
+} InterfaceCache, *PInterfaceCache;
+
+/*
+ * RegistryEntry
+ * - name and ip are interned in the owning registry's arena, so equal
+ *   strings share one pointer; ip is kept for display, addr for sockets
+*/
 typedef struct _serviceEntry {
-	char cbName[SZ_CHAR_BUFF];
-	char name[SZ_INFO_BUFF];
-	char ip[SZ_INFO_BUFF];
-	int port;
+    const char *name;
+    const char *ip;
+    struct in_addr addr;
+    uint16_t port;
 } RegistryEntry, *PRegistryEntry;
 
+/*
+ * RegistryRecord
+ * - one parsed response line, each value a span of the caller's const buffer
+ * - spans are not terminated; len is the value length after stripping
+*/
+typedef struct _registrySpan {
+    const char *start;
+    int len;
+} RegistrySpan, *PRegistrySpan;
+
+typedef struct _registryRecord {
+    RegistrySpan name;
+    RegistrySpan ip;
+    RegistrySpan port;
+} RegistryRecord, *PRegistryRecord;
+
+/*
+ * RegistryArena
+ * - bump allocator for entries and interned strings, blocks double in size
+ * - the whole arena is released by service_registry_destroy()
+*/
+#define SKN_REGISTRY_ARENA_BLOCK 8192
+
+typedef struct _arenaBlock {
+    struct _arenaBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock, *PArenaBlock;
+
+typedef struct _registryArena {
+    PArenaBlock head;
+    size_t next_size;  // size of the next block to allocate
+    size_t reserved;   // bytes obtained from malloc
+    size_t used;       // bytes handed out
+    int blocks;
+} RegistryArena, *PRegistryArena;
+
+/*
+ * ServiceRegistry
+ * - entries are kept in arrival order and grow by doubling from ARY_MAX_REGISTRY
+ * - two open addressed indexes hold entry position + 1, zero is empty:
+ *   key_index on (name, ip, port) for upserts, name_index on name for finds
+ * - intern holds every distinct name and ip string, keyed by content
+*/
 typedef struct _serviceRegistry {
 	char cbName[SZ_CHAR_BUFF];
     int count;  // current number of entries
-    int computedMax; // computed container size of .entry
-    PRegistryEntry entry[ARY_MAX_REGISTRY];
+    int computedMax; // current container size of .entry
+    PRegistryEntry *entry;
+    int index_mask;  // index slots - 1; slots are a power of two, at least twice computedMax
+    int *key_index;
+    int *name_index;
+    const char **intern;
+    int intern_mask;
+    int intern_count;
+    RegistryArena arena;
 } ServiceRegistry, *PServiceRegistry;
 
+/*
+ * DiscoveryRequest
+ * - service_registry_discover() ends at deadline, or as soon as service_name
+ *   has arrived from min_responders distinct providers
+ * - min_responders of zero waits out the deadline, like the broadcast mode
+ * - on_response sees each parsed response; any return but EXIT_SUCCESS ends discovery
+*/
+#define ARY_MAX_RESPONDERS 64
+
+typedef struct _discoveryRequest {
+    char cbName[SZ_CHAR_BUFF];
+    const char *service_name;    // NULL counts every responder
+    int min_responders;
+    struct timespec deadline;    // CLOCK_MONOTONIC
+    int (*on_response)(struct _discoveryRequest *pdr, PServiceRegistry psr, struct sockaddr_in *premaddr, int records);
+    void *context;
+    struct in_addr unicast;      // when set, ask this locator only
+    int rounds;                  // broadcasts at most, each after the first lists the answers heard
+    int multicast;               // first round goes to gd_pch_multicast_group
+    int broadcasts;              // request datagrams broadcast
+    int multicasts;              // request datagrams sent to the group
+    int probes;                  // request datagrams sent unicast
+    int responses;               // datagrams parsed
+    int responders;              // distinct providers holding service_name
+    in_addr_t responder[ARY_MAX_RESPONDERS];
+} DiscoveryRequest, *PDiscoveryRequest;
+
+/*
+ * Multicast discovery
+ * - locators join the group on every interface, so hosts that did not join
+ *   never see a query sent to it
+ * - the first round of a discovery goes to the group, later rounds fall back
+ *   to broadcast while no locator has answered
+ * - a group of 'none' broadcasts every round, as older locators require
+*/
+#define SKN_MULTICAST_GROUP   "239.255.48.28"
+#define SKN_MULTICAST_TTL     1         // hops, default gd_i_multicast_ttl
+#define SKN_MAX_MULTICAST_TTL 255
+
+/*
+ * Discovery cache
+ * - small binary file of where services were last found, and the locator
+ *   that answered; read and rewritten whole, replaced by rename()
+ * - clients probe the cached locator by unicast before broadcasting
+*/
+#define SKN_DISCOVERY_CACHE_FILE    "/var/cache/skn_discovery.cache"
+#define SKN_DISCOVERY_CACHE_MAGIC   0x534B4E43  // "SKNC"
+#define SKN_DISCOVERY_CACHE_VERSION 1
+#define SKN_DISCOVERY_CACHE_TTL     1800
+#define SKN_DISCOVERY_PROBE_TIMEOUT 0.25
+#define ARY_MAX_CACHE_ENTRIES       32
+
+typedef struct _discoveryCacheEntry {
+    char name[SZ_CHAR_LABEL];
+    struct in_addr addr;         // the service
+    struct in_addr locator;      // who told us
+    uint16_t port;
+    uint16_t reserved;
+    int64_t expires;             // time() seconds
+} DiscoveryCacheEntry, *PDiscoveryCacheEntry;
+
+typedef struct _discoveryCache {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    DiscoveryCacheEntry entry[ARY_MAX_CACHE_ENTRIES];
+} DiscoveryCache, *PDiscoveryCache;
+
+/*
+ * Shared registry
+ * - the locator's merged registry in a POSIX shared memory segment, read-only
+ *   to every other process on the host; written only by the locator that owns it
+ * - a seqlock guards the entries: sequence is odd while they are written, and a
+ *   reader keeps its copy only when sequence was even and unchanged around it
+*/
+#define SKN_SHARED_REGISTRY_NAME    "/skn_registry"
+#define SKN_SHARED_REGISTRY_MAGIC   0x534B4E52  // "SKNR"
+#define SKN_SHARED_REGISTRY_VERSION 1
+#define SKN_SHARED_REGISTRY_RETRIES 64          // reads overlapping a write, before giving up
+#define ARY_MAX_SHARED_ENTRIES      256
+
+typedef struct _sharedRegistryEntry {
+    char name[SZ_CHAR_LABEL];
+    struct in_addr addr;
+    uint16_t port;
+    uint16_t reserved;
+} SharedRegistryEntry, *PSharedRegistryEntry;
+
+typedef struct _sharedRegistry {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;           // seqlock, odd while the owner writes
+    uint32_t count;
+    int64_t owner;               // locator pid, a dead owner's segment is ignored
+    uint64_t epoch;              // locator epoch and registry version published
+    uint64_t published;
+    SharedRegistryEntry entry[ARY_MAX_SHARED_ENTRIES];
+} SharedRegistry, *PSharedRegistry;
+
+/*
+ * Reverse DNS cache
+ * - keyed by IPv4 address, positive and negative entries expire
+ * - lookups never block; misses are resolved by a background thread
+*/
+#define SKN_RESOLVER_TTL 600
+#define SKN_RESOLVER_NEGATIVE_TTL 60
+#define SKN_RESOLVER_PROBES 8
+
+#define SKN_RESOLVER_EMPTY    0
+#define SKN_RESOLVER_PENDING  1
+#define SKN_RESOLVER_RESOLVED 2
+#define SKN_RESOLVER_FAILED   3
+
+typedef struct _resolverEntry {
+    in_addr_t addr;
+    int    state;
+    time_t expires;
+    char   name[SZ_CHAR_BUFF];
+} ResolverEntry, *PResolverEntry;
+
+typedef struct _nameResolver {
+    char cbName[SZ_CHAR_BUFF];
+    pthread_mutex_t lock;
+    pthread_cond_t  wakeup;
+    pthread_t resolver_thread;
+    long thread_complete;
+    int  shutdown;
+    ResolverEntry entry[ARY_MAX_RESOLVER];
+    in_addr_t queue[ARY_MAX_RESOLVER];  // ring of addresses waiting on getnameinfo()
+    int  q_head;
+    int  q_count;
+    unsigned long hits;                 // resolved names served from cache
+    unsigned long negative_hits;        // known failures served from cache
+    unsigned long misses;               // numeric label returned
+    unsigned long resolved;             // completed lookups
+    unsigned long failed;               // failed lookups
+} NameResolver, *PNameResolver;
+
+/*
+ * Event Manager
+ * - one epoll set per thread; sockets, timerfds and a signalfd are sources
+ * - every set also watches the process wide shutdown eventfd, so one
+ *   write wakes every loop at once
+*/
+#define SKN_EVENT_SOCKET   0
+#define SKN_EVENT_TIMER    1
+#define SKN_EVENT_SIGNAL   2
+#define SKN_EVENT_SHUTDOWN 3
+
+typedef struct _eventSource {
+    int  fd;
+    int  type;
+    int  owned;                      // fd is closed by skn_event_manager_destroy()
+    uint64_t expirations;            // timers: ticks since the last dispatch
+    struct signalfd_siginfo siginfo; // signals: the signal just read
+    int (*handler)(void *pem, void *pes);  // EXIT_SUCCESS keeps the loop running
+    void * context;
+} EventSource, *PEventSource;
+
+typedef struct _eventManager {
+    char cbName[SZ_CHAR_BUFF];
+    int  epoll_fd;
+    int  running;
+    int  count;
+    unsigned long wakeups;           // returns from epoll_wait()
+    EventSource source[ARY_MAX_EVENT_SOURCES];
+} EventManager, *PEventManager;
+
+/*
+ * Batched datagram I/O
+ * - drains up to batch_size datagrams per recvmmsg() and sends all
+ *   queued replies with one sendmmsg(); a batch_size of 1 uses recvmsg/sendto
+*/
+#define SKN_UDP_BATCH_DEFAULT 16
+
+typedef struct _udpBatch {
+    char cbName[SZ_CHAR_BUFF];
+    int  batch_size;
+    int  count;                                   // datagrams from last receive
+    int  replies;                                 // replies queued for next send
+    unsigned long failed;                         // replies their destination refused
+    struct mmsghdr rmsgs[ARY_MAX_BATCH];
+    struct iovec   riov[ARY_MAX_BATCH];
+    struct sockaddr_in raddr[ARY_MAX_BATCH];
+    char rcontrol[ARY_MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+    char request[ARY_MAX_BATCH][SZ_INFO_BUFF];
+    struct mmsghdr smsgs[ARY_MAX_BATCH];
+    struct iovec   siov[ARY_MAX_BATCH];
+} UDPBatch, *PUDPBatch;
+
+/*
+ * Hierarchical timer wheel
+ * - SKN_WHEEL_LEVELS levels of SKN_WHEEL_SLOTS slots, one tick per level 0 slot
+ * - each level's slot covers SKN_WHEEL_SLOTS times the slot below it; a level's
+ *   slot is cascaded down when the level below wraps
+ * - add, remove and each tick are O(1), plus the timers that fire
+*/
+#define SKN_WHEEL_BITS   6
+#define SKN_WHEEL_SLOTS  (1 << SKN_WHEEL_BITS)
+#define SKN_WHEEL_MASK   (SKN_WHEEL_SLOTS - 1)
+#define SKN_WHEEL_LEVELS 3
+#define SKN_WHEEL_SPAN   (1UL << (SKN_WHEEL_BITS * SKN_WHEEL_LEVELS))  // ticks, longer timers are clamped
+
+typedef struct _wheelTimer {
+    struct _wheelTimer *next;
+    struct _wheelTimer *prev;
+    struct _wheelTimer **slot;   // list head holding this timer, NULL when idle
+    unsigned long expires;       // tick
+} WheelTimer, *PWheelTimer;
+
+typedef struct _timerWheel {
+    char cbName[SZ_CHAR_BUFF];
+    unsigned long now;           // ticks advanced so far
+    int pending;
+    PWheelTimer slot[SKN_WHEEL_LEVELS][SKN_WHEEL_SLOTS];
+} TimerWheel, *PTimerWheel;
+
+/*
+ * Leased registry entries
+ * - an ADD registers (name, ip, port) for gd_i_lease seconds; a repeat ADD renews it
+ * - the provider's response is rebuilt from its base plus every live lease
+ * - base entries are held as pinned leases too, so paged replies list them
+*/
+#define SKN_LEASE_TTL      300
+#define SKN_LEASE_TICK     1.0      // seconds per wheel tick
+#define ARY_MAX_LEASES     256
+
+typedef struct _registryLease {
+    WheelTimer timer;            // first, the wheel hands back this pointer
+    int  in_use;
+    int  pinned;                 // a base entry, never expires
+    unsigned long version;       // registry version that added it
+    uint64_t holders;            // bit 0 this locator, bit n+1 gossip peer n
+    uint64_t staged;             // peers whose current sync listed it
+    int  relay_misses;           // relay polls it went unheard
+    char name[SZ_CHAR_LABEL];
+    char ip[SZ_CHAR_LABEL];
+    uint16_t port;
+} RegistryLease, *PRegistryLease;
+
+/*
+ * Paged registry replies
+ * - a "PAGES" request is answered with every entry, split across datagrams
+ *   of at most SKN_REGISTRY_PAGE bytes; "PAGES since=E.V" gets only the
+ *   entries added and removed after version V of epoch E
+ * - each page starts with a header line: version=E.V,page=i/n,op=full|add|del
+ *   then entry lines in the usual text format
+ * - a broadcast or multicast PAGES gets only the first page of the full
+ *   set; the client asks that locator again by unicast for them all
+ * - any other request still gets the single datagram text response
+*/
+#define SKN_PAGES_REQUEST     "PAGES"
+#define SKN_REGISTRY_PAGE     1024     // one datagram, well inside an ethernet frame
+#define SKN_PAGE_HEADER       64       // room reserved for the header line
+#define ARY_MAX_PAGES         64
+#define ARY_MAX_TOMBSTONES    64
+
+typedef struct _registryTombstone {
+    int  in_use;
+    unsigned long version;       // registry version that removed it
+    char name[SZ_CHAR_LABEL];
+    char ip[SZ_CHAR_LABEL];
+    uint16_t port;
+} RegistryTombstone, *PRegistryTombstone;
+
+typedef struct _registryPageHeader {
+    unsigned long epoch;
+    unsigned long version;
+    int  page;                   // 1 based
+    int  pages;
+    char op[8];                  // full | add | del
+    int  body;                   // offset of the first entry line
+} RegistryPageHeader, *PRegistryPageHeader;
+
+/*
+ * Registry replication between locators
+ * - a locator owns its base entries and the ADDs it accepted; its claims
+ *   count is bumped each time that set changes
+ * - every SKN_GOSSIP_INTERVAL it sends each peer "SYNC digest=E.C port=P",
+ *   E.C being the epoch and claims of that peer's entries it holds, and P
+ *   the port it answers locator requests on
+ * - the peer answers "PEERS digest=E.C known=ip:port,...", then, when the
+ *   digest differs, its own entries in pages "digest=E.C,page=i/n|entries"
+ * - a requester on a local subnet becomes a peer of the locator it asks,
+ *   and peers named in known= are added, so a chain of --replicate seeds
+ *   grows into a mesh; a requester further away is answered, but only
+ *   becomes a peer when named by --replicate on both sides
+ * - SYNC is only answered by unicast, and its pages are charged to the
+ *   requester's rate limit
+ * - entries are only served by their owner, so a copy never outlives it;
+ *   a peer silent for SKN_GOSSIP_MISSES rounds has its entries dropped
+*/
+#define SKN_SYNC_REQUEST      "SYNC"
+#define SKN_PEERS_REPLY       "PEERS"
+#define SKN_GOSSIP_INTERVAL   1.0       // seconds between rounds
+#define SKN_GOSSIP_MISSES     3
+#define SKN_GOSSIP_FORGET     30        // rounds before a silent, learned peer is forgotten
+#define ARY_MAX_PEERS         32        // each takes a bit of RegistryLease.holders
+
+typedef struct _gossipPeer {
+    int  in_use;
+    int  seed;                   // from --replicate, never forgotten
+    struct sockaddr_in addr;     // its locator port
+    unsigned long epoch;         // digest of its entries held here, 0.0 for none
+    unsigned long claims;
+    unsigned long staging_epoch; // digest of the pages being received
+    unsigned long staging_claims;
+    uint64_t pages_seen;
+    int  misses;                 // rounds without a PEERS reply
+} GossipPeer, *PGossipPeer;
+
+typedef struct _registryGossip {
+    char cbName[SZ_CHAR_BUFF];
+    int  i_socket;               // worker 0's, SYNC requests go out and replies come back here
+    int  round_fd;
+    GossipPeer peer[ARY_MAX_PEERS];
+    unsigned long rounds;
+    unsigned long applied;       // peer entry sets taken in
+    unsigned long sent;          // datagrams and bytes, requests and replies
+    unsigned long sent_bytes;
+    unsigned long received;
+    unsigned long received_bytes;
+} RegistryGossip, *PRegistryGossip;
+
+/*
+ * Relay mode
+ * - a relay broadcasts "RELAY" on its own segments every --relay seconds and
+ *   holds what the locators there list under SKN_RELAY_HOLDER, so clients
+ *   and relays on other subnets can ask it by unicast
+ * - relayed entries are served to gossip peers as the relay's own, and a
+ *   relay's gossip rounds slow to the same interval, so a WAN link carries
+ *   one digest per peer per interval, and entries only when they changed
+ * - a locator answers RELAY with only the entries it holds itself, in gossip
+ *   pages, so relays on one segment never echo each other's; older locators
+ *   answer with their text response
+ * - each page past the first is charged to the requester's rate limit
+ * - an entry unheard for SKN_RELAY_MISSES polls is dropped
+*/
+#define SKN_RELAY_REQUEST      "RELAY"
+#define SKN_RELAY_MIN_INTERVAL 5         // seconds, the fastest a relay polls
+#define SKN_MAX_RELAY_INTERVAL 3600
+#define SKN_RELAY_MISSES       2
+#define SKN_RELAY_HOLDER       (1ULL << 63)   // RegistryLease.holders bit of the local segment
+
+typedef struct _registryRelay {
+    char cbName[SZ_CHAR_BUFF];
+    int  i_socket;               // worker 0's, polls go out and answers come back here
+    int  poll_fd;
+    unsigned long polls;
+    unsigned long answers;       // datagrams heard back
+    unsigned long added;         // entries first heard
+    unsigned long dropped;       // entries no longer heard
+} RegistryRelay, *PRegistryRelay;
+
+/*
+ * Binary wire format
+ * - optional; a message starting with SKN_WIRE_MAGIC is binary, anything else is text
+ * - header: magic, version, type, count
+ * - registry entry: IPv4 address (4), port (2), name length (1), name
+ * - query, message and status: length (2), then text; status adds its code (2) first
+ * - locators answer a binary query in binary, display services advertise
+ *   SKN_WIRE_ADVERT in their text reply before a client switches over
+*/
+#define SKN_WIRE_MAGIC        0xB5      // never the first byte of a text message
+#define SKN_WIRE_VERSION      1
+#define SKN_WIRE_HEADER       4
+#define SKN_WIRE_ENTRY        7         // fixed part of a registry entry
+#define SKN_WIRE_QUERY        1         // registry request, text inside
+#define SKN_WIRE_REGISTRY     2         // registry entries
+#define SKN_WIRE_MESSAGE      3         // display text
+#define SKN_WIRE_STATUS       4         // display reply, code and text
+#define SKN_WIRE_ADVERT       "wire=1"
+
+#define SKN_WIRE_TEXT         0         // gd_i_wire values
+#define SKN_WIRE_BINARY       1
+
+/*
+ * Known-answer queries
+ * - "QUERY want=<name> known=<ip>:<port>,<ip>:<port>" asks for the entries
+ *   named want, or every entry without it, less the ones listed as known
+ * - a responder with nothing left to send stays silent
+ * - replies to broadcast requests are held back a random 0..gd_i_jitter ms,
+ *   so a subnet of responders does not answer in the same instant
+ * - older responders take a QUERY as any other request, and answer in full
+ * - "FIND name=<name>" is the filtered lookup of one service; a trailing
+ *   '*' matches every name with that prefix, and known= is taken as well
+*/
+#define SKN_QUERY_REQUEST     "QUERY"
+#define SKN_FIND_REQUEST      "FIND"
+#define SKN_REPLY_JITTER      50        // ms, default gd_i_jitter
+#define SKN_MAX_JITTER        1000
+#define SKN_QUERY_ROUNDS      3         // broadcasts per discovery, at 0, 1/4 and 1/2 of its timeout
+#define ARY_MAX_KNOWN         16
+
+typedef struct _registryQuery {
+    char want[SZ_CHAR_LABEL];    // empty wants every entry
+    int  prefix;                 // want matches the start of a name
+    int  known_count;
+    in_addr_t known_addr[ARY_MAX_KNOWN];
+    uint16_t known_port[ARY_MAX_KNOWN];
+} RegistryQuery, *PRegistryQuery;
+
+/*
+ * RegistryView
+ * - a client's copy of one locator's registry, kept current by
+ *   service_registry_view_refresh() asking for changes since its version
+*/
+typedef struct _registryView {
+    char cbName[SZ_CHAR_BUFF];
+    PServiceRegistry psr;
+    struct in_addr locator;      // zero until the first reply, then only this one is asked
+    unsigned long epoch;
+    unsigned long version;
+    int  pages;                  // datagrams taken by the last refresh
+    int  bytes;                  // payload bytes taken by the last refresh
+    int  changes;                // entries added or removed by the last refresh
+} RegistryView, *PRegistryView;
+
+/*
+ * Per-source rate limiting
+ * - a token bucket for each source address, in a fixed table hashed by
+ *   address; the least recently seen source gives up its slot when full
+ * - checked before a datagram is decoded, logged or resolved, so a flood
+ *   costs a hash probe per datagram
+ * - a shed source is sent SKN_RATE_BUSY_REPLY at most once a second
+ * - a reply of several datagrams is charged a token for each one after the
+ *   first, so a spoofed source cannot draw pages faster than the rate
+*/
+#define SKN_RATE_LIMIT          20       // datagrams/sec per source, default gd_i_rate_limit
+#define SKN_MAX_RATE_LIMIT      100000
+#define SKN_RATE_BURST          2.0      // bucket depth, in seconds of rate
+#define SKN_RATE_BUSY_INTERVAL  1.0
+#define SKN_RATE_BUSY_REPLY     "503 Busy"
+#define ARY_MAX_RATE_SOURCES    1024     // power of two, also the hash size
+
+#define SKN_RATE_ADMITTED 0
+#define SKN_RATE_SHED     1
+#define SKN_RATE_BUSY     2              // shed, and due a busy reply
+
+typedef struct _rateSource {
+    in_addr_t addr;
+    double tokens;
+    double stamp;                // monotonic seconds tokens were counted at
+    double busy;                 // monotonic seconds of the last busy reply
+    int  hash_next;              // chain of the address's hash slot, -1 ends it
+    int  lru_prev;               // toward the most recently seen, -1 at the head
+    int  lru_next;               // toward the least recently seen, -1 at the tail
+} RateSource, *PRateSource;
+
+typedef struct _rateLimiter {
+    char cbName[SZ_CHAR_BUFF];
+    double rate;                 // tokens added per second
+    double burst;                // most tokens a source holds
+    int  hash[ARY_MAX_RATE_SOURCES];  // first source of each slot, -1 when empty
+    RateSource source[ARY_MAX_RATE_SOURCES];
+    int  used;
+    int  lru_head;
+    int  lru_tail;
+    unsigned long admitted;
+    unsigned long shed;
+    unsigned long busy;          // busy replies sent
+    unsigned long evicted;       // sources dropped for a newer one
+    unsigned long charged;       // tokens taken for the extra datagrams of replies
+} RateLimiter, *PRateLimiter;
+
+/*
+ * Locator Service worker pool
+ * - each worker owns a SO_REUSEPORT socket on SKN_FIND_RPI_PORT
+ * - all workers share the provider's read-mostly response
+*/
+#define SKN_PROVIDER_STATS_INTERVAL 10.0
+#define ARY_MAX_DEFERRED 64
+
+typedef struct _deferredReply {
+    struct timespec due;             // CLOCK_MONOTONIC
+    struct sockaddr_in addr;
+    int  len;
+    char data[SKN_REGISTRY_PAGE];
+} DeferredReply, *PDeferredReply;
+
+typedef struct _providerWorker {
+    char cbName[SZ_CHAR_BUFF];
+    int  index;
+    int  i_socket;
+    pthread_t worker_thread;
+    long thread_complete;
+    unsigned long requests;          // total requests answered
+    unsigned long interval_requests; // requests answered since interval_start
+    unsigned long sharded;           // broadcast copies left for a sibling worker
+    unsigned long datagrams;         // reply datagrams sent, paged replies take several
+    unsigned long failed;            // replies lost to a send their destination refused
+    unsigned long suppressed;        // queries left unanswered, nothing new to say
+    unsigned long jittered;          // replies held back before sending
+    unsigned long interval_shed;     // datagrams shed since interval_start
+    PRateLimiter limiter;            // this worker's sources, NULL when unlimited
+    PUDPBatch pb;
+    PDeferredReply deferred;         // jittered replies waiting on jitter_fd
+    int  deferred_count;
+    int  jitter_fd;
+    unsigned int seed;               // rand_r() state for the reply delay
+    struct timeval start;
+    struct timeval interval_start;
+    void * psp;                      // owning PServiceProvider
+} ProviderWorker, *PProviderWorker;
+
+typedef struct _serviceProvider {
+    char cbName[SZ_CHAR_BUFF];
+    pthread_rwlock_t rwlock;         // guards response, pages, base, leases, wheel and gossip
+    char response[SZ_COMM_BUFF];
+    int  response_len;
+    char base[SZ_COMM_BUFF];         // entries given at startup, never expire
+    char separator;
+    unsigned long epoch;             // start time, so a restarted locator's versions never match
+    unsigned long version;           // bumped by every entry added or removed
+    unsigned long horizon;           // oldest version a delta can still be built from
+    RegistryLease lease[ARY_MAX_LEASES];
+    RegistryTombstone tombstone[ARY_MAX_TOMBSTONES];
+    int  tombstone_next;
+    char page[ARY_MAX_PAGES][SKN_REGISTRY_PAGE];  // full paged reply, rebuilt with response
+    int  page_len[ARY_MAX_PAGES];
+    int  pages;
+    char binary[SKN_REGISTRY_PAGE];  // binary reply, rebuilt with response
+    int  binary_len;
+    TimerWheel wheel;
+    int  tick_fd;                    // worker 0's wheel timer, armed while leases are live
+    unsigned long registrations;
+    unsigned long renewals;
+    unsigned long expirations;
+    unsigned long rejected;
+    in_addr_t advertised;            // default address in the generated base, 0 for -m
+    unsigned long claims;            // bumped when the entries this locator owns change
+    RegistryGossip gossip;
+    RegistryRelay relay;
+    PSharedRegistry shared;          // segment published on every rebuild, NULL when off
+    unsigned long interfaces;        // interface cache generation it was taken from
+    int  workers;
+    sig_atomic_t shutdown;           // set by a QUIT! request
+    ProviderWorker worker[ARY_MAX_WORKERS];
+} ServiceProvider, *PServiceProvider;
+
 typedef struct _serviceRequest {
 	char cbName[SZ_CHAR_BUFF];
 	PRegistryEntry pre;
 	char request[SZ_INFO_BUFF];
 	char response[SZ_INFO_BUFF];
 	int socket;
+	int wire;                    // SKN_WIRE_BINARY once the service advertised it
 } ServiceRequest, *PServiceRequest;
 
 /*
@@ -290,11 +1009,95 @@ typedef struct _DISPLAY_LINE {
     char ch_display_msg[SZ_INFO_BUFF];
     int  msg_len;
     int  display_pos;
+    double scroll_carry;   // part of a cell scrolled, not yet shown
     int  scroll_enabled;
     void * next;
     void * prev;
 } DisplayLine, *PDisplayLine;
 
+/*
+ * Display render pacing
+ * - frames run at a fixed --frame-rate off a CLOCK_MONOTONIC timerfd, so
+ *   the cadence no longer depends on the row count or on write latency
+ * - each line scrolls by its row's --scroll-speed times the time the frame
+ *   covers; ticks the render loop missed are caught up in that one step
+ * - jitter is how late a frame starts against its own schedule
+*/
+#define SKN_DISPLAY_FRAME_RATE    10        // frames a second
+#define SKN_MAX_FRAME_RATE        60
+#define SKN_DISPLAY_SCROLL_SPEED  5.5       // cells a second, one cell every 0.18s
+#define SKN_MAX_SCROLL_SPEED      60.0
+#define SKN_DISPLAY_HOST_INTERVAL 900.0   // refresh host info lines, fifteen minutes
+
+typedef struct _frameScheduler {
+    char cbName[SZ_CHAR_BUFF];
+    double interval;             // seconds a frame
+    struct timespec start;       // when tick zero was due
+    uint64_t ticks;              // timer ticks since start
+    unsigned long frames;        // frames drawn
+    unsigned long missed;        // ticks caught up by a later frame
+    double jitter_sum;           // seconds late, over every frame
+    double jitter_max;
+} FrameScheduler, *PFrameScheduler;
+
+/*
+ * LCD shadow framebuffer
+ * - shadow is what the LCD shows, frame is what this frame should show;
+ *   only runs of cells that differ are sent
+ * - two runs on a row are sent as one when the unchanged cells between
+ *   cost no more than the cursor move they save, SKN_FB_MOVE_COST_*
+ * - the cursor is only moved when a run does not start where it stands;
+ *   rows are not contiguous in the LCD's memory, so a new row always moves
+ * - when the device drops cells the shadow is filled with SKN_FB_UNKNOWN,
+ *   a cell no frame holds, so the next frame redraws the whole screen
+*/
+#define SKN_FB_MOVE_COST_I2C     1   // cells a cursor move costs: one command byte
+#define SKN_FB_MOVE_COST_SERIAL  4   // 0xFE 0x47 col row
+#define SKN_FB_UNKNOWN           0   // frames are padded with blanks, never 0
+
+typedef struct _lcdFrameBuffer {
+    char cbName[SZ_CHAR_BUFF];
+    char shadow[ARY_MAX_LCD_ROWS][ARY_MAX_LCD_COLS];
+    char frame[ARY_MAX_LCD_ROWS][ARY_MAX_LCD_COLS];
+    int  move_cost;
+    int  cursor_row;             // where the LCD's cursor stands, -1 unknown
+    int  cursor_col;
+    unsigned long frames;
+    unsigned long cells;         // cells sent
+    unsigned long moves;         // cursor moves sent
+    unsigned long unchanged;     // frames that sent nothing
+    unsigned long deferred;      // frames held back, the device still busy
+    unsigned long invalidated;   // times the device dropped cells, the screen redrawn
+} LCDFrameBuffer, *PLCDFrameBuffer;
+
+/*
+ * Display message ring
+ * - the consumer thread publishes each message into a pre-allocated slot,
+ *   the render loop takes them at the start of a frame; neither one waits
+ * - when full, SKN_RING_DROP_OLDEST gives the oldest waiting slot to the
+ *   new message, SKN_RING_DROP_NEWEST turns the new message away
+ * - head is only written by the producer; tail by the consumer, and by
+ *   the producer when it drops the oldest, so both take it by CAS
+*/
+#define ARY_MAX_DM_MESSAGES  32    // power of two
+#define SKN_RING_DROP_OLDEST 0
+#define SKN_RING_DROP_NEWEST 1
+#define SKN_CACHE_LINE       64
+
+typedef struct _displayRing {
+    char cbName[SZ_CHAR_BUFF];
+    int  policy;
+    uint32_t head;               // next slot written
+    uint32_t high_water;         // most messages ever waiting
+    unsigned long enqueued;      // producer's counters, beside head
+    unsigned long dropped;
+    char head_pad[SKN_CACHE_LINE];  // keeps the two ends off one cache line
+    uint32_t tail;               // next slot read
+    unsigned long consumed;
+    char tail_pad[SKN_CACHE_LINE];
+    char slot[ARY_MAX_DM_MESSAGES][SZ_INFO_BUFF];
+} DisplayRing, *PDisplayRing;
+
 typedef struct _DISPLAY_MANAGER {
 	char cbName[SZ_CHAR_BUFF];
     char ch_welcome_msg[SZ_INFO_BUFF];
@@ -309,7 +1112,12 @@ typedef struct _DISPLAY_MANAGER {
     pthread_t dm_thread;   // new message thread
     long thread_complete;
     int  i_socket;
+    PUDPBatch pb;   // consumer thread's receive batch
+    PRateLimiter limiter;  // consumer thread's sources, NULL when unlimited
     LCDDevice lcd;  // selected device
+    DisplayRing ring;  // consumer thread to render loop
+    LCDFrameBuffer fb;  // render loop's copy of the LCD
+    FrameScheduler frame;  // render loop's pacing
 } DisplayManager, *PDisplayManager;
 
 
@@ -0,0 +1,191 @@
+/*
+ * skn_discovery_cache.c
+ *
+ *  Warm start for the display clients.
+ *  - remembers where each service was found, and which locator answered
+ *  - a cached service is confirmed with one unicast probe; broadcast only on a miss
+ */
+
+#include "skn_network_helpers.h"
+
+static int skn_discovery_cache_load(PDiscoveryCache pdc);
+static void skn_discovery_cache_save(PDiscoveryCache pdc);
+static PDiscoveryCacheEntry skn_discovery_cache_find(PDiscoveryCache pdc, const char *name, time_t now);
+static void skn_discovery_cache_store(PDiscoveryCache pdc, PRegistryEntry pre, struct in_addr locator, time_t now);
+
+/**
+ * skn_discovery_cache_load()
+ * - reads the cache file; a missing, short or foreign file loads as empty
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when caching is off
+ */
+static int skn_discovery_cache_load(PDiscoveryCache pdc) {
+    int fd = 0;
+    ssize_t rLen = 0;
+
+    memset(pdc, 0, sizeof(DiscoveryCache));
+    if ((gd_pch_discovery_cache == NULL) || (strcmp(gd_pch_discovery_cache, "none") == 0)) {
+        return EXIT_FAILURE;
+    }
+
+    fd = open(gd_pch_discovery_cache, O_RDONLY | O_CLOEXEC);
+    if (fd != PLATFORM_ERROR) {
+        rLen = read(fd, pdc, sizeof(DiscoveryCache));
+        close(fd);
+    }
+    if ((rLen != sizeof(DiscoveryCache)) ||
+        (pdc->magic != SKN_DISCOVERY_CACHE_MAGIC) ||
+        (pdc->version != SKN_DISCOVERY_CACHE_VERSION) ||
+        (pdc->count > ARY_MAX_CACHE_ENTRIES)) {
+        memset(pdc, 0, sizeof(DiscoveryCache));
+    }
+    pdc->magic = SKN_DISCOVERY_CACHE_MAGIC;
+    pdc->version = SKN_DISCOVERY_CACHE_VERSION;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_discovery_cache_save()
+ * - writes a private temp file and renames it over the cache, so clients
+ *   started together never read a partial file
+ */
+static void skn_discovery_cache_save(PDiscoveryCache pdc) {
+    char tmpName[SZ_INFO_BUFF];
+    ssize_t wLen = 0;
+    int fd = 0;
+
+    snprintf(tmpName, sizeof(tmpName), "%s.%d", gd_pch_discovery_cache, (int) getpid());
+    fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_DEBUG, "DiscoveryCache: open(%s) Failure code=%d, etext=%s", tmpName, errno, strerror(errno));
+        return;
+    }
+    wLen = write(fd, pdc, sizeof(DiscoveryCache));
+    close(fd);
+
+    if ((wLen != sizeof(DiscoveryCache)) || (rename(tmpName, gd_pch_discovery_cache) == PLATFORM_ERROR)) {
+        skn_logger(SD_DEBUG, "DiscoveryCache: save to %s Failure code=%d, etext=%s", gd_pch_discovery_cache, errno, strerror(errno));
+        unlink(tmpName);
+    }
+}
+
+static PDiscoveryCacheEntry skn_discovery_cache_find(PDiscoveryCache pdc, const char *name, time_t now) {
+    int index = 0;
+
+    for (index = 0; index < (int) pdc->count; index++) {
+        if ((pdc->entry[index].expires > now) && (strcmp(pdc->entry[index].name, name) == 0)) {
+            return &pdc->entry[index];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * skn_discovery_cache_store()
+ * - replaces the entry for this name, else takes a free or expired slot,
+ *   else the one closest to expiry
+ */
+static void skn_discovery_cache_store(PDiscoveryCache pdc, PRegistryEntry pre, struct in_addr locator, time_t now) {
+    PDiscoveryCacheEntry pce = NULL;
+    int index = 0;
+
+    for (index = 0; index < (int) pdc->count; index++) {
+        if (strcmp(pdc->entry[index].name, pre->name) == 0) {
+            pce = &pdc->entry[index];
+            break;
+        }
+        if ((pce == NULL) || (pdc->entry[index].expires < pce->expires)) {
+            pce = &pdc->entry[index];
+        }
+    }
+    if ((index == (int) pdc->count) && (pdc->count < ARY_MAX_CACHE_ENTRIES)) {
+        pce = &pdc->entry[pdc->count++];
+    }
+
+    memset(pce, 0, sizeof(DiscoveryCacheEntry));
+    strncpy(pce->name, pre->name, sizeof(pce->name) - 1);
+    pce->addr = pre->addr;
+    pce->locator = locator;
+    pce->port = pre->port;
+    pce->expires = (int64_t) now + SKN_DISCOVERY_CACHE_TTL;
+}
+
+/**
+ * service_registry_discover_cached()
+ * - service_registry_discover() with a warm start: when pdr wants one
+ *   provider of a cached service, the locator that last answered is asked
+ *   by unicast, and a discovery follows only if that probe goes unanswered
+ * - the probe runs its own DiscoveryRequest, so on_response sees that one
+ * - logs the time taken and the datagrams sent
+ *
+ * - Returns Populated Registry
+ */
+PServiceRegistry service_registry_discover_cached(int i_socket, char *request, PDiscoveryRequest pdr) {
+    PServiceRegistry psr = NULL;
+    PRegistryEntry pre = NULL;
+    PDiscoveryCacheEntry pce = NULL;
+    DiscoveryCache dc;
+    DiscoveryRequest probe;
+    struct timeval start;
+    struct in_addr locator;
+    const char *outcome = "off";
+    time_t now = time(NULL);
+    int cached = 0;
+
+    gettimeofday(&start, NULL);
+    cached = ((pdr->service_name != NULL) && (pdr->min_responders == 1) &&
+              (skn_discovery_cache_load(&dc) == EXIT_SUCCESS));
+
+    if (cached) {
+        outcome = "miss";
+        pce = skn_discovery_cache_find(&dc, pdr->service_name, now);
+    }
+    if (pce != NULL) {
+        service_registry_discovery_init(&probe, pdr->service_name, 1, SKN_DISCOVERY_PROBE_TIMEOUT);
+        probe.unicast = pce->locator;
+        probe.on_response = pdr->on_response;
+        probe.context = pdr->context;
+
+        psr = service_registry_discover(i_socket, request, &probe);
+        pdr->probes += probe.probes;
+        pdr->responses += probe.responses;
+
+        pre = service_registry_find_entry(psr, (char *) pdr->service_name);
+        if ((probe.responders > 0) && (pre != NULL)) {
+            pdr->responders = probe.responders;
+            pdr->responder[0] = probe.responder[0];
+            outcome = "hit";
+        } else {
+            skn_logger(SD_NOTICE, "DiscoveryCache: %s did not confirm %s, broadcasting", inet_ntoa(pce->locator), pdr->service_name);
+            pce->expires = 0;
+            service_registry_destroy(psr);
+            psr = NULL;
+            pre = NULL;
+            outcome = "stale";
+        }
+    }
+
+    if (psr == NULL) {
+        psr = service_registry_discover(i_socket, request, pdr);
+        if (pdr->service_name != NULL) {
+            pre = service_registry_find_entry(psr, (char *) pdr->service_name);
+        }
+    }
+
+    if (cached) {
+        if ((pre != NULL) && (pdr->responders > 0)) {
+            locator.s_addr = pdr->responder[0];
+            skn_discovery_cache_store(&dc, pre, locator, now);
+        }
+        skn_discovery_cache_save(&dc);
+    }
+
+    skn_logger(SD_NOTICE, "Discovery: %s %s in %1.3fs, %d multicasts, %d broadcasts, %d probes, cache %s",
+               (pdr->service_name != NULL ? pdr->service_name : "any service"),
+               (pre != NULL ? "found" : "not found"),
+               skn_duration_in_milliseconds(&start, NULL), pdr->multicasts, pdr->broadcasts, pdr->probes, outcome);
+
+    return psr;
+}
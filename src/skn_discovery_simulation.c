@@ -0,0 +1,470 @@
+/**
+ * skn_discovery_simulation.c
+ * - Developer tool, not installed
+ *
+ * Simulates one discovery against many responders over loopback.  Each
+ * responder owns a socket and the entries of one Raspberry Pi; a broadcast
+ * is modelled by sending the request to every responder.  The requester has
+ * a small receive buffer and a cost per reply, as a Pi resolving names does,
+ * so a reply storm overflows it the way it does on a large subnet.
+ *
+ * Scenarios run in turn:
+ *   storm  - legacy request, every responder answers at once
+ *   jitter - legacy request, replies spread over the jitter window
+ *   query  - QUERY in rounds listing the answers heard, jittered; a round
+ *            is skipped once they no longer fit one QUERY
+ *   want   - as query, for lcd_display_service only
+ *
+ * Reported per scenario: replies sent, received in time, late, dropped by
+ * the requester, duplicates, and the responders found of those expected.
+ *
+ * cmdline: ./skn_discovery_simulation [responders] [jitter ms] [rcvbuf bytes] [cost us]
+*/
+
+#include "skn_network_helpers.h"
+
+#define SIM_MAX_RESPONDERS 1024
+#define SIM_WINDOW_MS      1000     // discovery timeout
+#define SIM_LCD_EVERY      10       // one responder in ten holds the display service
+
+typedef struct _simResponder {
+    int  fd;
+    uint16_t port;               // loopback port it listens on
+    char ip[INET_ADDRSTRLEN];    // address it advertises
+    int  has_lcd;
+} SimResponder, *PSimResponder;
+
+typedef struct _simPending {
+    struct timespec due;
+    struct sockaddr_in to;
+    int  fd;
+    int  len;
+    char data[SKN_REGISTRY_PAGE];
+} SimPending, *PSimPending;
+
+typedef struct _simScenario {
+    const char *name;
+    int  query;                  // send QUERY rather than the legacy text
+    int  jitter;                 // ms
+    int  rounds;
+    const char *want;
+} SimScenario, *PSimScenario;
+
+typedef struct _simBank {
+    char cbName[SZ_CHAR_BUFF];
+    int  count;
+    PSimResponder responder;
+    struct pollfd *pfd;
+    PSimPending pending;
+    int  pending_count;
+    int  pending_max;
+    int  jitter;
+    unsigned int seed;
+    volatile int stop;
+    unsigned long sent;
+    unsigned long suppressed;
+} SimBank, *PSimBank;
+
+typedef struct _simResult {
+    int  received;
+    int  late;
+    int  duplicates;
+    int  found;
+    int  expected;
+    int  requests;
+} SimResult, *PSimResult;
+
+static long long sim_ns_until(struct timespec *pdue) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((long long) (pdue->tv_sec - now.tv_sec) * 1000000000LL) + (pdue->tv_nsec - now.tv_nsec);
+}
+
+static void sim_add_ms(struct timespec *pts, int ms) {
+    pts->tv_sec += ms / 1000;
+    pts->tv_nsec += (long) (ms % 1000) * 1000000L;
+    if (pts->tv_nsec >= 1000000000L) {
+        pts->tv_sec++;
+        pts->tv_nsec -= 1000000000L;
+    }
+}
+
+/*
+ * busy waits, a requester that is slow to take each reply */
+static void sim_spin_us(int us) {
+    struct timespec due;
+
+    clock_gettime(CLOCK_MONOTONIC, &due);
+    due.tv_nsec += (long) us * 1000L;
+    while (due.tv_nsec >= 1000000000L) {
+        due.tv_sec++;
+        due.tv_nsec -= 1000000000L;
+    }
+    while (sim_ns_until(&due) > 0)
+        ;
+}
+
+static int sim_socket(int rcvbuf) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+
+    if (fd == PLATFORM_ERROR) {
+        return PLATFORM_ERROR;
+    }
+    if ((rcvbuf > 0) && (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) == PLATFORM_ERROR)) {
+        close(fd);
+        return PLATFORM_ERROR;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == PLATFORM_ERROR) ||
+        (getsockname(fd, (struct sockaddr *) &addr, &len) == PLATFORM_ERROR)) {
+        close(fd);
+        return PLATFORM_ERROR;
+    }
+
+    return fd;
+}
+
+/**
+ * sim_reply()
+ * - what responder would answer to request, in the locator's text format
+ *
+ * - returns length | zero to stay silent
+ */
+static int sim_reply(PSimResponder prs, const char *request, char *reply, int size) {
+    RegistryQuery rq;
+    struct in_addr addr;
+    int len = 0, query = (service_registry_query_parse(request, &rq) == EXIT_SUCCESS);
+
+    inet_pton(AF_INET, prs->ip, &addr);
+    if (!query || service_registry_query_wants(&rq, "rpi_locator_service", addr.s_addr, SKN_FIND_RPI_PORT)) {
+        len += snprintf(&reply[len], size - len, "name=rpi_locator_service,ip=%s,port=%d|", prs->ip, SKN_FIND_RPI_PORT);
+    }
+    if (prs->has_lcd &&
+        (!query || service_registry_query_wants(&rq, "lcd_display_service", addr.s_addr, SKN_RPI_DISPLAY_SERVICE_PORT))) {
+        len += snprintf(&reply[len], size - len, "name=lcd_display_service,ip=%s,port=%d|", prs->ip, SKN_RPI_DISPLAY_SERVICE_PORT);
+    }
+
+    return len;
+}
+
+static void sim_send_due(PSimBank psb) {
+    PSimPending pp = NULL;
+    int index = 0;
+
+    while (index < psb->pending_count) {
+        pp = &psb->pending[index];
+        if (sim_ns_until(&pp->due) > 0) {
+            index++;
+            continue;
+        }
+        if (sendto(pp->fd, pp->data, pp->len, 0, (struct sockaddr *) &pp->to, sizeof(pp->to)) > 0) {
+            psb->sent++;
+        }
+        if (index != --psb->pending_count) {
+            *pp = psb->pending[psb->pending_count];
+        }
+    }
+}
+
+/**
+ * sim_responders()
+ * - thread answering for every responder, each reply sent at once or
+ *   held for its own random delay
+ */
+static void * sim_responders(void *ptr) {
+    PSimBank psb = (PSimBank) ptr;
+    PSimPending pp = NULL;
+    struct sockaddr_in from;
+    socklen_t len = sizeof(from);
+    char request[SZ_INFO_BUFF];
+    char reply[SKN_REGISTRY_PAGE];
+    long long wait = 0, next = 0;
+    int index = 0, rlen = 0, delay = 0, timeout = 0;
+
+    while (psb->stop == 0) {
+        timeout = 10;
+        for (index = 0; index < psb->pending_count; index++) {
+            next = sim_ns_until(&psb->pending[index].due);
+            if ((index == 0) || (next < wait)) {
+                wait = next;
+            }
+        }
+        if (psb->pending_count > 0) {
+            timeout = (wait <= 0 ? 0 : (int) ((wait + 999999LL) / 1000000LL));
+        }
+
+        if (poll(psb->pfd, psb->count, timeout) > 0) {
+            for (index = 0; index < psb->count; index++) {
+                if ((psb->pfd[index].revents & POLLIN) == 0) {
+                    continue;
+                }
+                len = sizeof(from);
+                rlen = recvfrom(psb->pfd[index].fd, request, sizeof(request) - 1, MSG_DONTWAIT, (struct sockaddr *) &from, &len);
+                if (rlen <= 0) {
+                    continue;
+                }
+                request[rlen] = 0;
+                if ((rlen = sim_reply(&psb->responder[index], request, reply, sizeof(reply))) == 0) {
+                    psb->suppressed++;
+                    continue;
+                }
+                delay = (psb->jitter > 0 ? (int) (rand_r(&psb->seed) % (unsigned int) (psb->jitter + 1)) : 0);
+                if ((delay == 0) || (psb->pending_count >= psb->pending_max)) {
+                    if (sendto(psb->pfd[index].fd, reply, rlen, 0, (struct sockaddr *) &from, sizeof(from)) > 0) {
+                        psb->sent++;
+                    }
+                    continue;
+                }
+                pp = &psb->pending[psb->pending_count++];
+                clock_gettime(CLOCK_MONOTONIC, &pp->due);
+                sim_add_ms(&pp->due, delay);
+                pp->to = from;
+                pp->fd = psb->pfd[index].fd;
+                pp->len = rlen;
+                memcpy(pp->data, reply, rlen);
+            }
+        }
+        sim_send_due(psb);
+    }
+
+    return NULL;
+}
+
+/*
+ * one datagram, request, to every responder */
+static int sim_broadcast(int fd, PSimBank psb, const char *request) {
+    struct sockaddr_in to;
+    int index = 0, sent = 0;
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (index = 0; index < psb->count; index++) {
+        to.sin_port = htons(psb->responder[index].port);
+        if (sendto(fd, request, strlen(request), 0, (struct sockaddr *) &to, sizeof(to)) > 0) {
+            sent++;
+        }
+    }
+
+    return sent;
+}
+
+static int sim_record(PRegistryRecord prec, void *context) {
+    char name[SZ_CHAR_LABEL], ip[SZ_CHAR_LABEL], port[SZ_CHAR_LABEL];
+
+    if ((prec->name.len >= SZ_CHAR_LABEL) || (prec->ip.len >= SZ_CHAR_LABEL) || (prec->port.len >= SZ_CHAR_LABEL)) {
+        return EXIT_FAILURE;
+    }
+    snprintf(name, sizeof(name), "%.*s", prec->name.len, prec->name.start);
+    snprintf(ip, sizeof(ip), "%.*s", prec->ip.len, prec->ip.start);
+    snprintf(port, sizeof(port), "%.*s", prec->port.len, prec->port.start);
+
+    service_registry_entry_create((PServiceRegistry) context, name, ip, port, NULL);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * sim_discover()
+ * - the requester: rounds at 0, 1/4 and 1/2 of the window as
+ *   service_registry_discover() does, reading replies until the window ends
+ */
+static void sim_discover(int fd, PSimBank psb, PSimScenario pss, int cost, PSimResult pres) {
+    PServiceRegistry psr = service_registry_create();
+    struct sockaddr_in from;
+    socklen_t len = sizeof(from);
+    struct timespec start, deadline, next;
+    struct pollfd pfd;
+    char request[SZ_INFO_BUFF - SKN_WIRE_HEADER - 4];
+    char response[SKN_REGISTRY_PAGE + 1];
+    char *heard = calloc(psb->count, 1);
+    long long left = 0;
+    int round = 0, rlen = 0, index = 0, before = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    deadline = start;
+    sim_add_ms(&deadline, SIM_WINDOW_MS);
+    next = start;
+
+    while ((left = sim_ns_until(&deadline)) > 0) {
+        if ((round < pss->rounds) && (sim_ns_until(&next) <= 0)) {
+            if (pss->query) {
+                rlen = service_registry_query_request(request, sizeof(request), pss->want, (round == 0 ? NULL : psr));
+            } else {
+                rlen = snprintf(request, sizeof(request), "%s", "Raspberry Pi where are you?");
+            }
+            if (rlen > 0) {      // a round whose heard set does not fit a QUERY is skipped
+                sim_broadcast(fd, psb, request);
+                pres->requests++;
+            }
+            round++;
+            next = start;
+            sim_add_ms(&next, SIM_WINDOW_MS >> (pss->rounds - round));
+        }
+        if ((round < pss->rounds) && (sim_ns_until(&next) < left)) {
+            left = sim_ns_until(&next);
+        }
+
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, (left <= 0 ? 0 : (int) ((left + 999999LL) / 1000000LL))) <= 0) {
+            continue;
+        }
+        len = sizeof(from);
+        if ((rlen = recvfrom(fd, response, sizeof(response) - 1, MSG_DONTWAIT, (struct sockaddr *) &from, &len)) <= 0) {
+            continue;
+        }
+        response[rlen] = 0;
+        pres->received++;
+        sim_spin_us(cost);
+
+        before = psr->count;
+        service_registry_message_scan(response, rlen, sim_record, psr, NULL);
+        if (psr->count == before) {
+            pres->duplicates++;
+        }
+        for (index = 0; index < psb->count; index++) {
+            if (psb->responder[index].port == ntohs(from.sin_port)) {
+                heard[index] = 1;
+                break;
+            }
+        }
+    }
+
+    /* replies still arriving were sent too late for this discovery */
+    usleep((pss->jitter + 20) * 1000);
+    while (recv(fd, response, sizeof(response), MSG_DONTWAIT) > 0) {
+        pres->late++;
+    }
+
+    for (index = 0; index < psb->count; index++) {
+        if ((pss->want == NULL) || psb->responder[index].has_lcd) {
+            pres->expected++;
+            pres->found += heard[index];
+        }
+    }
+
+    free(heard);
+    service_registry_destroy(psr);
+}
+
+static int sim_scenario(PSimBank psb, PSimScenario pss, int rcvbuf, int cost) {
+    SimResult res;
+    pthread_t thread;
+    int fd = sim_socket(rcvbuf), dropped = 0;
+
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "Simulation: requester socket Failure code=%d, etext=%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    memset(&res, 0, sizeof(res));
+    psb->sent = psb->suppressed = 0;
+    psb->pending_count = 0;
+    psb->jitter = pss->jitter;
+    psb->stop = 0;
+    if (pthread_create(&thread, NULL, sim_responders, psb) != 0) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    sim_discover(fd, psb, pss, cost, &res);
+
+    psb->stop = 1;
+    pthread_join(thread, NULL);
+    close(fd);
+
+    dropped = (int) psb->sent - res.received - res.late;
+    skn_logger(" ", "%-7s %8d %6lu %6lu %8d %5d %7d %5d %5d/%d",
+               pss->name, res.requests, psb->sent, psb->suppressed, res.received, res.late,
+               (dropped > 0 ? dropped : 0), res.duplicates, res.found, res.expected);
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[]) {
+    SimScenario scenario[] = {
+        { "storm",  0, 0, 1, NULL },
+        { "jitter", 0, SKN_REPLY_JITTER, 1, NULL },
+        { "query",  1, SKN_REPLY_JITTER, SKN_QUERY_ROUNDS, NULL },
+        { "want",   1, SKN_REPLY_JITTER, SKN_QUERY_ROUNDS, "lcd_display_service" }
+    };
+    SimBank bank;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int responders = 200, jitter = SKN_REPLY_JITTER, rcvbuf = 8192, cost = 100;
+    int index = 0, exit_code = EXIT_SUCCESS;
+
+    skn_program_name_and_description_set(
+            "skn_discovery_simulation",
+            "Reply storm simulation of discovery on a large subnet."
+            );
+
+    if (argc > 1) {
+        responders = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        jitter = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        rcvbuf = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        cost = atoi(argv[4]);
+    }
+    if ((responders < 1) || (responders > SIM_MAX_RESPONDERS) || (jitter < 0) || (jitter > SKN_MAX_JITTER) || (cost < 0)) {
+        skn_logger(SD_ERR, "usage: %s [responders 1-%d] [jitter ms 0-%d] [rcvbuf bytes] [cost us]",
+                   gd_ch_program_name, SIM_MAX_RESPONDERS, SKN_MAX_JITTER);
+        exit(EXIT_FAILURE);
+    }
+    for (index = 1; index < (int) (sizeof(scenario) / sizeof(scenario[0])); index++) {
+        scenario[index].jitter = jitter;
+    }
+    gd_i_unique_registry = 1;  // a repeated entry is a duplicate, not a new one
+
+    memset(&bank, 0, sizeof(bank));
+    strcpy(bank.cbName, "PSimBank");
+    bank.count = responders;
+    bank.seed = (unsigned int) (time(NULL) ^ getpid());
+    bank.pending_max = responders * SKN_QUERY_ROUNDS;
+    bank.responder = calloc(responders, sizeof(SimResponder));
+    bank.pfd = calloc(responders, sizeof(struct pollfd));
+    bank.pending = calloc(bank.pending_max, sizeof(SimPending));
+    if ((bank.responder == NULL) || (bank.pfd == NULL) || (bank.pending == NULL)) {
+        exit(EXIT_FAILURE);
+    }
+    for (index = 0; index < responders; index++) {
+        if ((bank.pfd[index].fd = bank.responder[index].fd = sim_socket(0)) == PLATFORM_ERROR) {
+            skn_logger(SD_ERR, "Simulation: responder %d socket Failure code=%d, etext=%s", index, errno, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        len = sizeof(addr);
+        getsockname(bank.responder[index].fd, (struct sockaddr *) &addr, &len);
+        bank.responder[index].port = ntohs(addr.sin_port);
+        bank.pfd[index].events = POLLIN;
+        snprintf(bank.responder[index].ip, INET_ADDRSTRLEN, "10.100.%d.%d", 1 + (index / 250), 1 + (index % 250));
+        bank.responder[index].has_lcd = ((index % SIM_LCD_EVERY) == 0);
+    }
+
+    skn_logger(" ", "Discovery over loopback: %d responders, %d ms window, jitter %d ms, rcvbuf %d bytes, %d us per reply",
+               responders, SIM_WINDOW_MS, jitter, rcvbuf, cost);
+    skn_logger(" ", "%-7s %8s %6s %6s %8s %5s %7s %5s %s",
+               "mode", "requests", "sent", "silent", "received", "late", "dropped", "dups", "found");
+    for (index = 0; index < (int) (sizeof(scenario) / sizeof(scenario[0])) && exit_code == EXIT_SUCCESS; index++) {
+        exit_code = sim_scenario(&bank, &scenario[index], rcvbuf, cost);
+    }
+
+    for (index = 0; index < responders; index++) {
+        close(bank.responder[index].fd);
+    }
+    free(bank.responder);
+    free(bank.pfd);
+    free(bank.pending);
+
+    exit(exit_code);
+}
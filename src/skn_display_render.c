@@ -0,0 +1,476 @@
+/*
+ * skn_display_render.c
+ *
+ *  Display render core, the display service's LCD model without the LCD.
+ *  - the line collection, the message ring, the shadow framebuffer and the
+ *    frame clock; a frame goes out through the LCDDevice's move and put
+ *  - takes nothing from wiringPi, so the sim device and the render
+ *    benchmark build on any host
+ */
+
+#include "skn_network_helpers.h"
+
+/*
+ *  Global display settings:
+ */
+int gd_i_rows = 4;
+int gd_i_cols = 20;
+char *gd_pch_device_name = "pcf";
+int gd_i_ring_policy = SKN_RING_DROP_OLDEST;
+int gd_i_frame_rate = SKN_DISPLAY_FRAME_RATE;
+double gd_d_scroll_speed[ARY_MAX_LCD_ROWS] = { SKN_DISPLAY_SCROLL_SPEED, SKN_DISPLAY_SCROLL_SPEED,
+                                               SKN_DISPLAY_SCROLL_SPEED, SKN_DISPLAY_SCROLL_SPEED };
+PDisplayManager gp_structure_pdm = NULL;
+
+static void skn_display_ring_init(PDisplayRing prg, int policy);
+static int skn_display_ring_consume(PDisplayRing prg, char *message);
+static void skn_display_frame_move(PDisplayManager pdm, int row, int col);
+static void skn_display_frame_put(PDisplayManager pdm, const char *cells, int len);
+static void skn_display_frame_invalidate(PDisplayManager pdm);
+static int skn_display_frame_flush(PDisplayManager pdm);
+
+/**
+ * skn_scroller_pad_right
+ * - fills remaining with spaces and 0 terminates
+ * - buffer   message to adjust
+ */
+char * skn_scroller_pad_right(char *buffer) {
+    int hIndex = 0;
+
+    for (hIndex = strlen(buffer); hIndex < gd_i_cols; hIndex++) {
+        buffer[hIndex] = ' ';
+    }
+    buffer[gd_i_cols] = 0;
+
+    return buffer;
+}
+
+/**
+ * skn_scroller_wrap_blanks
+ *  - builds str with 20 chars in front, and 20 at right end
+ */
+char * skn_scroller_wrap_blanks(char *buffer) {
+    char worker[SZ_INFO_BUFF];
+    char col_width_padding[16];
+
+    if (buffer == NULL || strlen(buffer) > SZ_INFO_BUFF) {
+        return NULL;
+    }
+
+    snprintf(col_width_padding, 16, "%%%ds%%s%%%ds", gd_i_cols, gd_i_cols);
+    snprintf(worker, (SZ_INFO_BUFF - 1), col_width_padding, " ", buffer, " ");
+    memmove(buffer, worker, SZ_INFO_BUFF-1);
+    buffer[SZ_INFO_BUFF - 1] = 0;
+
+    return buffer;
+}
+
+/**
+ * Scrolls a single line across its row of the frame
+ * - best when wrapped in column chars on each side
+ * - moves cells positions, whole ones now and the fraction carried to
+ *   the next frame, then draws the line where it stands
+ * - row takes gd_i_cols cells, it is not terminated
+ */
+int skn_scroller_scroll_lines(PDisplayLine pdl, char *row, double cells)
+{
+    char buf[40];
+    signed int hAdjust = 0, mLen = 0;
+
+    for (pdl->scroll_carry += cells; pdl->scroll_carry >= 1.0; pdl->scroll_carry -= 1.0) {
+        mLen = strlen(&(pdl->ch_display_msg[pdl->display_pos]));
+        hAdjust = ((gd_i_cols < mLen) ? (pdl->msg_len - gd_i_cols) : 0);
+        if (++pdl->display_pos > hAdjust) {
+            pdl->display_pos = 0;
+        }
+    }
+
+    snprintf(buf, sizeof(buf) - 1, "%s", &(pdl->ch_display_msg[pdl->display_pos]));
+    skn_scroller_pad_right(buf);
+    memcpy(row, buf, gd_i_cols);
+
+    return pdl->display_pos;
+}
+
+/**
+ * skn_display_manager_select_set
+ * - adds newest to top of double-linked-list
+ * - only keeps 8 in collections
+ * - reuses in top down fashion
+ */
+PDisplayManager skn_display_manager_create(char * welcome) {
+    int index = 0, next = 0, prev = 0;
+    PDisplayManager pdm = NULL;
+    PDisplayLine pdl = NULL;
+
+    pdm = (PDisplayManager) malloc(sizeof(DisplayManager));
+    if (pdm == NULL) {
+        skn_logger(SD_ERR, "Display Manager cannot acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+
+    memset(pdm, 0, sizeof(DisplayManager));
+    strcpy(pdm->cbName, "PDisplayManager");
+    memmove(pdm->ch_welcome_msg, welcome, SZ_INFO_BUFF-1);
+    pdm->msg_len = strlen(welcome);
+
+    pdm->dsp_cols = gd_i_cols;
+    pdm->dsp_rows = gd_i_rows;
+    pdm->current_line = 0;
+    pdm->next_line = gd_i_rows;
+    skn_display_ring_init(&pdm->ring, gd_i_ring_policy);
+
+    for (index = 0; index < ARY_MAX_DM_LINES; index++) {
+        pdl = pdm->pdsp_collection[index] = (PDisplayLine) malloc(sizeof(DisplayLine)); // line x
+        memset(pdl, 0, sizeof(DisplayLine));
+        strcpy(pdl->cbName, "PDisplayLine");
+        strncpy(pdl->ch_display_msg, welcome, (SZ_INFO_BUFF -1));  // load all with welcome message
+        pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
+        pdl->msg_len = pdm->msg_len;
+        pdl->active = 1;
+        if (pdl->msg_len > gd_i_cols) {
+            pdl->scroll_enabled = 1;
+            skn_scroller_wrap_blanks(pdl->ch_display_msg);
+            pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
+            pdl->msg_len = strlen(pdl->ch_display_msg);
+        }
+    }
+    for (index = 0; index < ARY_MAX_DM_LINES; index++) {               // enable link list routing
+            next = (((index + 1) == ARY_MAX_DM_LINES) ? 0 : (index + 1));
+            prev = (((index - 1) == -1) ? (ARY_MAX_DM_LINES - 1) : (index - 1));
+            pdm->pdsp_collection[index]->next = pdm->pdsp_collection[next];
+            pdm->pdsp_collection[index]->prev = pdm->pdsp_collection[prev];
+    }
+    return pdm;
+}
+PDisplayLine skn_display_manager_add_line(PDisplayManager pdmx, char * client_request_message) {
+    PDisplayLine pdl = NULL;
+    PDisplayManager pdm = NULL;
+
+    pdm = ((pdmx == NULL) ? skn_get_display_manager_ref() : pdmx);
+    if (pdm == NULL || client_request_message == NULL) {
+        return NULL;
+    }
+
+    /*
+     * manage next index */
+    pdl = pdm->pdsp_collection[pdm->next_line++]; // manage next index
+    if (pdm->next_line == ARY_MAX_DM_LINES) {
+        pdm->next_line = 0; // roll it
+    }
+
+    /*
+     * load new message */
+    strncpy(pdl->ch_display_msg, client_request_message, (SZ_INFO_BUFF-1));
+    pdl->ch_display_msg[SZ_INFO_BUFF - 1] = 0;    // terminate string in case
+    pdl->msg_len = strlen(pdl->ch_display_msg);
+    pdl->active = 1;
+    pdl->display_pos = 0;
+    pdl->scroll_carry = 0.0;
+    if (pdl->msg_len > gd_i_cols) {
+        pdl->scroll_enabled = 1;
+        skn_scroller_wrap_blanks(pdl->ch_display_msg);
+        pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
+        pdl->msg_len = strlen(pdl->ch_display_msg);
+    } else {
+        pdl->scroll_enabled = 0;
+    }
+
+    /*
+     * manage current_line */
+    pdm->pdsp_collection[pdm->current_line]->active = 0;
+    pdm->pdsp_collection[pdm->current_line++]->msg_len = 0;
+    if (pdm->current_line == ARY_MAX_DM_LINES) {
+        pdm->current_line = 0;
+    }
+
+    skn_logger(SD_DEBUG, "DM Added msg=%d:%d:[%s]", ((pdm->next_line - 1) < 0 ? 0 : (pdm->next_line - 1)), pdl->msg_len, pdl->ch_display_msg);
+
+    /* return this line's pointer */
+    return pdl;
+}
+PDisplayManager skn_get_display_manager_ref() {
+    return gp_structure_pdm;
+}
+
+static void skn_display_ring_init(PDisplayRing prg, int policy) {
+    memset(prg, 0, sizeof(DisplayRing));
+    strcpy(prg->cbName, "PDisplayRing");
+    prg->policy = policy;
+}
+
+/**
+ * skn_display_ring_publish()
+ * - copies message into the next free slot, consumer thread only
+ * - a full ring drops by its policy, never waiting on the render loop
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when message was dropped
+ */
+int skn_display_ring_publish(PDisplayRing prg, const char *message) {
+    uint32_t head = prg->head, tail = __atomic_load_n(&prg->tail, __ATOMIC_ACQUIRE);
+    char *slot = NULL;
+
+    if ((head - tail) >= ARY_MAX_DM_MESSAGES) {
+        if (prg->policy == SKN_RING_DROP_NEWEST) {
+            prg->dropped++;
+            return EXIT_FAILURE;
+        }
+        /* claim the oldest; losing the race means the render loop just took it */
+        if (__atomic_compare_exchange_n(&prg->tail, &tail, tail + 1, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            prg->dropped++;
+        }
+        tail = __atomic_load_n(&prg->tail, __ATOMIC_ACQUIRE);
+    }
+
+    slot = prg->slot[head & (ARY_MAX_DM_MESSAGES - 1)];
+    strncpy(slot, message, SZ_INFO_BUFF - 1);
+    slot[SZ_INFO_BUFF - 1] = 0;
+    __atomic_store_n(&prg->head, head + 1, __ATOMIC_RELEASE);
+
+    prg->enqueued++;
+    if ((head + 1 - tail) > prg->high_water) {
+        prg->high_water = head + 1 - tail;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_display_ring_consume()
+ * - copies the oldest waiting message out, render loop only
+ * - a copy the producer overwrote while it was taken fails the CAS and
+ *   is thrown away, so a torn line is never shown
+ *
+ * - returns TRUE with message filled | FALSE when empty
+ */
+static int skn_display_ring_consume(PDisplayRing prg, char *message) {
+    uint32_t tail = 0;
+
+    for (;;) {
+        tail = __atomic_load_n(&prg->tail, __ATOMIC_ACQUIRE);
+        if (tail == __atomic_load_n(&prg->head, __ATOMIC_ACQUIRE)) {
+            return FALSE;
+        }
+        memcpy(message, prg->slot[tail & (ARY_MAX_DM_MESSAGES - 1)], SZ_INFO_BUFF);
+        message[SZ_INFO_BUFF - 1] = 0;
+        if (__atomic_compare_exchange_n(&prg->tail, &tail, tail + 1, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            prg->consumed++;
+            return TRUE;
+        }
+    }
+}
+
+
+/**
+ * skn_display_frame_init()
+ * - the LCD was just cleared, so the shadow starts as blanks
+ * - a serial LCD's last column is left alone, writing it may scroll the display
+ */
+void skn_display_frame_init(PDisplayManager pdm) {
+    PLCDFrameBuffer pfb = &pdm->fb;
+
+    memset(pfb, 0, sizeof(LCDFrameBuffer));
+    strcpy(pfb->cbName, "PLCDFrameBuffer");
+    memset(pfb->shadow, ' ', sizeof(pfb->shadow));
+    memset(pfb->frame, ' ', sizeof(pfb->frame));
+    pfb->cursor_row = pfb->cursor_col = -1;
+    pfb->move_cost = ((strcmp("ser", gd_pch_device_name) == 0) ? SKN_FB_MOVE_COST_SERIAL : SKN_FB_MOVE_COST_I2C);
+}
+
+/*
+ * the device sends, the framebuffer counts */
+static void skn_display_frame_move(PDisplayManager pdm, int row, int col) {
+    pdm->lcd.move(&pdm->lcd, row, col);
+    pdm->fb.moves++;
+}
+
+static void skn_display_frame_put(PDisplayManager pdm, const char *cells, int len) {
+    pdm->lcd.put(&pdm->lcd, cells, len);
+    pdm->fb.cells += len;
+}
+
+/*
+ * the device dropped cells, nothing the LCD shows is known any more */
+static void skn_display_frame_invalidate(PDisplayManager pdm) {
+    memset(pdm->fb.shadow, SKN_FB_UNKNOWN, sizeof(pdm->fb.shadow));
+    pdm->fb.cursor_row = pdm->fb.cursor_col = -1;
+    pdm->fb.invalidated++;
+    pdm->lcd.lost = 0;
+}
+
+/**
+ * skn_display_frame_flush()
+ * - sends the cells of frame that differ from shadow, then takes frame as
+ *   the new shadow
+ * - a run grows over unchanged cells while they cost no more than the
+ *   cursor move a second run would need
+ * - nothing is sent while the device is not ready; the shadow stays as it
+ *   is, so the next frame sends these changes too
+ * - a device that dropped cells leaves the shadow unknown, so every cell
+ *   goes out again
+ *
+ * - returns count of cells sent
+ */
+static int skn_display_frame_flush(PDisplayManager pdm) {
+    PLCDFrameBuffer pfb = &pdm->fb;
+    int row = 0, col = 0, start = 0, end = 0, scan = 0, sent = 0, ready = TRUE;
+    int cols = ((strcmp("ser", gd_pch_device_name) == 0) ? pdm->dsp_cols - 1 : pdm->dsp_cols);
+
+    pfb->frames++;
+    if (pdm->lcd.ready != NULL) {
+        ready = pdm->lcd.ready(&pdm->lcd);
+    }
+    if (pdm->lcd.lost) {
+        skn_display_frame_invalidate(pdm);
+    }
+    if (!ready) {
+        pfb->deferred++;
+        return 0;
+    }
+    for (row = 0; row < pdm->dsp_rows; row++) {
+        for (col = 0; col < cols; col = end) {
+            if (pfb->frame[row][col] == pfb->shadow[row][col]) {
+                end = col + 1;
+                continue;
+            }
+            start = col;
+            end = col + 1;
+            for (scan = end; scan < cols; scan++) {
+                if (pfb->frame[row][scan] != pfb->shadow[row][scan]) {
+                    if ((scan - end) > pfb->move_cost) {
+                        break;
+                    }
+                    end = scan + 1;
+                }
+            }
+
+            if ((pfb->cursor_row != row) || (pfb->cursor_col != start)) {
+                skn_display_frame_move(pdm, row, start);
+            }
+            skn_display_frame_put(pdm, &pfb->frame[row][start], end - start);
+            memcpy(&pfb->shadow[row][start], &pfb->frame[row][start], end - start);
+            sent += end - start;
+
+            /* the cursor wraps past a row's end to wherever the LCD puts it */
+            pfb->cursor_row = ((end < cols) ? row : -1);
+            pfb->cursor_col = end;
+        }
+    }
+    if (pdm->lcd.flush != NULL) {
+        pdm->lcd.flush(&pdm->lcd);
+    }
+    if (pdm->lcd.lost) {
+        skn_display_frame_invalidate(pdm);
+    }
+    if (sent == 0) {
+        pfb->unchanged++;
+    }
+
+    return sent;
+}
+
+/**
+ * skn_display_frame_schedule()
+ * - starts the frame clock, tick zero being due now
+ */
+void skn_display_frame_schedule(PDisplayManager pdm, double interval) {
+    PFrameScheduler pfs = &pdm->frame;
+
+    memset(pfs, 0, sizeof(FrameScheduler));
+    strcpy(pfs->cbName, "PFrameScheduler");
+    pfs->interval = interval;
+    clock_gettime(CLOCK_MONOTONIC, &pfs->start);
+}
+
+/**
+ * skn_display_frame_tick()
+ * - counts the ticks this frame covers and how late it started
+ *
+ * - returns seconds of scrolling the frame covers
+ */
+double skn_display_frame_tick(PDisplayManager pdm, uint64_t expirations) {
+    PFrameScheduler pfs = &pdm->frame;
+    struct timespec now;
+    double late = 0.0;
+
+    if (expirations < 1) {
+        expirations = 1;
+    }
+    pfs->ticks += expirations;
+    pfs->frames++;
+    pfs->missed += expirations - 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    late = (double) (now.tv_sec - pfs->start.tv_sec) + ((now.tv_nsec - pfs->start.tv_nsec) / 1000000000.0)
+           - (pfs->ticks * pfs->interval);
+    if (late < 0.0) {
+        late = 0.0;
+    }
+    pfs->jitter_sum += late;
+    if (late > pfs->jitter_max) {
+        pfs->jitter_max = late;
+    }
+
+    return expirations * pfs->interval;
+}
+
+
+/**
+ * skn_display_manager_render_frame()
+ * - one frame: takes in the messages waiting in the ring, then scrolls
+ *   each visible line by its row's speed for the elapsed seconds the frame
+ *   covers, and sends what changed
+ *
+ * - returns count of cells sent
+ */
+int skn_display_manager_render_frame(PDisplayManager pdm, double elapsed) {
+    PDisplayLine pdl = NULL;
+    char message[SZ_INFO_BUFF];
+    int index = 0, dsp_line_number = 0;
+
+    while (skn_display_ring_consume(&pdm->ring, message)) {
+        skn_display_manager_add_line(pdm, message);
+    }
+
+    /* rows not drawn keep the last frame's cells, the shadow may be unknown */
+    pdl = pdm->pdsp_collection[pdm->current_line];
+    for (index = 0; index < pdm->dsp_rows; index++) {
+        if (pdl->active == 1) {
+            skn_scroller_scroll_lines(pdl, pdm->fb.frame[dsp_line_number], gd_d_scroll_speed[dsp_line_number] * elapsed);
+            dsp_line_number++;
+        }
+        pdl = (PDisplayLine) pdl->next;
+    }
+
+    return skn_display_frame_flush(pdm);
+}
+
+/**
+ * skn_display_manager_log_counters()
+ * - ring, framebuffer and frame scheduler lines
+ */
+void skn_display_manager_log_counters(PDisplayManager pdm) {
+    skn_logger(SD_NOTICE, "DisplayRing: %lu enqueued, %lu dropped %s, %lu consumed, high water %u of %d",
+               pdm->ring.enqueued, pdm->ring.dropped, (pdm->ring.policy == SKN_RING_DROP_NEWEST ? "newest" : "oldest"),
+               pdm->ring.consumed, pdm->ring.high_water, ARY_MAX_DM_MESSAGES);
+    skn_logger(SD_NOTICE, "LCDFrameBuffer: %lu frames, %lu unchanged, %lu deferred, %lu invalidated, sent %lu cells and %lu cursor moves, a full redraw %lu cells",
+               pdm->fb.frames, pdm->fb.unchanged, pdm->fb.deferred, pdm->fb.invalidated, pdm->fb.cells, pdm->fb.moves,
+               pdm->fb.frames * (unsigned long) (pdm->dsp_rows * pdm->dsp_cols));
+    skn_logger(SD_NOTICE, "FrameScheduler: %lu frames at %d/s, %lu ticks missed and caught up, late by %1.3fms mean %1.3fms most",
+               pdm->frame.frames, gd_i_frame_rate, pdm->frame.missed,
+               (pdm->frame.frames > 0 ? (pdm->frame.jitter_sum / pdm->frame.frames) * 1000.0 : 0.0), pdm->frame.jitter_max * 1000.0);
+}
+
+void skn_display_manager_destroy(PDisplayManager pdm) {
+    int index = 0;
+
+    // free collection
+    for (index = 0; index < ARY_MAX_DM_LINES; index++) {
+        if (pdm->pdsp_collection[index] != NULL) {
+            free(pdm->pdsp_collection[index]);
+        }
+    }
+    // free manager
+    if (pdm != NULL)
+        free(pdm);
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+/*
+ * skn_display_serial.c
+ *
+ *  Serial LCD backpack, --i2c-chipset=ser, 0xFE command set.
+ *  - the port is opened raw and non-blocking at --baud, and a frame's moves
+ *    and cells leave in a single write as it ends
+ *  - the render loop never sleeps on the port: a frame the backpack cannot
+ *    take yet is deferred, see SerialLink
+ *  - startup and shutdown commands wait only their datasheet settle times
+ */
+
+#include "skn_network_helpers.h"
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+
+/*
+ *  Global serial settings:
+ */
+char *gd_pch_serial_port;
+int gd_i_serial_baud = SKN_SERIAL_BAUD;
+int gd_i_serial_pacing = SKN_SERIAL_PACING;
+
+static const struct {
+    int baud;
+    speed_t speed;
+} gs_serial_speed[] = {
+    { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+    { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 }
+};
+
+static double skn_display_serial_now();
+static int skn_display_serial_open(PLCDDevice plcd);
+static int skn_display_serial_write(PLCDDevice plcd);
+static void skn_display_serial_command(PLCDDevice plcd, const char *command, int len, int settle_us);
+static void skn_display_serial_drain(PLCDDevice plcd);
+static void skn_display_serial_move(PLCDDevice plcd, int row, int col);
+static void skn_display_serial_put(PLCDDevice plcd, const char *cells, int len);
+static int skn_display_serial_ready(PLCDDevice plcd);
+static void skn_display_serial_flush(PLCDDevice plcd);
+
+static double skn_display_serial_now() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (now.tv_nsec / 1000000000.0);
+}
+
+/**
+ * skn_display_serial_baud_valid()
+ *
+ * - returns index into the speed table | PLATFORM_ERROR when not a rate termios knows
+ */
+int skn_display_serial_baud_valid(int baud) {
+    int index = 0;
+
+    for (index = 0; index < (int) (sizeof(gs_serial_speed) / sizeof(gs_serial_speed[0])); index++) {
+        if (gs_serial_speed[index].baud == baud) {
+            return index;
+        }
+    }
+
+    return PLATFORM_ERROR;
+}
+
+/**
+ * skn_display_serial_open()
+ * - raw 8N1 at --baud, no flow control, reads never wait
+ * - HUPCL off, so closing the port does not drop DTR and reset a backpack
+ * - asks the UART driver for low latency; USB ACM ports decline, harmlessly
+ *
+ * - returns fd | PLATFORM_ERROR
+ */
+static int skn_display_serial_open(PLCDDevice plcd) {
+    struct termios tio;
+    struct serial_struct serial;
+    speed_t speed = gs_serial_speed[skn_display_serial_baud_valid(gd_i_serial_baud)].speed;
+    int fd = open(plcd->ch_serial_port_name, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd == PLATFORM_ERROR) {
+        return PLATFORM_ERROR;
+    }
+    if (tcgetattr(fd, &tio) == PLATFORM_ERROR) {
+        close(fd);
+        return PLATFORM_ERROR;
+    }
+
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= (CLOCAL | CREAD);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS | HUPCL);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcflush(fd, TCIOFLUSH);
+    if (tcsetattr(fd, TCSANOW, &tio) == PLATFORM_ERROR) {
+        close(fd);
+        return PLATFORM_ERROR;
+    }
+
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+
+    return fd;
+}
+
+/**
+ * skn_display_serial_write()
+ * - writes what is queued without waiting; what the port does not take
+ *   stays queued for the next try
+ * - the backpack is busy until the bytes written, and the settle time of
+ *   the commands among them, have had time to pass
+ * - a failed write drops the queue and marks the device lost, so the
+ *   render loop redraws the whole screen
+ *
+ * - returns count of bytes still queued
+ */
+static int skn_display_serial_write(PLCDDevice plcd) {
+    PSerialLink psl = plcd->link;
+    double now = 0.0;
+    int sent = 0;
+
+    if (psl->tx_len == 0) {
+        return 0;
+    }
+
+    sent = (int) write(plcd->lcd_handle, psl->tx, psl->tx_len);
+    if (sent == PLATFORM_ERROR) {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            if (psl->errors++ == 0) {
+                skn_logger(SD_WARNING, "SerialPort: write() Failure code=%d, etext=%s", errno, strerror(errno));
+            }
+            psl->tx_len = 0;
+            psl->settle = 0.0;
+            plcd->lost = TRUE;
+        }
+        return psl->tx_len;
+    }
+
+    now = skn_display_serial_now();
+    if (psl->busy_until < now) {
+        psl->busy_until = now;
+    }
+    psl->busy_until += (sent * psl->byte_time) + psl->settle;
+    psl->settle = 0.0;
+    psl->writes++;
+    psl->bytes += sent;
+    if (sent < psl->tx_len) {
+        psl->partial++;
+        memmove(psl->tx, &psl->tx[sent], psl->tx_len - sent);
+    }
+    psl->tx_len -= sent;
+
+    return psl->tx_len;
+}
+
+/*
+ * queues one command, and the time the LCD needs after it */
+static void skn_display_serial_command(PLCDDevice plcd, const char *command, int len, int settle_us) {
+    PSerialLink psl = plcd->link;
+
+    if ((psl->tx_len + len) > SZ_SERIAL_TX) {
+        skn_display_serial_drain(plcd);
+    }
+    memcpy(&psl->tx[psl->tx_len], command, len);
+    psl->tx_len += len;
+    psl->settle += settle_us / 1000000.0;
+}
+
+/**
+ * skn_display_serial_drain()
+ * - writes everything queued, then waits until the backpack is done with
+ *   it; startup and shutdown only, never the render loop
+ */
+static void skn_display_serial_drain(PLCDDevice plcd) {
+    struct pollfd pfd;
+    struct timespec until;
+    double busy = 0.0;
+
+    pfd.fd = plcd->lcd_handle;
+    pfd.events = POLLOUT;
+    while (skn_display_serial_write(plcd) > 0) {
+        if (poll(&pfd, 1, 1000) <= 0) {
+            skn_logger(SD_WARNING, "SerialPort: port not draining, %d bytes dropped", plcd->link->tx_len);
+            plcd->link->tx_len = 0;
+            plcd->link->settle = 0.0;
+            plcd->lost = TRUE;
+            break;
+        }
+    }
+
+    busy = plcd->link->busy_until;
+    until.tv_sec = (time_t) busy;
+    until.tv_nsec = (long) ((busy - until.tv_sec) * 1000000000.0);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR)
+        ;
+}
+
+static void skn_display_serial_move(PLCDDevice plcd, int row, int col) {
+    char set_col_row_position[] = {0xfe, 0x47, 0x01, 0x01};
+
+    set_col_row_position[2] = (char) (col + 1);
+    set_col_row_position[3] = (char) (row + 1);
+    skn_display_serial_command(plcd, set_col_row_position, sizeof(set_col_row_position), 0);
+}
+
+static void skn_display_serial_put(PLCDDevice plcd, const char *cells, int len) {
+    skn_display_serial_command(plcd, cells, len, 0);
+}
+
+/*
+ * a frame may go out once the last one has left and been taken in */
+static int skn_display_serial_ready(PLCDDevice plcd) {
+    if (skn_display_serial_write(plcd) > 0) {
+        return FALSE;
+    }
+
+    return (skn_display_serial_now() >= plcd->link->busy_until);
+}
+
+static void skn_display_serial_flush(PLCDDevice plcd) {
+    skn_display_serial_write(plcd);
+}
+
+/**
+ * skn_device_manager_SerialPort()
+ * - opens --serial-port, then sets contrast, homes, hides the cursor,
+ *   clears and turns the display on
+ *
+ * - returns PLCDDevice | NULL
+ */
+PLCDDevice skn_device_manager_SerialPort(PDisplayManager pdm) {
+    PLCDDevice plcd =  NULL;
+    PSerialLink psl = NULL;
+    char display_on[] = { 0xfe, 0x42 };
+    char  cls[]   = { 0xfe, 0x58 };
+    char home[]  = { 0xfe, 0x48 };
+//    char set_cols_rows[] = {0xfe, 0xd1, gd_i_cols, gd_i_rows };
+    char set_contrast[] = {0xfe, 0x50, 0xdc};
+    char cursor_off[] = {0xfe, 0x4B };
+    double wire = 0.0, started = skn_display_serial_now();
+
+    if (pdm == NULL) {
+        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+
+    psl = (PSerialLink) malloc(sizeof(SerialLink));
+    if (psl == NULL) {
+        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources: SerialLink %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+    memset(psl, 0, sizeof(SerialLink));
+    strcpy(psl->cbName, "PSerialLink");
+    wire = 10.0 / gd_i_serial_baud;  // 8N1, ten bits a byte
+    psl->byte_time = ((wire > (gd_i_serial_pacing / 1000000.0)) ? wire : (gd_i_serial_pacing / 1000000.0));
+
+    plcd = (PLCDDevice)&pdm->lcd;
+    strncpy(plcd->cbName, "LCDDevice#SerialPort", SZ_CHAR_BUFF-1);
+    if (gd_pch_serial_port != NULL) {
+        strncpy(plcd->ch_serial_port_name, gd_pch_serial_port, SZ_CHAR_BUFF-1);
+    } else {
+        strncpy(plcd->ch_serial_port_name, "/dev/ttyACM0", SZ_CHAR_BUFF-1);
+    }
+    plcd->move = skn_display_serial_move;
+    plcd->put = skn_display_serial_put;
+    plcd->ready = skn_display_serial_ready;
+    plcd->flush = skn_display_serial_flush;
+    plcd->link = psl;
+
+    skn_logger(SD_NOTICE, "DeviceManager using  device [%s](%s) %d baud, %dus pacing",
+               plcd->cbName, plcd->ch_serial_port_name, gd_i_serial_baud, gd_i_serial_pacing);
+
+    pdm->lcd_handle = plcd->lcd_handle = skn_display_serial_open(plcd);
+    if (plcd->lcd_handle == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources: SerialPort=%s %d:%s",
+                   plcd->ch_serial_port_name, errno, strerror(errno));
+        plcd->link = NULL;
+        free(psl);
+        return NULL;
+    }
+
+    // set backlight & clear screen
+    skn_display_serial_command(plcd, set_contrast, sizeof(set_contrast), SKN_SERIAL_SETTLE_EEPROM);
+    skn_display_serial_command(plcd, home, sizeof(home), SKN_SERIAL_SETTLE_CLEAR);
+    skn_display_serial_command(plcd, cursor_off, sizeof(cursor_off), 0);
+    skn_display_serial_command(plcd, cls, sizeof(cls), SKN_SERIAL_SETTLE_CLEAR);
+    skn_display_serial_command(plcd, display_on, sizeof(display_on), 0);
+    skn_display_serial_drain(plcd);
+
+    skn_logger(SD_DEBUG, "SerialPort: ready in %1.3fs", skn_display_serial_now() - started);
+
+    return plcd;
+}
+
+/**
+ * skn_device_manager_serial_shutdown()
+ * - sends what the last frame left queued, turns the display off and
+ *   clears it, then closes the port
+ */
+void skn_device_manager_serial_shutdown(PDisplayManager pdm) {
+    PLCDDevice plcd = (PLCDDevice)&pdm->lcd;
+    PSerialLink psl = plcd->link;
+    char display_off[] = { 0xfe, 0x46 };
+    char cls[]   = { 0xfe, 0x58 };
+
+    if (psl == NULL) {
+        return;
+    }
+
+    skn_display_serial_command(plcd, display_off, sizeof(display_off), 0);
+    skn_display_serial_command(plcd, cls, sizeof(cls), SKN_SERIAL_SETTLE_CLEAR);
+    skn_display_serial_drain(plcd);
+    close(plcd->lcd_handle);
+
+    skn_logger(SD_NOTICE, "SerialPort: %lu writes, %lu bytes, %lu partial, %lu failed",
+               psl->writes, psl->bytes, psl->partial, psl->errors);
+
+    plcd->link = NULL;
+    free(psl);
+}
@@ -0,0 +1,133 @@
+/*
+ * skn_display_sim.c
+ *
+ *  Simulated LCD, --i2c-chipset=sim, the display service without the hardware.
+ *  - keeps an HD44780's display memory, cursor moves set the address and
+ *    cells are written from it on, wrapping as the controller does
+ *  - counts cursor moves and cells, and from them the bytes a serial LCD
+ *    and a PCF8574 I2C backpack would have carried for the same frames
+ *  - the screen can be dumped, or compared with the render loop's shadow
+ */
+
+#include "skn_network_helpers.h"
+
+static void skn_display_sim_move(PLCDDevice plcd, int row, int col);
+static void skn_display_sim_put(PLCDDevice plcd, const char *cells, int len);
+
+static void skn_display_sim_move(PLCDDevice plcd, int row, int col) {
+    PLCDSimulator psim = plcd->sim;
+
+    psim->address = (psim->row_address[row] + col) & (SKN_SIM_DDRAM - 1);
+    psim->commands++;
+}
+
+static void skn_display_sim_put(PLCDDevice plcd, const char *cells, int len) {
+    PLCDSimulator psim = plcd->sim;
+    int index = 0;
+
+    for (index = 0; index < len; index++) {
+        psim->ddram[psim->address] = (unsigned char) cells[index];
+        psim->address = (psim->address + 1) & (SKN_SIM_DDRAM - 1);
+    }
+    psim->cells += len;
+}
+
+/**
+ * skn_device_manager_Simulator()
+ * - a cleared screen of pdm's rows and cols, rows placed in display memory
+ *   as a 20x4 or 16x2 HD44780 places them
+ *
+ * - returns PLCDDevice | NULL
+ */
+PLCDDevice skn_device_manager_Simulator(PDisplayManager pdm) {
+    PLCDDevice plcd = NULL;
+    PLCDSimulator psim = NULL;
+
+    if (pdm == NULL) {
+        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+
+    psim = (PLCDSimulator) malloc(sizeof(LCDSimulator));
+    if (psim == NULL) {
+        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources: Simulator %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+    memset(psim, 0, sizeof(LCDSimulator));
+    strcpy(psim->cbName, "PLCDSimulator");
+    memset(psim->ddram, ' ', sizeof(psim->ddram));
+    psim->row_address[0] = 0x00;
+    psim->row_address[1] = 0x40;
+    psim->row_address[2] = 0x00 + pdm->dsp_cols;
+    psim->row_address[3] = 0x40 + pdm->dsp_cols;
+
+    plcd = (PLCDDevice)&pdm->lcd;
+    memset(plcd, 0, sizeof(LCDDevice));
+    strncpy(plcd->cbName, "LCDDevice#Simulator", SZ_CHAR_BUFF-1);
+    plcd->move = skn_display_sim_move;
+    plcd->put = skn_display_sim_put;
+    plcd->sim = psim;
+    pdm->lcd_handle = plcd->lcd_handle = 0;
+
+    skn_logger(SD_NOTICE, "DeviceManager using device [%s](%dx%d)", plcd->cbName, pdm->dsp_cols, pdm->dsp_rows);
+
+    return plcd;
+}
+
+/**
+ * skn_display_sim_compare()
+ * - checks the simulated screen against the framebuffer's shadow, the
+ *   cells the render loop believes the LCD shows
+ *
+ * - returns count of cells that differ
+ */
+int skn_display_sim_compare(PDisplayManager pdm) {
+    PLCDSimulator psim = pdm->lcd.sim;
+    int row = 0, col = 0, differ = 0;
+
+    for (row = 0; row < pdm->dsp_rows; row++) {
+        for (col = 0; col < pdm->dsp_cols; col++) {
+            if (psim->ddram[(psim->row_address[row] + col) & (SKN_SIM_DDRAM - 1)] != (unsigned char) pdm->fb.shadow[row][col]) {
+                differ++;
+            }
+        }
+    }
+
+    return differ;
+}
+
+/*
+ * logs the simulated screen, a row a line */
+void skn_display_sim_dump(PDisplayManager pdm) {
+    PLCDSimulator psim = pdm->lcd.sim;
+    char line[ARY_MAX_LCD_COLS + 1];
+    int row = 0, col = 0;
+
+    for (row = 0; row < pdm->dsp_rows; row++) {
+        for (col = 0; col < pdm->dsp_cols; col++) {
+            line[col] = (char) psim->ddram[(psim->row_address[row] + col) & (SKN_SIM_DDRAM - 1)];
+        }
+        line[pdm->dsp_cols] = 0;
+        skn_logger(SD_NOTICE, "Simulator: |%s|", line);
+    }
+}
+
+/**
+ * skn_display_sim_log_counters()
+ * - what the same commands would have cost each real bus
+ */
+void skn_display_sim_log_counters(PDisplayManager pdm) {
+    PLCDSimulator psim = pdm->lcd.sim;
+
+    skn_logger(SD_NOTICE, "Simulator: %lu cursor moves, %lu cells, serial bus %lu bytes, i2c bus %lu bytes",
+               psim->commands, psim->cells,
+               (psim->commands * SKN_SIM_SERIAL_MOVE) + psim->cells,
+               (psim->commands + psim->cells) * SKN_SIM_I2C_BYTES);
+}
+
+void skn_display_sim_destroy(PDisplayManager pdm) {
+    if (pdm->lcd.sim != NULL) {
+        free(pdm->lcd.sim);
+    }
+    pdm->lcd.sim = NULL;
+}
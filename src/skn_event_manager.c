@@ -0,0 +1,269 @@
+/*
+ * skn_event_manager.c
+ *
+ *  Small epoll reactor for the udp services and the display render loop.
+ *  - threads sleep in epoll_wait() until a socket, timerfd or signalfd is ready
+ *  - skn_event_manager_request_shutdown() wakes every manager in the process
+ */
+
+#include "skn_network_helpers.h"
+
+static int gs_shutdown_fd = PLATFORM_ERROR;
+static pthread_once_t gs_shutdown_once = PTHREAD_ONCE_INIT;
+
+static void skn_event_manager_shutdown_fd_create();
+static int skn_event_manager_on_shutdown(void *pem, void *pes);
+static PEventSource skn_event_manager_add_source(PEventManager pem, int fd, int type, int owned,
+                                                 int (*handler)(void *pem, void *pes), void *context);
+
+static void skn_event_manager_shutdown_fd_create() {
+    gs_shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (gs_shutdown_fd == PLATFORM_ERROR) {
+        skn_logger(SD_EMERG, "EventManager: eventfd() Failure code=%d, etext=%s", errno, strerror(errno));
+    }
+}
+
+/*
+ * The shutdown eventfd is never read, so once written it stays readable
+ * and every epoll set watching it keeps waking until its loop ends.
+ */
+static int skn_event_manager_on_shutdown(void *pem, void *pes) {
+    skn_event_manager_stop((PEventManager) pem);
+    return EXIT_SUCCESS;
+}
+
+static PEventSource skn_event_manager_add_source(PEventManager pem, int fd, int type, int owned,
+                                                 int (*handler)(void *pem, void *pes), void *context) {
+    PEventSource pes = NULL;
+    struct epoll_event ev;
+
+    if (pem->count >= ARY_MAX_EVENT_SOURCES) {
+        skn_logger(SD_ERR, "EventManager: %s has no room for another source.", pem->cbName);
+        return NULL;
+    }
+
+    pes = &pem->source[pem->count];
+    memset(pes, 0, sizeof(EventSource));
+    pes->fd = fd;
+    pes->type = type;
+    pes->owned = owned;
+    pes->handler = handler;
+    pes->context = context;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = pes;
+    if (epoll_ctl(pem->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "EventManager: epoll_ctl() Failure code=%d, etext=%s", errno, strerror(errno));
+        return NULL;
+    }
+    pem->count++;
+
+    return pes;
+}
+
+/**
+ * skn_event_manager_create()
+ * - creates an epoll set already watching the shared shutdown eventfd
+ *
+ * - returns PEventManager | NULL
+ */
+PEventManager skn_event_manager_create(const char *name) {
+    PEventManager pem = NULL;
+
+    pthread_once(&gs_shutdown_once, skn_event_manager_shutdown_fd_create);
+    if (gs_shutdown_fd == PLATFORM_ERROR) {
+        return NULL;
+    }
+
+    pem = (PEventManager) malloc(sizeof(EventManager));
+    if (pem == NULL) {
+        skn_logger(SD_ERR, "EventManager cannot acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+    memset(pem, 0, sizeof(EventManager));
+    strncpy(pem->cbName, name, SZ_CHAR_BUFF - 1);
+
+    pem->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pem->epoll_fd == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "EventManager: epoll_create1() Failure code=%d, etext=%s", errno, strerror(errno));
+        free(pem);
+        return NULL;
+    }
+
+    if (skn_event_manager_add_source(pem, gs_shutdown_fd, SKN_EVENT_SHUTDOWN, 0, skn_event_manager_on_shutdown, NULL) == NULL) {
+        skn_event_manager_destroy(pem);
+        return NULL;
+    }
+
+    return pem;
+}
+
+void skn_event_manager_destroy(PEventManager pem) {
+    int index = 0;
+
+    if (pem == NULL) {
+        return;
+    }
+    for (index = 0; index < pem->count; index++) {
+        if (pem->source[index].owned) {
+            close(pem->source[index].fd);
+        }
+    }
+    close(pem->epoll_fd);
+    free(pem);
+}
+
+/**
+ * skn_event_manager_add_socket()
+ * - handler runs each time fd becomes readable; the caller keeps ownership of fd
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int skn_event_manager_add_socket(PEventManager pem, int fd, int (*handler)(void *pem, void *pes), void *context) {
+    if (skn_event_manager_add_source(pem, fd, SKN_EVENT_SOCKET, 0, handler, context) == NULL) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_event_manager_add_timer()
+ * - periodic CLOCK_MONOTONIC timerfd, first expiry after one interval
+ * - pes->expirations holds the ticks covered by each dispatch
+ *
+ * - returns timer fd | PLATFORM_ERROR
+ */
+int skn_event_manager_add_timer(PEventManager pem, double interval, int (*handler)(void *pem, void *pes), void *context) {
+    int fd = 0;
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "EventManager: timerfd_create() Failure code=%d, etext=%s", errno, strerror(errno));
+        return PLATFORM_ERROR;
+    }
+    if (skn_event_manager_add_source(pem, fd, SKN_EVENT_TIMER, 1, handler, context) == NULL) {
+        close(fd);
+        return PLATFORM_ERROR;
+    }
+    if (skn_event_timer_arm(fd, interval, interval) == PLATFORM_ERROR) {
+        return PLATFORM_ERROR;
+    }
+
+    return fd;
+}
+
+/**
+ * skn_event_timer_arm()
+ * - re-arms a timer fd; an initial of zero disarms it
+ *
+ * - returns EXIT_SUCCESS | PLATFORM_ERROR
+ */
+int skn_event_timer_arm(int fd, double initial, double interval) {
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = (time_t) initial;
+    its.it_value.tv_nsec = (long) ((initial - its.it_value.tv_sec) * 1000000000L);
+    its.it_interval.tv_sec = (time_t) interval;
+    its.it_interval.tv_nsec = (long) ((interval - its.it_interval.tv_sec) * 1000000000L);
+    if (timerfd_settime(fd, 0, &its, NULL) == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "EventManager: timerfd_settime() Failure code=%d, etext=%s", errno, strerror(errno));
+        return PLATFORM_ERROR;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_event_manager_add_signals()
+ * - routes the signals in mask through a signalfd
+ * - mask must already be blocked in every thread, see pthread_sigmask()
+ * - pes->siginfo holds the signal being dispatched
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int skn_event_manager_add_signals(PEventManager pem, sigset_t *mask, int (*handler)(void *pem, void *pes), void *context) {
+    int fd = 0;
+
+    fd = signalfd(-1, mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "EventManager: signalfd() Failure code=%d, etext=%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    if (skn_event_manager_add_source(pem, fd, SKN_EVENT_SIGNAL, 1, handler, context) == NULL) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_event_manager_run()
+ * - dispatches ready sources until stopped, a handler fails, or shutdown is requested
+ * - blocks without a timeout; an idle loop never wakes
+ * - a plain signal handler that sets gi_exit_flag also ends the loop, via EINTR
+ *
+ * - returns EXIT_SUCCESS | the failing handler's return code
+ */
+int skn_event_manager_run(PEventManager pem) {
+    struct epoll_event events[ARY_MAX_EVENT_SOURCES];
+    PEventSource pes = NULL;
+    int count = 0, index = 0, rc = EXIT_SUCCESS;
+    ssize_t rLen = 0;
+
+    pem->running = 1;
+    while (pem->running && gi_exit_flag == SKN_RUN_MODE_RUN) {
+        count = epoll_wait(pem->epoll_fd, events, ARY_MAX_EVENT_SOURCES, -1);
+        if (count == PLATFORM_ERROR) {
+            if (errno == EINTR) {
+                continue;
+            }
+            skn_logger(SD_ERR, "EventManager: epoll_wait() Failure code=%d, etext=%s", errno, strerror(errno));
+            rc = EXIT_FAILURE;
+            break;
+        }
+        pem->wakeups++;
+
+        for (index = 0; index < count && pem->running; index++) {
+            pes = (PEventSource) events[index].data.ptr;
+            if (pes->type == SKN_EVENT_TIMER) {
+                rLen = read(pes->fd, &pes->expirations, sizeof(pes->expirations));
+                if (rLen != sizeof(pes->expirations)) {  // re-armed since epoll_wait()
+                    continue;
+                }
+            } else if (pes->type == SKN_EVENT_SIGNAL) {
+                rLen = read(pes->fd, &pes->siginfo, sizeof(pes->siginfo));
+                if (rLen != sizeof(pes->siginfo)) {
+                    continue;
+                }
+            }
+            rc = pes->handler(pem, pes);
+            if (rc != EXIT_SUCCESS) {
+                pem->running = 0;
+            }
+        }
+    }
+
+    return rc;
+}
+
+void skn_event_manager_stop(PEventManager pem) {
+    pem->running = 0;
+}
+
+/**
+ * skn_event_manager_request_shutdown()
+ * - wakes every event manager in the process, from any thread
+ */
+void skn_event_manager_request_shutdown() {
+    uint64_t one = 1;
+
+    pthread_once(&gs_shutdown_once, skn_event_manager_shutdown_fd_create);
+    if (gs_shutdown_fd != PLATFORM_ERROR) {
+        if (write(gs_shutdown_fd, &one, sizeof(one)) != sizeof(one)) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,297 @@
+/**
+ * skn_gossip_simulation.c
+ * - Developer tool, not installed
+ *
+ * Runs several udp_locator_service processes over loopback, each on its
+ * own port with one entry of its own, seeded as a chain: locator i is only
+ * told of locator i-1.  Replication has to find the rest.
+ *
+ * Phases run in turn, each timed until every live locator agrees:
+ *   converge - every locator lists every locator's entry
+ *   add      - an ADD sent to the last locator is listed by all
+ *   failure  - the first locator quits, its entry leaves every other
+ *
+ * Reported per locator from its shutdown counters: gossip rounds, entry
+ * sets taken in, datagrams and bytes sent and received, and bytes per second.
+ *
+ * cmdline: ./skn_gossip_simulation [locators] [base port] [path to udp_locator_service]
+*/
+
+#include "skn_network_helpers.h"
+#include <sys/wait.h>
+
+#define SIM_MAX_LOCATORS   ARY_MAX_PEERS
+#define SIM_POLL_MS        50
+#define SIM_PHASE_LIMIT    60.0     // seconds before a phase is called failed
+#define SIM_ADD_NAME       "late_service"
+
+typedef struct _simLocator {
+    pid_t pid;
+    uint16_t port;
+    int  live;
+    char log[SZ_INFO_BUFF];
+    struct timespec quit;
+    unsigned long rounds;
+    unsigned long applied;
+    unsigned long sent;
+    unsigned long sent_bytes;
+    unsigned long received;
+    unsigned long received_bytes;
+} SimLocator, *PSimLocator;
+
+/*
+ * entry scan context: names counted by prefix */
+typedef struct _simCount {
+    const char *prefix;
+    int count;
+} SimCount, *PSimCount;
+
+static double sim_elapsed(struct timespec *pstart, struct timespec *pend) {
+    struct timespec now;
+
+    if (pend == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        pend = &now;
+    }
+    return (double) (pend->tv_sec - pstart->tv_sec) + ((pend->tv_nsec - pstart->tv_nsec) / 1000000000.0);
+}
+
+static int sim_count_record(PRegistryRecord prec, void *context) {
+    PSimCount psc = (PSimCount) context;
+    int len = (int) strlen(psc->prefix);
+
+    if ((prec->name.len >= len) && (strncmp(prec->name.start, psc->prefix, len) == 0)) {
+        psc->count++;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int sim_send(int fd, uint16_t port, const char *request) {
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    return (int) sendto(fd, request, strlen(request), 0, (struct sockaddr *) &addr, sizeof(addr));
+}
+
+/**
+ * sim_count()
+ * - asks the locator on port for its paged registry
+ *
+ * - returns count of entries named with prefix | PLATFORM_ERROR without a full reply
+ */
+static int sim_count(int fd, uint16_t port, const char *prefix) {
+    RegistryPageHeader rph;
+    SimCount sc;
+    char page[SKN_REGISTRY_PAGE + 1];
+    uint64_t seen = 0;
+    int len = 0, pages = 0;
+
+    while (recv(fd, page, SKN_REGISTRY_PAGE, MSG_DONTWAIT) > 0)  // stale pages of an earlier ask
+        ;
+    memset(&sc, 0, sizeof(sc));
+    sc.prefix = prefix;
+    if (sim_send(fd, port, SKN_PAGES_REQUEST) < 0) {
+        return PLATFORM_ERROR;
+    }
+    while ((pages == 0) || (__builtin_popcountll(seen) < pages)) {
+        if ((len = (int) recv(fd, page, SKN_REGISTRY_PAGE, 0)) < 0) {
+            return PLATFORM_ERROR;
+        }
+        page[len] = 0;
+        if ((service_registry_page_header(page, &rph) != EXIT_SUCCESS) || (seen & (1ULL << (rph.page - 1)))) {
+            continue;
+        }
+        seen |= 1ULL << (rph.page - 1);
+        pages = rph.pages;
+        service_registry_response_scan(&page[rph.body], sim_count_record, &sc, NULL);
+    }
+
+    return sc.count;
+}
+
+/**
+ * sim_phase()
+ * - polls every live locator until each lists want entries named prefix
+ *
+ * - returns seconds taken | -1.0 past SIM_PHASE_LIMIT
+ */
+static double sim_phase(int fd, PSimLocator locator, int count, const char *prefix, int want) {
+    struct timespec start;
+    int index = 0, agreed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (sim_elapsed(&start, NULL) < SIM_PHASE_LIMIT) {
+        for (index = 0, agreed = 0; index < count; index++) {
+            if (locator[index].live == 0) {
+                agreed++;
+            } else if (sim_count(fd, locator[index].port, prefix) == want) {
+                agreed++;
+            } else {
+                break;
+            }
+        }
+        if (agreed == count) {
+            return sim_elapsed(&start, NULL);
+        }
+        usleep(SIM_POLL_MS * 1000);
+    }
+
+    return -1.0;
+}
+
+static pid_t sim_spawn(PSimLocator psl, const char *path, int index, uint16_t seed) {
+    char port[16], entry[SZ_INFO_BUFF], peer[SZ_CHAR_LABEL];
+    int fd = 0;
+    pid_t pid = fork();
+
+    if (pid != 0) {
+        return pid;
+    }
+
+    if ((fd = open(psl->log, O_WRONLY | O_CREAT | O_TRUNC, 0644)) != PLATFORM_ERROR) {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        close(fd);
+    }
+    snprintf(port, sizeof(port), "%d", psl->port);
+    snprintf(entry, sizeof(entry), "name=svc_%02d,ip=127.0.0.1,port=%d|", index, 6000 + index);
+    snprintf(peer, sizeof(peer), "127.0.0.1:%d", seed);
+    if (seed == 0) {
+        execl(path, path, "-p", port, "-w", "1", "-j", "0", "-g", "none", "-x", "0", "-m", entry, (char *) NULL);
+    } else {
+        execl(path, path, "-p", port, "-w", "1", "-j", "0", "-g", "none", "-x", "0", "-m", entry, "-r", peer, (char *) NULL);
+    }
+    _exit(127);
+}
+
+/*
+ * stops one locator and reads its gossip counters from its log */
+static void sim_stop(int fd, PSimLocator psl) {
+    char line[SZ_LINE_BUFF];
+    const char *pch = NULL;
+    FILE *log = NULL;
+    int status = 0;
+
+    sim_send(fd, psl->port, "QUIT!");
+    clock_gettime(CLOCK_MONOTONIC, &psl->quit);
+    waitpid(psl->pid, &status, 0);
+    psl->live = 0;
+
+    if ((log = fopen(psl->log, "r")) == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), log) != NULL) {
+        if ((pch = strstr(line, "Gossip: ")) != NULL) {
+            sscanf(pch, "Gossip: %*d peers, %lu rounds, %lu updates applied, sent %lu datagrams %lu bytes, received %lu datagrams %lu bytes",
+                   &psl->rounds, &psl->applied, &psl->sent, &psl->sent_bytes, &psl->received, &psl->received_bytes);
+        }
+    }
+    fclose(log);
+}
+
+int main(int argc, char *argv[]) {
+    SimLocator locator[SIM_MAX_LOCATORS];
+    struct timeval tv = { 0, 200000 };
+    struct timespec start;
+    const char *path = "./udp_locator_service";
+    char request[SZ_INFO_BUFF];
+    double taken[3], lifetime = 0.0;
+    unsigned long sent = 0, sent_bytes = 0;
+    int count = 8, base = 49100, index = 0, fd = 0, exit_code = EXIT_SUCCESS;
+
+    skn_program_name_and_description_set(
+            "skn_gossip_simulation",
+            "Registry replication between locators over loopback."
+            );
+
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        base = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        path = argv[3];
+    }
+    if ((count < 2) || (count > SIM_MAX_LOCATORS) || (base < 1024) || ((base + count) > 0xFFFF) || (access(path, X_OK) != 0)) {
+        skn_logger(SD_ERR, "usage: %s [locators 2-%d] [base port] [path to udp_locator_service]", gd_ch_program_name, SIM_MAX_LOCATORS);
+        exit(EXIT_FAILURE);
+    }
+
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if ((fd == PLATFORM_ERROR) || (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == PLATFORM_ERROR)) {
+        skn_logger(SD_ERR, "Simulation: socket Failure code=%d, etext=%s", errno, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    skn_logger(" ", "Replication over loopback: %d locators on ports %d-%d, seeded as a chain, %1.1fs rounds",
+               count, base, base + count - 1, SKN_GOSSIP_INTERVAL);
+    memset(locator, 0, sizeof(locator));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (index = 0; index < count; index++) {
+        locator[index].port = (uint16_t) (base + index);
+        snprintf(locator[index].log, sizeof(locator[index].log), "/tmp/skn_gossip_simulation.%d.%02d.log", (int) getpid(), index);
+        locator[index].pid = sim_spawn(&locator[index], path, index, (uint16_t) (index == 0 ? 0 : base + index - 1));
+        if (locator[index].pid < 0) {
+            skn_logger(SD_ERR, "Simulation: fork() Failure code=%d, etext=%s", errno, strerror(errno));
+            count = index;
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+        locator[index].live = 1;
+    }
+
+    if (exit_code == EXIT_SUCCESS) {
+        taken[0] = sim_phase(fd, locator, count, "svc_", count);
+
+        snprintf(request, sizeof(request), "ADD name=%s,ip=127.0.0.1,port=7000|", SIM_ADD_NAME);
+        sim_send(fd, locator[count - 1].port, request);
+        taken[1] = sim_phase(fd, locator, count, SIM_ADD_NAME, 1);
+
+        sim_stop(fd, &locator[0]);
+        taken[2] = sim_phase(fd, locator, count, "svc_", count - 1);
+
+        skn_logger(" ", "%-9s %8s", "phase", "seconds");
+        skn_logger(" ", "%-9s %8.3f", "converge", taken[0]);
+        skn_logger(" ", "%-9s %8.3f", "add", taken[1]);
+        skn_logger(" ", "%-9s %8.3f", "failure", taken[2]);
+        for (index = 0; index < 3; index++) {
+            if (taken[index] < 0.0) {
+                exit_code = EXIT_FAILURE;
+            }
+        }
+    }
+
+    for (index = 0; index < count; index++) {
+        if (locator[index].live) {
+            sim_stop(fd, &locator[index]);
+        }
+    }
+    close(fd);
+
+    skn_logger(" ", "\n%-5s %6s %7s %9s %10s %9s %10s %8s",
+               "port", "rounds", "applied", "sent", "bytes", "received", "bytes", "bytes/s");
+    for (index = 0; index < count; index++) {
+        lifetime = sim_elapsed(&start, &locator[index].quit);
+        skn_logger(" ", "%-5d %6lu %7lu %9lu %10lu %9lu %10lu %8.1f",
+                   locator[index].port, locator[index].rounds, locator[index].applied,
+                   locator[index].sent, locator[index].sent_bytes, locator[index].received, locator[index].received_bytes,
+                   (lifetime > 0.0 ? locator[index].sent_bytes / lifetime : 0.0));
+        sent += locator[index].sent;
+        sent_bytes += locator[index].sent_bytes;
+        if (exit_code == EXIT_SUCCESS) {
+            unlink(locator[index].log);
+        }
+    }
+    skn_logger(" ", "total %6s %7s %9lu %10lu", "", "", sent, sent_bytes);
+    if (exit_code != EXIT_SUCCESS) {
+        skn_logger(" ", "locator logs kept as /tmp/skn_gossip_simulation.%d.*.log", (int) getpid());
+    }
+
+    exit(exit_code);
+}
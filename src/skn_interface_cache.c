@@ -0,0 +1,404 @@
+/*
+ * skn_interface_cache.c
+ *
+ *  Interface state shared by the udp services and clients.
+ *  - the broadcast capable IPv4 addresses and the default route are read
+ *    by netlink dumps, once at startup and again after each change the
+ *    kernel reports, never on a lookup
+ *  - a listener thread rebuilds into a free slot and publishes it, so an
+ *    address change is seen by the next lookup without a restart
+ */
+
+#include "skn_network_helpers.h"
+
+static InterfaceCache gs_interfaces;
+static pthread_once_t gs_interfaces_once = PTHREAD_ONCE_INIT;
+
+static void skn_interface_cache_initialize();
+static void skn_interface_cache_on_address(PInterfaceSnapshot pis, struct nlmsghdr *nlh);
+static void skn_interface_cache_on_route(struct nlmsghdr *nlh, int *poif, uint32_t *pmetric);
+static int skn_interface_cache_dump(PInterfaceCache pic, int fd, int type, PInterfaceSnapshot pis, int *poif);
+static int skn_interface_cache_rebuild(PInterfaceCache pic);
+static void *skn_interface_cache_thread(void *ptr);
+
+static void skn_interface_cache_initialize() {
+    PInterfaceCache pic = &gs_interfaces;
+
+    memset(pic, 0, sizeof(InterfaceCache));
+    strcpy(pic->cbName, "PInterfaceCache");
+    pthread_mutex_init(&pic->lock, NULL);
+    pic->nl_socket = PLATFORM_ERROR;
+}
+
+/**
+ * skn_interface_cache_on_address()
+ * - adds an RTM_NEWADDR to pis when it has a broadcast address, which
+ *   leaves out loopback and point to point links as getifaddrs() users did
+ */
+static void skn_interface_cache_on_address(PInterfaceSnapshot pis, struct nlmsghdr *nlh) {
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *) NLMSG_DATA(nlh);
+    struct rtattr *rta = IFA_RTA(ifa);
+    int len = IFA_PAYLOAD(nlh);
+    PInterfaceEntry pie = NULL;
+    struct in_addr local, address, broadcast;
+    const char *label = NULL;
+
+    if ((ifa->ifa_family != AF_INET) || (pis->count >= ARY_MAX_INTF)) {
+        return;
+    }
+
+    local.s_addr = address.s_addr = broadcast.s_addr = 0;
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        switch (rta->rta_type) {
+            case IFA_LOCAL:
+                memcpy(&local, RTA_DATA(rta), sizeof(local));
+                break;
+            case IFA_ADDRESS:
+                memcpy(&address, RTA_DATA(rta), sizeof(address));
+                break;
+            case IFA_BROADCAST:
+                memcpy(&broadcast, RTA_DATA(rta), sizeof(broadcast));
+                break;
+            case IFA_LABEL:
+                label = (const char *) RTA_DATA(rta);
+                break;
+        }
+    }
+    if ((broadcast.s_addr == 0) || (label == NULL)) {
+        return;
+    }
+
+    pie = &pis->entry[pis->count++];
+    strncpy(pie->name, label, IF_NAMESIZE - 1);
+    pie->index = (int) ifa->ifa_index;
+    pie->addr = (local.s_addr != 0 ? local : address);
+    pie->mask.s_addr = htonl(ifa->ifa_prefixlen == 0 ? 0 : (0xFFFFFFFFU << (32 - ifa->ifa_prefixlen)));
+    pie->broadcast = broadcast;
+}
+
+/**
+ * skn_interface_cache_on_route()
+ * - keeps the output interface of the main table's default route with
+ *   the lowest metric
+ */
+static void skn_interface_cache_on_route(struct nlmsghdr *nlh, int *poif, uint32_t *pmetric) {
+    struct rtmsg *rtm = (struct rtmsg *) NLMSG_DATA(nlh);
+    struct rtattr *rta = RTM_RTA(rtm);
+    int len = RTM_PAYLOAD(nlh), oif = 0;
+    uint32_t metric = 0, table = rtm->rtm_table;
+
+    if ((rtm->rtm_family != AF_INET) || (rtm->rtm_dst_len != 0) || (rtm->rtm_type != RTN_UNICAST)) {
+        return;
+    }
+
+    for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+        switch (rta->rta_type) {
+            case RTA_OIF:
+                memcpy(&oif, RTA_DATA(rta), sizeof(oif));
+                break;
+            case RTA_PRIORITY:
+                memcpy(&metric, RTA_DATA(rta), sizeof(metric));
+                break;
+            case RTA_TABLE:
+                memcpy(&table, RTA_DATA(rta), sizeof(table));
+                break;
+        }
+    }
+    if ((table != RT_TABLE_MAIN) || (oif == 0)) {
+        return;
+    }
+
+    if ((*poif == 0) || (metric < *pmetric)) {
+        *poif = oif;
+        *pmetric = metric;
+    }
+}
+
+/**
+ * skn_interface_cache_dump()
+ * - asks the kernel for every IPv4 address or route on fd, and reads the
+ *   reply into pis or poif
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int skn_interface_cache_dump(PInterfaceCache pic, int fd, int type, PInterfaceSnapshot pis, int *poif) {
+    struct {
+        struct nlmsghdr nlh;
+        union {
+            struct ifaddrmsg ifa;
+            struct rtmsg rtm;
+        } body;
+    } req;
+    struct sockaddr_nl kernel;
+    struct nlmsghdr *nlh = NULL;
+    char buffer[SKN_INTF_NETLINK_BUFF] __attribute__ ((aligned(NLMSG_ALIGNTO)));
+    uint32_t metric = 0;
+    int len = 0;
+
+    memset(&req, 0, sizeof(req));
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    req.nlh.nlmsg_type = (uint16_t) type;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++pic->seq;
+    if (type == RTM_GETADDR) {
+        req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifaddrmsg));
+        req.body.ifa.ifa_family = AF_INET;
+    } else {
+        req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+        req.body.rtm.rtm_family = AF_INET;
+    }
+
+    if (sendto(fd, &req, req.nlh.nlmsg_len, 0, (struct sockaddr *) &kernel, sizeof(kernel)) < 0) {
+        skn_logger(SD_ERR, "InterfaceCache: netlink request failed: %d:%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    while ((len = (int) recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        for (nlh = (struct nlmsghdr *) buffer; NLMSG_OK(nlh, (unsigned int) len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != pic->seq) {
+                continue;
+            }
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                return EXIT_SUCCESS;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                skn_logger(SD_ERR, "InterfaceCache: netlink dump %d refused: %d", type, ((struct nlmsgerr *) NLMSG_DATA(nlh))->error);
+                return EXIT_FAILURE;
+            }
+            if (nlh->nlmsg_type == RTM_NEWADDR) {
+                skn_interface_cache_on_address(pis, nlh);
+            } else if (nlh->nlmsg_type == RTM_NEWROUTE) {
+                skn_interface_cache_on_route(nlh, poif, &metric);
+            }
+        }
+    }
+    if (len < 0) {
+        skn_logger(SD_ERR, "InterfaceCache: netlink read failed: %d:%s", errno, strerror(errno));
+    }
+
+    return EXIT_FAILURE;
+}
+
+/**
+ * skn_interface_cache_rebuild()
+ * - reads addresses and the default route into the next free slot, then
+ *   publishes it; the published snapshot is left alone on failure
+ * - caller holds the lock
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int skn_interface_cache_rebuild(PInterfaceCache pic) {
+    PInterfaceSnapshot pis = &pic->slot[pic->next];
+    PInterfaceSnapshot previous = pic->current;
+    char ip[INET_ADDRSTRLEN];
+    int fd = PLATFORM_ERROR, oif = 0, index = 0, rc = EXIT_FAILURE;
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_ERR, "InterfaceCache: netlink socket failed: %d:%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    memset(pis, 0, sizeof(InterfaceSnapshot));
+    if ((skn_interface_cache_dump(pic, fd, RTM_GETADDR, pis, NULL) == EXIT_SUCCESS) &&
+        (skn_interface_cache_dump(pic, fd, RTM_GETROUTE, NULL, &oif) == EXIT_SUCCESS)) {
+        rc = EXIT_SUCCESS;
+    }
+    close(fd);
+    if (rc == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    if ((oif != 0) && (if_indextoname((unsigned int) oif, pis->defaultName) == NULL)) {
+        pis->defaultName[0] = 0;
+    }
+    for (index = 0; index < pis->count; index++) {
+        if (pis->entry[index].index == oif) {
+            pis->defaultIndex = index;
+            break;
+        }
+    }
+    if (pis->defaultName[0] == 0) {
+        skn_logger(SD_ERR, "No Default Network Interfaces Found!.");
+    }
+
+    pis->generation = (previous != NULL ? previous->generation + 1 : 1);
+    __atomic_store_n(&pic->current, pis, __ATOMIC_RELEASE);
+    pic->next = (pic->next + 1) % ARY_MAX_INTF_SNAPSHOTS;
+    pic->rebuilds++;
+
+    if (pis->count > 0) {
+        inet_ntop(AF_INET, &pis->entry[pis->defaultIndex].addr, ip, sizeof(ip));
+    } else {
+        strcpy(ip, "none");
+    }
+    skn_logger(SD_DEBUG, "InterfaceCache: generation %lu, %d interfaces, default %s %s",
+               pis->generation, pis->count, pis->defaultName, ip);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * skn_interface_cache_thread()
+ * - waits on address and route notifications; a burst of them is drained
+ *   before one rebuild, and a lost notification forces one too
+ * - rebuilds are SKN_INTF_REBUILD_INTERVAL apart, a change inside the
+ *   interval waits for it, so a slot is not reused while a reader holds it
+ */
+static void *skn_interface_cache_thread(void *ptr) {
+    PInterfaceCache pic = (PInterfaceCache) ptr;
+    char buffer[SKN_INTF_NETLINK_BUFF] __attribute__ ((aligned(NLMSG_ALIGNTO)));
+    struct timespec now, last;
+    int len = 0, changed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &last);
+
+    while (pic->shutdown == 0) {
+        len = (int) recv(pic->nl_socket, buffer, sizeof(buffer), 0);
+        if (len < 0) {
+            if (errno == ENOBUFS) {
+                pic->overruns++;
+                changed = 1;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                skn_logger(SD_ERR, "InterfaceCache: listener stopped: %d:%s", errno, strerror(errno));
+                break;
+            }
+        } else if (len > 0) {
+            pic->events++;
+            changed = 1;
+            while (recv(pic->nl_socket, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+                pic->events++;
+            }
+        }
+
+        if (changed && (pic->shutdown == 0)) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (((now.tv_sec - last.tv_sec) + ((now.tv_nsec - last.tv_nsec) / 1000000000.0)) < SKN_INTF_REBUILD_INTERVAL) {
+                if (changed == 1) {
+                    pic->deferred++;
+                    changed = 2;
+                }
+                continue;       // the receive timeout brings it back
+            }
+            pthread_mutex_lock(&pic->lock);
+            skn_interface_cache_rebuild(pic);
+            pthread_mutex_unlock(&pic->lock);
+            last = now;
+            changed = 0;
+        }
+    }
+
+    pthread_mutex_lock(&pic->lock);
+    close(pic->nl_socket);
+    pic->nl_socket = PLATFORM_ERROR;
+    pic->thread_complete = 0;
+    pthread_mutex_unlock(&pic->lock);
+
+    pthread_exit((void *) EXIT_SUCCESS);
+}
+
+/**
+ * skn_interface_cache_startup()
+ * - subscribes to address and route changes, loads the first snapshot and
+ *   starts the listener, once; later calls return at once
+ * - the subscription comes first, so no change made during the load is missed
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int skn_interface_cache_startup() {
+    PInterfaceCache pic = &gs_interfaces;
+    struct sockaddr_nl local;
+    struct timeval timeout = {1, 0};
+    sigset_t signal_set, saved_set;
+    pthread_attr_t attr;
+    int rc = EXIT_SUCCESS;
+
+    pthread_once(&gs_interfaces_once, skn_interface_cache_initialize);
+
+    pthread_mutex_lock(&pic->lock);
+    if ((pic->thread_complete == 0) && (pic->shutdown == 0)) {
+        memset(&local, 0, sizeof(local));
+        local.nl_family = AF_NETLINK;
+        local.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE;
+
+        pic->nl_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if ((pic->nl_socket == PLATFORM_ERROR) ||
+            (bind(pic->nl_socket, (struct sockaddr *) &local, sizeof(local)) == PLATFORM_ERROR) ||
+            (setsockopt(pic->nl_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == PLATFORM_ERROR)) {
+            skn_logger(SD_ERR, "InterfaceCache: netlink subscribe failed: %d:%s", errno, strerror(errno));
+            rc = EXIT_FAILURE;
+        } else if (skn_interface_cache_rebuild(pic) == EXIT_FAILURE) {
+            rc = EXIT_FAILURE;
+        } else {
+            /* detached: the one second receive timeout lets it see a shutdown,
+             * and signals are left to the threads that started it */
+            sigfillset(&signal_set);
+            pthread_sigmask(SIG_BLOCK, &signal_set, &saved_set);
+            pthread_attr_init(&attr);
+            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+            if (pthread_create(&pic->listener_thread, &attr, skn_interface_cache_thread, (void *) pic) != 0) {
+                skn_logger(SD_WARNING, "InterfaceCache: Create thread failed: %s", strerror(errno));
+                rc = EXIT_FAILURE;
+            } else {
+                pic->thread_complete = 1;
+            }
+            pthread_attr_destroy(&attr);
+            pthread_sigmask(SIG_SETMASK, &saved_set, NULL);
+        }
+        if ((rc == EXIT_FAILURE) && (pic->nl_socket != PLATFORM_ERROR)) {
+            close(pic->nl_socket);
+            pic->nl_socket = PLATFORM_ERROR;
+        }
+    }
+    pthread_mutex_unlock(&pic->lock);
+
+    return rc;
+}
+
+/**
+ * skn_interface_cache_shutdown()
+ * - stops the listener; the last snapshot stays readable
+ */
+void skn_interface_cache_shutdown() {
+    PInterfaceCache pic = &gs_interfaces;
+
+    pthread_once(&gs_interfaces_once, skn_interface_cache_initialize);
+
+    pthread_mutex_lock(&pic->lock);
+    pic->shutdown = 1;
+    skn_logger(SD_NOTICE, "InterfaceCache: events=%lu, rebuilds=%lu, deferred=%lu, overruns=%lu",
+               pic->events, pic->rebuilds, pic->deferred, pic->overruns);
+    pthread_mutex_unlock(&pic->lock);
+}
+
+/**
+ * skn_interface_cache_snapshot()
+ * - the current interface state, starting the cache on first use
+ *
+ * - returns PInterfaceSnapshot | NULL when interfaces cannot be read
+ */
+PInterfaceSnapshot skn_interface_cache_snapshot() {
+    PInterfaceSnapshot pis = __atomic_load_n(&gs_interfaces.current, __ATOMIC_ACQUIRE);
+
+    if (pis == NULL) {
+        skn_interface_cache_startup();
+        pis = __atomic_load_n(&gs_interfaces.current, __ATOMIC_ACQUIRE);
+    }
+
+    return pis;
+}
+
+/**
+ * skn_interface_cache_default()
+ * - the entry on the default route, or the first one without a default
+ *
+ * - returns PInterfaceEntry | NULL when pis holds no interface
+ */
+PInterfaceEntry skn_interface_cache_default(PInterfaceSnapshot pis) {
+    if ((pis == NULL) || (pis->count == 0)) {
+        return NULL;
+    }
+
+    return &pis->entry[pis->defaultIndex];
+}
@@ -0,0 +1,224 @@
+/*
+ * skn_name_resolver.c
+ *
+ *  Reverse DNS cache shared by the udp services and clients.
+ *  - getnameinfo() runs on a background thread, never on a receive path
+ *  - callers get the numeric address until the name arrives
+ */
+
+#include "skn_network_helpers.h"
+
+static NameResolver gs_resolver;
+static pthread_once_t gs_resolver_once = PTHREAD_ONCE_INIT;
+
+static void skn_resolver_initialize();
+static PResolverEntry skn_resolver_slot(PNameResolver pnr, in_addr_t addr);
+static void *skn_resolver_thread(void *ptr);
+
+static void skn_resolver_initialize() {
+    PNameResolver pnr = &gs_resolver;
+
+    memset(pnr, 0, sizeof(NameResolver));
+    strcpy(pnr->cbName, "PNameResolver");
+    pthread_mutex_init(&pnr->lock, NULL);
+    pthread_cond_init(&pnr->wakeup, NULL);
+}
+
+/**
+ * skn_resolver_slot()
+ * - finds the cache slot holding addr, or the slot it should be stored in
+ * - prefers an empty or expired slot, otherwise evicts the soonest to expire
+ * - caller holds the lock
+ */
+static PResolverEntry skn_resolver_slot(PNameResolver pnr, in_addr_t addr) {
+    PResolverEntry pre = NULL, victim = NULL;
+    uint32_t hash = (ntohl(addr) * 2654435761U);
+    int probe = 0;
+
+    for (probe = 0; probe < SKN_RESOLVER_PROBES; probe++) {
+        pre = &pnr->entry[(hash + probe) % ARY_MAX_RESOLVER];
+        if (pre->state != SKN_RESOLVER_EMPTY && pre->addr == addr) {
+            return pre;
+        }
+        if (pre->state == SKN_RESOLVER_PENDING) { // never evict a lookup in flight
+            continue;
+        }
+        if (victim == NULL) {
+            victim = pre;
+        } else if (victim->state != SKN_RESOLVER_EMPTY &&
+                   (pre->state == SKN_RESOLVER_EMPTY || pre->expires < victim->expires)) {
+            victim = pre;
+        }
+    }
+
+    if (victim == NULL) { // every probe in flight; resolve later
+        return NULL;
+    }
+    memset(victim, 0, sizeof(ResolverEntry));
+    victim->addr = addr;
+
+    return victim;
+}
+
+/**
+ * skn_resolver_thread()
+ * - resolves queued addresses one at a time, outside of the lock
+ */
+static void *skn_resolver_thread(void *ptr) {
+    PNameResolver pnr = (PNameResolver) ptr;
+    PResolverEntry pre = NULL;
+    struct sockaddr_in addr;
+    char name[SZ_CHAR_BUFF];
+    time_t now = 0;
+    int rc = 0;
+
+    pthread_mutex_lock(&pnr->lock);
+    pnr->thread_complete = 1;
+    while (pnr->shutdown == 0) {
+        if (pnr->q_count == 0) {
+            pthread_cond_wait(&pnr->wakeup, &pnr->lock);
+            continue;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = pnr->queue[pnr->q_head];
+        pnr->q_head = (pnr->q_head + 1) % ARY_MAX_RESOLVER;
+        pnr->q_count--;
+        pthread_mutex_unlock(&pnr->lock);
+
+        rc = getnameinfo((struct sockaddr *) &addr, sizeof(addr), name, sizeof(name), NULL, 0, NI_NAMEREQD | NI_DGRAM);
+
+        pthread_mutex_lock(&pnr->lock);
+        now = time(NULL);
+        pre = skn_resolver_slot(pnr, addr.sin_addr.s_addr);
+        if (pre == NULL) {
+            continue;
+        }
+        if (rc == 0) {
+            snprintf(pre->name, sizeof(pre->name), "%s", name);
+            pre->state = SKN_RESOLVER_RESOLVED;
+            pre->expires = now + SKN_RESOLVER_TTL;
+            pnr->resolved++;
+        } else {
+            skn_logger(SD_DEBUG, "NameResolver: %s has no name: %s", inet_ntoa(addr.sin_addr), gai_strerror(rc));
+            pre->name[0] = 0;
+            pre->state = SKN_RESOLVER_FAILED;
+            pre->expires = now + SKN_RESOLVER_NEGATIVE_TTL;
+            pnr->failed++;
+        }
+    }
+    pnr->thread_complete = 0;
+    pthread_mutex_unlock(&pnr->lock);
+
+    return NULL;
+}
+
+/**
+ * skn_resolver_startup()
+ * - starts the resolver thread, once
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int skn_resolver_startup() {
+    PNameResolver pnr = &gs_resolver;
+    pthread_attr_t attr;
+    int rc = EXIT_SUCCESS;
+
+    pthread_once(&gs_resolver_once, skn_resolver_initialize);
+
+    pthread_mutex_lock(&pnr->lock);
+    if (pnr->thread_complete == 0 && pnr->shutdown == 0) {
+        /* detached: a shutdown never waits on a slow getnameinfo() */
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&pnr->resolver_thread, &attr, skn_resolver_thread, (void *) pnr) != 0) {
+            skn_logger(SD_WARNING, "NameResolver: Create thread failed: %s", strerror(errno));
+            rc = EXIT_FAILURE;
+        } else {
+            pnr->thread_complete = 1;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_mutex_unlock(&pnr->lock);
+
+    return rc;
+}
+
+/**
+ * skn_resolver_shutdown()
+ * - stops the resolver thread and logs the cache counters
+ */
+void skn_resolver_shutdown() {
+    PNameResolver pnr = &gs_resolver;
+
+    pthread_once(&gs_resolver_once, skn_resolver_initialize);
+
+    pthread_mutex_lock(&pnr->lock);
+    pnr->shutdown = 1;
+    pthread_cond_broadcast(&pnr->wakeup);
+    pthread_mutex_unlock(&pnr->lock);
+
+    skn_resolver_log_counters();
+}
+
+/**
+ * skn_resolver_host_name()
+ * - copies the cached host name for paddr into name
+ * - on a miss, copies the numeric address and queues a lookup
+ *
+ * - returns TRUE when name came from the cache, FALSE when numeric
+ */
+int skn_resolver_host_name(struct sockaddr_in *paddr, char *name, int len) {
+    PNameResolver pnr = &gs_resolver;
+    PResolverEntry pre = NULL;
+    time_t now = time(NULL);
+    int found = FALSE;
+
+    if (pnr->thread_complete == 0 && pnr->shutdown == 0) {
+        skn_resolver_startup();
+    }
+
+    pthread_mutex_lock(&pnr->lock);
+    pre = skn_resolver_slot(pnr, paddr->sin_addr.s_addr);
+    if (pre != NULL) {
+        if (pre->state == SKN_RESOLVER_RESOLVED && pre->expires > now) {
+            strncpy(name, pre->name, len - 1);
+            name[len - 1] = 0;
+            pnr->hits++;
+            found = TRUE;
+        } else if (pre->state == SKN_RESOLVER_FAILED && pre->expires > now) {
+            pnr->negative_hits++;
+        } else if (pre->state != SKN_RESOLVER_PENDING) {
+            if (pnr->q_count < ARY_MAX_RESOLVER && pnr->shutdown == 0) {
+                pnr->queue[(pnr->q_head + pnr->q_count) % ARY_MAX_RESOLVER] = pre->addr;
+                pnr->q_count++;
+                pre->state = SKN_RESOLVER_PENDING;
+                pthread_cond_signal(&pnr->wakeup);
+            }
+            pnr->misses++;
+        } else {
+            pnr->misses++;
+        }
+    } else {
+        pnr->misses++;
+    }
+    pthread_mutex_unlock(&pnr->lock);
+
+    if (found == FALSE) {
+        inet_ntop(AF_INET, &paddr->sin_addr, name, len);
+    }
+
+    return found;
+}
+
+void skn_resolver_log_counters() {
+    PNameResolver pnr = &gs_resolver;
+
+    pthread_once(&gs_resolver_once, skn_resolver_initialize);
+
+    pthread_mutex_lock(&pnr->lock);
+    skn_logger(SD_NOTICE, "NameResolver: hits=%lu, negative_hits=%lu, misses=%lu, resolved=%lu, failed=%lu",
+               pnr->hits, pnr->negative_hits, pnr->misses, pnr->resolved, pnr->failed);
+    pthread_mutex_unlock(&pnr->lock);
+}
@@ -19,6 +19,21 @@ int gd_i_socket = -1;
 int gd_i_display = 0;
 int gd_i_update = 0;
 int gd_i_unique_registry = 0;
+int gd_i_workers = 0;
+int gd_i_batch_size = SKN_UDP_BATCH_DEFAULT;
+int gd_i_quorum = 0;
+int gd_i_lease = SKN_LEASE_TTL;
+int gd_i_wire = SKN_WIRE_TEXT;
+int gd_i_jitter = SKN_REPLY_JITTER;
+char * gd_pch_discovery_cache = SKN_DISCOVERY_CACHE_FILE;
+char * gd_pch_multicast_group = SKN_MULTICAST_GROUP;
+int gd_i_multicast_ttl = SKN_MULTICAST_TTL;
+int gd_i_locator_port = SKN_FIND_RPI_PORT;
+char * gd_pch_replicate = NULL;
+char * gd_pch_shared_registry = SKN_SHARED_REGISTRY_NAME;
+int gd_i_rate_limit = SKN_RATE_LIMIT;
+int gd_i_relay = 0;
+char * gd_pch_relay_host = NULL;
 char gd_ch_ipAddress[SZ_CHAR_BUFF];
 char gd_ch_intfName[SZ_CHAR_BUFF];
 char gd_ch_hostName[SZ_CHAR_BUFF];
@@ -28,12 +43,57 @@ int gd_i_i2c_address = 0;
 
 static void skn_locator_print_usage();
 static void exit_handler(int sig);
-
-
-static void * service_registry_entry_create_helper(char *key, char **name, char **ip, char **port);
-static PServiceRegistry service_registry_create();
-static int service_registry_entry_create(PServiceRegistry psreg, char *name, char *ip, char *port, int *errors);
+static int skn_udp_host_set_receive_timeout(int i_socket, double rcvTimeout);
+
+
+static void * service_registry_arena_alloc(PRegistryArena pra, size_t size);
+static void service_registry_arena_release(PRegistryArena pra);
+static uint32_t service_registry_hash(const char *value, size_t len);
+static uint32_t service_registry_hash_key(const char *name, const char *ip, int port);
+static const char * service_registry_intern(PServiceRegistry psreg, const char *value, size_t len, int add);
+static int * service_registry_index_slot(PServiceRegistry psreg, const char *name, const char *ip, int port);
+static void service_registry_index_add(PServiceRegistry psreg, int position);
+static int service_registry_resize(PServiceRegistry psreg, int capacity);
+static void service_registry_span_strip(PRegistrySpan psp);
+static PRegistrySpan service_registry_record_field(PRegistryRecord prec, PRegistrySpan pkey);
+static int service_registry_response_record(PRegistryRecord prec, void *context);
+static int service_registry_entry_add(PServiceRegistry psreg, const char *iname, const char *iip, uint16_t iport);
 static int service_registry_response_parse(PServiceRegistry psreg, const char *response, int *errors);
+static int service_registry_broadcast_request(int i_socket, char *request);
+static int service_registry_multicast_request(int i_socket, char *request);
+static int service_registry_request_encode(char *request, char *binary, int size);
+static int service_registry_discovery_record(PRegistryRecord prec, void *context);
+static int service_registry_discovery_remaining(struct timespec *pdeadline);
+static void service_registry_discovery_send(int i_socket, char *request, PDiscoveryRequest pdr);
+static void service_registry_discovery_round(PDiscoveryRequest pdr, struct timespec *pstart, long long window, int round, struct timespec *pnext);
+static int service_registry_discovery_wait(int i_socket, struct timespec *pdeadline);
+static int service_registry_view_record(PRegistryRecord prec, void *context);
+static int service_registry_view_apply(PRegistryView prv, char **page, int pages);
+
+static PServiceProvider service_registry_provider_create(char *response, int workers);
+static void service_registry_provider_destroy(PServiceProvider psp);
+static void service_registry_provider_base(PServiceProvider psp, struct in_addr addr);
+static void service_registry_provider_readdress(PServiceProvider psp, PInterfaceSnapshot pis);
+static int service_registry_provider_worker(PProviderWorker pw);
+static int service_registry_provider_on_request(void *pem, void *pes);
+static int service_registry_provider_on_signal(void *pem, void *pes);
+static void * service_registry_provider_worker_thread(void * ptr);
+static int service_registry_provider_is_broadcast(PInterfaceSnapshot pis, struct msghdr *pmsg);
+static int service_registry_provider_is_sibling_copy(PProviderWorker pw, struct sockaddr_in *premaddr);
+static void service_registry_provider_worker_stats(PProviderWorker pw, int final);
+static int service_registry_provider_lease(PRegistryRecord prec, void *context);
+static void service_registry_provider_on_expire(PWheelTimer pwt, void *context);
+static int service_registry_provider_on_tick(void *pem, void *pes);
+static int service_registry_provider_pin(PRegistryRecord prec, void *context);
+static struct in_addr service_registry_lease_addr(PRegistryLease pl);
+static int service_registry_provider_paginate(PServiceProvider psp, int full, unsigned long since,
+                                              int (*emit)(const char *page, int len, void *context), void *context);
+static int service_registry_provider_store_page(const char *page, int len, void *context);
+static int service_registry_provider_send_page(const char *page, int len, void *context);
+static int service_registry_provider_answer(PServiceProvider psp, PRegistryQuery prq, int binary, char *answer, int size);
+static int service_registry_provider_defer(PProviderWorker pw, struct sockaddr_in *premaddr, const char *data, int len, int delay);
+static void service_registry_provider_deferred_arm(PProviderWorker pw);
+static int service_registry_provider_on_deferred(void *pem, void *pes);
 
 /*
  * General System Information Utils */
@@ -194,11 +254,12 @@ void signals_cleanup(int sig) {
 
 
 void get_default_interface_name_and_ipv4_address(char * intf, char * ipv4) {
-    IPBroadcastArray aB;
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    PInterfaceEntry pie = skn_interface_cache_default(pis);
 
-    if (get_broadcast_ip_array(&aB) != PLATFORM_ERROR) {
-        memcpy(intf, aB.chDefaultIntfName, SZ_CHAR_BUFF);
-        memcpy(ipv4, aB.ipAddrStr[aB.defaultIndex], SZ_CHAR_BUFF);
+    if (pie != NULL) {
+        strncpy(intf, pis->defaultName, SZ_CHAR_BUFF - 1);
+        inet_ntop(AF_INET, &pie->addr, ipv4, SZ_CHAR_BUFF);
     } else {
         skn_logger(SD_ERR, "InterfaceName and Address: unable to access information.");
     }
@@ -210,109 +271,52 @@ void get_default_interface_name_and_ipv4_address(char * intf, char * ipv4) {
  * - Affects the PIPBroadcastArray
  * - Return -1 on error, or count of interfaces
  * - contains this ipAddress in paB->ipAddrStr[paB->defaultIndex]
+ * - formats the interface cache snapshot; callers that only need the
+ *   binary addresses should read skn_interface_cache_snapshot() instead
  */
 int get_broadcast_ip_array(PIPBroadcastArray paB) {
-    struct ifaddrs * ifap;
-    struct ifaddrs * p;
-    int rc = 0;
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    PInterfaceEntry pie = NULL;
+    int index = 0;
 
     memset(paB, 0, sizeof(IPBroadcastArray));
     paB->count = 0;
     paB->defaultIndex = 0;
     strcpy(paB->cbName, "IPBroadcastArray");
 
-    rc = get_default_interface_name(paB->chDefaultIntfName);
-    if (rc == EXIT_FAILURE) { // Alternate method for Mac: 'route -n -A inet'
-        skn_logger(SD_ERR, "No Default Network Interfaces Found!.");
-        paB->chDefaultIntfName[0] = 0;
-    }
-    rc = getifaddrs(&ifap);
-    if (rc != 0) {
-        skn_logger(SD_ERR, "No Network Interfaces Found at All ! %d:%d:%s", rc, errno, strerror(errno) );
+    if (pis == NULL) {
+        skn_logger(SD_ERR, "No Network Interfaces Found at All !");
         return (PLATFORM_ERROR);
     }
-    p = ifap;
-
-    while (p && paB->count < ARY_MAX_INTF) {
-        if (p->ifa_addr != NULL && p->ifa_addr->sa_family == AF_INET && ((p->ifa_flags & IFF_BROADCAST) > 0)) {
-
-            inet_ntop(p->ifa_addr->sa_family, &((struct sockaddr_in *) p->ifa_addr)->sin_addr, paB->ipAddrStr[paB->count], (SZ_CHAR_BUFF - 1));
-            inet_ntop(p->ifa_addr->sa_family, &((struct sockaddr_in *) p->ifa_netmask)->sin_addr, paB->maskAddrStr[paB->count], (SZ_CHAR_BUFF - 1));
-            inet_ntop(p->ifa_addr->sa_family, &((struct sockaddr_in *) p->ifa_broadaddr)->sin_addr, paB->broadAddrStr[paB->count], (SZ_CHAR_BUFF - 1));
-
-            strncpy(paB->ifNameStr[paB->count], p->ifa_name, (SZ_CHAR_BUFF -1));
 
-            /* Take match as the default */
-            if (strcmp(paB->chDefaultIntfName, p->ifa_name) == 0) {
-                paB->defaultIndex = paB->count;
-            }
-
-            paB->count++;
-        }
-        p = p->ifa_next;
-    } // end while
-    freeifaddrs(ifap);
+    strncpy(paB->chDefaultIntfName, pis->defaultName, (SZ_CHAR_BUFF - 1));
+    paB->defaultIndex = pis->defaultIndex;
+    for (index = 0; index < pis->count; index++) {
+        pie = &pis->entry[index];
+        inet_ntop(AF_INET, &pie->addr, paB->ipAddrStr[index], (SZ_CHAR_BUFF - 1));
+        inet_ntop(AF_INET, &pie->mask, paB->maskAddrStr[index], (SZ_CHAR_BUFF - 1));
+        inet_ntop(AF_INET, &pie->broadcast, paB->broadAddrStr[index], (SZ_CHAR_BUFF - 1));
+        strncpy(paB->ifNameStr[index], pie->name, (SZ_CHAR_BUFF - 1));
+    }
+    paB->count = pis->count;
 
     return paB->count;
 }
 
 /**
  * Retrieves default internet interface name into param
- * - absolute best way to do this, but not supported on Darwin(i.e OSX)
+ * - read from the interface cache, which follows the kernel's default route
  * return EXIT_SUCCESS or EXIT_FAILURE
- *
- * [jscott@jscott5365m OSX]$ route -n get 0.0.0.0
- *   route to: default
- *destination: default
- *       mask: default
- *    gateway: 10.21.1.254
- *  interface: en3
- *      flags: <UP,GATEWAY,DONE,STATIC,PRCLONING>
- * recvpipe  sendpipe  ssthresh  rtt,msec    rttvar  hopcount      mtu     expire
- *       0         0         0         0         0         0      1500         0
- *
-*/
+ */
 int get_default_interface_name(char *pchDefaultInterfaceName) {
-    FILE *f_route;
-    char line[SZ_INFO_BUFF], *dRoute = NULL, *iName = NULL;
-
-    f_route = fopen("/proc/net/route", "r");
-    if (f_route != NULL) {
-        while (fgets(line, SZ_INFO_BUFF - 1, f_route)) {
-            iName = strtok(line, "\t");
-            dRoute = strtok(NULL, "\t");
-
-            if (iName != NULL && dRoute != NULL) {
-                if (strcmp(dRoute, "00000000") == 0) {
-                    strncpy(pchDefaultInterfaceName, iName, (SZ_INFO_BUFF - 1));
-                    break;
-                }
-            }
-        }
-        fclose(f_route);
-
-        return EXIT_SUCCESS;
-    }
-    skn_logger(SD_ERR, "Opening ProcFs for RouteInfo Failed: %d:%s, Alternate method will be attempted.", errno, strerror(errno));
-
-    f_route = popen("route -n get 0.0.0.0", "r"); // for linux 'route -n -A inet', with interface at line_word[7]
-    if (f_route != NULL) {
-        while (fgets(line, SZ_INFO_BUFF - 1, f_route)) {
-            dRoute = strtok(line, ":");
-            iName = strtok(NULL, "\n");
-            if (strcmp(skn_strip(dRoute), "interface") == 0) {
-                strncpy(pchDefaultInterfaceName, skn_strip(iName), (SZ_INFO_BUFF - 1));
-                break;
-            }
-        }
-        fclose(f_route);
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
 
-        return EXIT_SUCCESS;
-    } else {
-        skn_logger(SD_ERR, "Alternate method to get RouteInfo Failed: %d:%s", errno, strerror(errno));
+    if ((pis == NULL) || (pis->defaultName[0] == 0)) {
         return EXIT_FAILURE;
     }
+    strncpy(pchDefaultInterfaceName, pis->defaultName, IF_NAMESIZE);
 
+    return EXIT_SUCCESS;
 }
 
 /**************************************************************************
@@ -332,12 +336,19 @@ static void skn_locator_print_usage() {
     skn_logger(" ", "%s -- %s", gd_ch_program_name, gd_ch_program_desc);
     skn_logger(" ", "\tSkoona Development <skoona@gmail.com>");
     if (strcmp(gd_ch_program_name, "udp_locator_client") == 0) {
-        skn_logger(" ", "Usage:\n  %s [-v] [-m 'any text msg'] [-u] [-h|--help]", gd_ch_program_name);
+        skn_logger(" ", "Usage:\n  %s [-v] [-m 'any text msg'] [-u] [-q dd] [-n dd] [-e text|binary] [-g group] [-t dd] [-o a.b.c.d] [-h|--help]", gd_ch_program_name);
         skn_logger(" ", "\nOptions:");
         skn_logger(" ", "  -u, --unique-registry\t List unique entries from all responses.");
+        skn_logger(" ", "  -q, --quorum=dd\tStop listening once dd providers hold the service. | [0=wait for all]");
+        skn_logger(" ", "  -n, --non-stop=DD\tRefresh a paged copy of one locator's registry every DD seconds,");
+        skn_logger(" ", "                       only changes are sent after the first. Until ctrl-break.");
+        skn_logger(" ", "  -e, --encoding=binary\tAsk locators for the binary registry format. | [text]");
+        skn_logger(" ", "  -g, --multicast-group=a.b.c.d\tFirst --quorum round goes to this group. | ['%s', 'none']", SKN_MULTICAST_GROUP);
+        skn_logger(" ", "  -t, --multicast-ttl=dd\tHops a multicast query may travel. | [%d]", SKN_MULTICAST_TTL);
+        skn_logger(" ", "  -o, --relay-host=a.b.c.d\tAsk only this relay locator, by unicast, for another subnet's registry.");
         skn_logger(" ", "  -m, --message\tAny text to send; 'stop' cause service to terminate.");
     } else if (strcmp(gd_ch_program_name, "udp_locator_service") == 0) {
-        skn_logger(" ", "Usage:\n  %s [-s] [-v] [-m '<delimited-response-message-string>'] [-a 'my_service_name'] [-h|--help]", gd_ch_program_name);
+        skn_logger(" ", "Usage:\n  %s [-s] [-v] [-m '<delimited-response-message-string>'] [-a 'my_service_name'] [-w dd] [-b dd] [-l dd] [-j ms] [-g group] [-p dd] [-r ip:port,...] [-k /name] [-x dd] [-f dd] [-h|--help]", gd_ch_program_name);
         skn_logger(" ", "  Format: name=<service-name>,ip=<service-ipaddress>ddd.ddd.ddd.ddd,port=<service-portnumber>ddddd <line-delimiter>");
         skn_logger(" ", "  REQUIRED   <line-delimiter> is one of these '|', '%', ';'");
         skn_logger(" ", "  example: -m 'name=rpi_locator_service,ip=192.168.1.15,port=48028|name=lcd_display_service, ip=192.168.1.15, port=48029|'");
@@ -345,20 +356,46 @@ static void skn_locator_print_usage() {
         skn_logger(" ", "  -a, --alt-service-name=my_service_name");
         skn_logger(" ", "                       lcd_display_service is default, use this to change name.");
         skn_logger(" ", "  -s, --include-display-service\tInclude DisplayService entry in default registry.");
+        skn_logger(" ", "  -w, --workers=dd\tNumber of SO_REUSEPORT worker threads. | [0=cpu cores]");
+        skn_logger(" ", "  -b, --batch-size=dd\tDatagrams per recvmmsg/sendmmsg.    | [1=no batching, 16]");
+        skn_logger(" ", "  -l, --lease=dd\tSeconds an ADDed entry lives unless ADDed again. | [%d]", SKN_LEASE_TTL);
+        skn_logger(" ", "  -j, --jitter=ms\tMost a broadcast request's reply is held back. | [%d, 0=none]", SKN_REPLY_JITTER);
+        skn_logger(" ", "  -g, --multicast-group=a.b.c.d\tDiscovery group joined on every interface. | ['%s', 'none']", SKN_MULTICAST_GROUP);
+        skn_logger(" ", "  -p, --port=dd\tPort to answer locator requests on. | [%d]", SKN_FIND_RPI_PORT);
+        skn_logger(" ", "  -r, --replicate=ip:port,...\tPeer locators to replicate the registry with;");
+        skn_logger(" ", "                       peers they know of are found from them.");
+        skn_logger(" ", "  -k, --shared-registry=/name\tShared memory the registry is published to. | ['%s', 'none']", SKN_SHARED_REGISTRY_NAME);
+        skn_logger(" ", "  -x, --rate-limit=dd\tRequests/sec taken from one address, the rest shed. | [%d, 0=unlimited]", SKN_RATE_LIMIT);
+        skn_logger(" ", "  -f, --relay=dd\tPoll the local segments every dd seconds and serve what they list");
+        skn_logger(" ", "                       to other subnets. | [0=off, %d-%d]", SKN_RELAY_MIN_INTERVAL, SKN_MAX_RELAY_INTERVAL);
     } else if (strcmp(gd_ch_program_name, "lcd_display_client") == 0) {
-        skn_logger(" ", "Usage:\n  %s [-v] [-m 'message for display'] [-n 1|300] [-a 'my_service_name'] [-h|--help]", gd_ch_program_name);
+        skn_logger(" ", "Usage:\n  %s [-v] [-m 'message for display'] [-n 1|300] [-a 'my_service_name'] [-q dd] [-c path] [-k /name] [-e text|binary] [-g group] [-t dd] [-o a.b.c.d] [-h|--help]", gd_ch_program_name);
         skn_logger(" ", "\nOptions:");
         skn_logger(" ", "  -a, --alt-service-name=my_service_name");
         skn_logger(" ", "                       lcd_display_service is default, use this to change name.");
         skn_logger(" ", "  -m, --message\tRequest message to send.");
         skn_logger(" ", "  -n, --non-stop=DD\tContinue to send updates every DD seconds until ctrl-break.");
+        skn_logger(" ", "  -q, --quorum=dd\tStop listening once dd providers hold the service. | [1, 0=wait for all]");
+        skn_logger(" ", "  -c, --cache-file=path\tDiscovery cache, 'none' disables. | ['%s']", SKN_DISCOVERY_CACHE_FILE);
+        skn_logger(" ", "  -k, --shared-registry=/name\tLocal locator's registry, read before any discovery. | ['%s', 'none']", SKN_SHARED_REGISTRY_NAME);
+        skn_logger(" ", "  -e, --encoding=binary\tBinary registry and display messages, where the peer supports it. | [text]");
+        skn_logger(" ", "  -g, --multicast-group=a.b.c.d\tAsk this group first, then broadcast. | ['%s', 'none']", SKN_MULTICAST_GROUP);
+        skn_logger(" ", "  -t, --multicast-ttl=dd\tHops a multicast query may travel. | [%d]", SKN_MULTICAST_TTL);
+        skn_logger(" ", "  -o, --relay-host=a.b.c.d\tAsk only this relay locator, by unicast. | [discover]");
     } else if (strcmp(gd_ch_program_name, "a2d_display_client") == 0) {
-        skn_logger(" ", "Usage:\n  %s [-v] [-n 1|300] [-i ddd] [-a 'my_service_name'] [-h|--help]", gd_ch_program_name);
+        skn_logger(" ", "Usage:\n  %s [-v] [-n 1|300] [-i ddd] [-a 'my_service_name'] [-q dd] [-c path] [-k /name] [-e text|binary] [-g group] [-t dd] [-o a.b.c.d] [-h|--help]", gd_ch_program_name);
         skn_logger(" ", "\nOptions:");
         skn_logger(" ", "  -a, --alt-service-name=my_service_name");
         skn_logger(" ", "                       lcd_display_service is default, use this to change target.");
         skn_logger(" ", "  -i, --i2c-address=ddd\tI2C decimal address. | [0x27=39, 0x20=32]");
         skn_logger(" ", "  -n, --non-stop=DD\tContinue to send updates every DD seconds until ctrl-break.");
+        skn_logger(" ", "  -q, --quorum=dd\tStop listening once dd providers hold the service. | [1, 0=wait for all]");
+        skn_logger(" ", "  -c, --cache-file=path\tDiscovery cache, 'none' disables. | ['%s']", SKN_DISCOVERY_CACHE_FILE);
+        skn_logger(" ", "  -k, --shared-registry=/name\tLocal locator's registry, read before any discovery. | ['%s', 'none']", SKN_SHARED_REGISTRY_NAME);
+        skn_logger(" ", "  -e, --encoding=binary\tBinary registry and display messages, where the peer supports it. | [text]");
+        skn_logger(" ", "  -g, --multicast-group=a.b.c.d\tAsk this group first, then broadcast. | ['%s', 'none']", SKN_MULTICAST_GROUP);
+        skn_logger(" ", "  -t, --multicast-ttl=dd\tHops a multicast query may travel. | [%d]", SKN_MULTICAST_TTL);
+        skn_logger(" ", "  -o, --relay-host=a.b.c.d\tAsk only this relay locator, by unicast. | [discover]");
     }
     skn_logger(" ", "  -v, --version\tVersion printout.");
     skn_logger(" ", "  -h, --help\t\tShow this help screen.");
@@ -373,6 +410,7 @@ static void skn_locator_print_usage() {
 int skn_handle_locator_command_line(int argc, char **argv) {
     int opt = 0;
     int longindex = 0;
+    struct in_addr group;
     struct option longopts[] = { { "include-display-service", 0, NULL, 's' }, /* set true if present */
                                  { "alt-service-name", 1, NULL, 'a' }, /* set true if present */
                                  { "unique-registry", 0, NULL, 'u' }, /* set true if present */
@@ -380,6 +418,21 @@ int skn_handle_locator_command_line(int argc, char **argv) {
                                  { "debug", 1, NULL, 'd' }, /* required param if */
                                  { "message", 1, NULL, 'm' }, /* required param if */
                                  { "i2c-address", 1, NULL, 'i' }, /* required param if */
+                                 { "workers", 1, NULL, 'w' }, /* required param if */
+                                 { "batch-size", 1, NULL, 'b' }, /* required param if */
+                                 { "quorum", 1, NULL, 'q' }, /* required param if */
+                                 { "cache-file", 1, NULL, 'c' }, /* required param if */
+                                 { "lease", 1, NULL, 'l' }, /* required param if */
+                                 { "encoding", 1, NULL, 'e' }, /* required param if */
+                                 { "jitter", 1, NULL, 'j' }, /* required param if */
+                                 { "multicast-group", 1, NULL, 'g' }, /* required param if */
+                                 { "multicast-ttl", 1, NULL, 't' }, /* required param if */
+                                 { "port", 1, NULL, 'p' }, /* required param if */
+                                 { "replicate", 1, NULL, 'r' }, /* required param if */
+                                 { "shared-registry", 1, NULL, 'k' }, /* required param if */
+                                 { "rate-limit", 1, NULL, 'x' }, /* required param if */
+                                 { "relay", 1, NULL, 'f' }, /* required param if */
+                                 { "relay-host", 1, NULL, 'o' }, /* required param if */
                                  { "version", 0, NULL, 'v' }, /* set true if present */
                                  { "help", 0, NULL, 'h' }, /* set true if present */
                                  { 0, 0, 0, 0 } };
@@ -391,7 +444,7 @@ int skn_handle_locator_command_line(int argc, char **argv) {
      *  optarg is value attached(-d88) or next element(-d 88) of argv
      *  opterr flags a scanning error
      */
-    while ((opt = getopt_long(argc, argv, "d:m:n:i:a:usvh", longopts, &longindex)) != -1) {
+    while ((opt = getopt_long(argc, argv, "d:m:n:i:a:w:b:q:c:l:e:j:g:t:p:r:k:x:f:o:usvh", longopts, &longindex)) != -1) {
         switch (opt) {
             case 'u':
                 gd_i_unique_registry = 1;
@@ -440,6 +493,162 @@ int skn_handle_locator_command_line(int argc, char **argv) {
                     return (EXIT_FAILURE);
                 }
                 break;
+            case 'w':
+                if (optarg) {
+                    gd_i_workers = atoi(optarg);
+                    if (gd_i_workers < 0 || gd_i_workers > ARY_MAX_WORKERS) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, ARY_MAX_WORKERS, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                if (optarg) {
+                    gd_i_batch_size = atoi(optarg);
+                    if (gd_i_batch_size < 1 || gd_i_batch_size > ARY_MAX_BATCH) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 1-%d) %c[%d:%d:%d]\n", gd_ch_program_name, ARY_MAX_BATCH, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'q':
+                if (optarg) {
+                    gd_i_quorum = atoi(optarg);
+                    if (gd_i_quorum < 0 || gd_i_quorum > ARY_MAX_RESPONDERS) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, ARY_MAX_RESPONDERS, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'l':
+                if (optarg) {
+                    gd_i_lease = atoi(optarg);
+                    if (gd_i_lease < 1 || gd_i_lease >= (int) (SKN_WHEEL_SPAN * SKN_LEASE_TICK)) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 1-%lu) %c[%d:%d:%d]\n", gd_ch_program_name, (unsigned long) (SKN_WHEEL_SPAN * SKN_LEASE_TICK) - 1, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'e':
+                if (optarg && (strcmp(optarg, "binary") == 0 || strcmp(optarg, "text") == 0)) {
+                    gd_i_wire = (strcmp(optarg, "binary") == 0 ? SKN_WIRE_BINARY : SKN_WIRE_TEXT);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! (allowed text|binary) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'j':
+                if (optarg) {
+                    gd_i_jitter = atoi(optarg);
+                    if (gd_i_jitter < 0 || gd_i_jitter > SKN_MAX_JITTER) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_JITTER, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'g':
+                if (optarg && ((strcmp(optarg, "none") == 0) || ((inet_pton(AF_INET, optarg, &group) == 1) && IN_MULTICAST(ntohl(group.s_addr))))) {
+                    gd_pch_multicast_group = strdup(optarg);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 224.0.0.0-239.255.255.255|none) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 't':
+                if (optarg) {
+                    gd_i_multicast_ttl = atoi(optarg);
+                    if (gd_i_multicast_ttl < 1 || gd_i_multicast_ttl > SKN_MAX_MULTICAST_TTL) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 1-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_MULTICAST_TTL, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                if (optarg) {
+                    gd_i_locator_port = atoi(optarg);
+                    if (gd_i_locator_port < 1 || gd_i_locator_port > 0xFFFF) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 1-65535) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                if (optarg) {
+                    gd_pch_replicate = strdup(optarg);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'x':
+                if (optarg) {
+                    gd_i_rate_limit = atoi(optarg);
+                    if (gd_i_rate_limit < 0 || gd_i_rate_limit > SKN_MAX_RATE_LIMIT) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_RATE_LIMIT, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+                if (optarg) {
+                    gd_i_relay = atoi(optarg);
+                    if ((gd_i_relay != 0) && (gd_i_relay < SKN_RELAY_MIN_INTERVAL || gd_i_relay > SKN_MAX_RELAY_INTERVAL)) {
+                        skn_logger(SD_WARNING, "%s: input param was invalid! (allowed 0 or %d-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_RELAY_MIN_INTERVAL, SKN_MAX_RELAY_INTERVAL, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'o':
+                if (optarg && (inet_pton(AF_INET, optarg, &group) == 1)) {
+                    gd_pch_relay_host = strdup(optarg);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! (allowed a.b.c.d) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'k':
+                if (optarg && ((strcmp(optarg, "none") == 0) || ((optarg[0] == '/') && (strchr(&optarg[1], '/') == NULL) && (strlen(optarg) < SZ_CHAR_LABEL)))) {
+                    gd_pch_shared_registry = strdup(optarg);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! (allowed /name|none) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                if (optarg) {
+                    gd_pch_discovery_cache = strdup(optarg);
+                } else {
+                    skn_logger(SD_WARNING, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
             case 'v':
                 skn_logger(SD_WARNING, "\n\tProgram => %s\n\tVersion => %s\n\tSkoona Development\n\t<skoona@gmail.com>\n", gd_ch_program_name, PACKAGE_VERSION);
                 return (EXIT_FAILURE);
@@ -518,6 +727,37 @@ int skn_logger(const char *level, const char *format, ...) {
     return fprintf(stderr, "%s%s\n", logLevel, buffer);
 }
 
+/**
+ * skn_udp_host_set_receive_timeout()
+ * - a positive rcvTimeout sets SO_RCVTIMEO for blocking callers
+ * - zero or less makes the socket non-blocking, for use with an EventManager
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int skn_udp_host_set_receive_timeout(int i_socket, double rcvTimeout) {
+    struct timeval tv;
+    int flags = 0;
+
+    if (rcvTimeout <= 0.0) {
+        flags = fcntl(i_socket, F_GETFL, 0);
+        if ((flags == PLATFORM_ERROR) || (fcntl(i_socket, F_SETFL, flags | O_NONBLOCK) == PLATFORM_ERROR)) {
+            skn_logger(SD_EMERG, "Set Socket NonBlocking Option error=%d, etext=%s", errno, strerror(errno));
+            return (EXIT_FAILURE);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    tv.tv_sec = rcvTimeout;
+    tv.tv_usec = (long) ((rcvTimeout - tv.tv_sec) * 1000000L);
+    skn_logger(SD_INFO, "Set Socket RcvTimeout Option set to: tv_sec=%ld, tv_usec=%ld", tv.tv_sec, tv.tv_usec);
+    if ((setsockopt(i_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv))) < 0) {
+        skn_logger(SD_EMERG, "Set Socket RcvTimeout Option error=%d, etext=%s", errno, strerror(errno));
+        return (EXIT_FAILURE);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /**
  * skn_udp_host_create_regular_socket()
  * - creates a dgram socket without broadcast enabled
@@ -538,11 +778,7 @@ int skn_udp_host_create_regular_socket(int port, double rcvTimeout) {
         return (EXIT_FAILURE);
     }
 
-    struct timeval tv;
-    tv.tv_sec = rcvTimeout;
-    tv.tv_usec = (long)(rcvTimeout - tv.tv_sec) * 1000000L;
-    if ((setsockopt(i_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv))) < 0) {
-        skn_logger(SD_EMERG, "Set Socket RcvTimeout Option error=%d, etext=%s", errno, strerror(errno));
+    if (skn_udp_host_set_receive_timeout(i_socket, rcvTimeout) == EXIT_FAILURE) {
         return (EXIT_FAILURE);
     }
 
@@ -578,12 +814,56 @@ int skn_udp_host_create_broadcast_socket(int port, double rcvTimeout) {
         return (EXIT_FAILURE);
     }
 
-    struct timeval tv;
-    tv.tv_sec = rcvTimeout;
-    tv.tv_usec = (long)(rcvTimeout - tv.tv_sec) * 1000000L;
-    skn_logger(SD_INFO, "Set Socket RcvTimeout Option set to: tv_sec=%ld, tv_usec=%ld", tv.tv_sec, tv.tv_usec);
-    if ((setsockopt(i_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv))) < 0) {
-        skn_logger(SD_EMERG, "Set Socket RcvTimeout Option error=%d, etext=%s", errno, strerror(errno));
+    if (skn_udp_host_set_receive_timeout(i_socket, rcvTimeout) == EXIT_FAILURE) {
+        return (EXIT_FAILURE);
+    }
+
+    /* set up local address */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(i_socket, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        skn_logger(SD_EMERG, "Bind to local Socket error=%d, etext=%s", errno, strerror(errno));
+        return (EXIT_FAILURE);
+    }
+
+    return i_socket;
+}
+
+/**
+ * skn_udp_host_create_reuseport_socket()
+ * - creates a dgram socket with broadcast and SO_REUSEPORT enabled
+ * - IP_PKTINFO is enabled so workers can tell broadcast copies from unicast
+ *
+ * - returns i_socket | EXIT_FAILURE
+ */
+int skn_udp_host_create_reuseport_socket(int port, double rcvTimeout) {
+    struct sockaddr_in addr;
+    int i_socket, optEnable = 1;
+
+    if ((i_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+        skn_logger(SD_EMERG, "Create Socket error=%d, etext=%s", errno, strerror(errno));
+        return (EXIT_FAILURE);
+    }
+    if ((setsockopt(i_socket, SOL_SOCKET, SO_BROADCAST, &optEnable, sizeof(optEnable))) < 0) {
+        skn_logger(SD_EMERG, "Set Socket Broadcast Option error=%d, etext=%s", errno, strerror(errno));
+        close(i_socket);
+        return (EXIT_FAILURE);
+    }
+    if ((setsockopt(i_socket, SOL_SOCKET, SO_REUSEPORT, &optEnable, sizeof(optEnable))) < 0) {
+        skn_logger(SD_EMERG, "Set Socket ReusePort Option error=%d, etext=%s", errno, strerror(errno));
+        close(i_socket);
+        return (EXIT_FAILURE);
+    }
+    if ((setsockopt(i_socket, IPPROTO_IP, IP_PKTINFO, &optEnable, sizeof(optEnable))) < 0) {
+        skn_logger(SD_EMERG, "Set Socket PktInfo Option error=%d, etext=%s", errno, strerror(errno));
+        close(i_socket);
+        return (EXIT_FAILURE);
+    }
+
+    if (skn_udp_host_set_receive_timeout(i_socket, rcvTimeout) == EXIT_FAILURE) {
+        close(i_socket);
         return (EXIT_FAILURE);
     }
 
@@ -594,12 +874,216 @@ int skn_udp_host_create_broadcast_socket(int port, double rcvTimeout) {
     addr.sin_port = htons(port);
     if (bind(i_socket, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
         skn_logger(SD_EMERG, "Bind to local Socket error=%d, etext=%s", errno, strerror(errno));
+        close(i_socket);
         return (EXIT_FAILURE);
     }
 
     return i_socket;
 }
 
+/**
+ * skn_udp_host_join_multicast_group()
+ * - adds i_socket to group on every broadcast capable interface
+ * - an interface that refuses is logged and skipped
+ *
+ * - returns count of interfaces joined | PLATFORM_ERROR
+ */
+int skn_udp_host_join_multicast_group(int i_socket, const char *group) {
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    struct ip_mreq mreq;
+    int index = 0, joined = 0;
+
+    memset(&mreq, 0, sizeof(mreq));
+    if ((inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1) || !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr))) {
+        skn_logger(SD_ERR, "Multicast group %s is not an IPv4 multicast address", group);
+        return (PLATFORM_ERROR);
+    }
+    if (pis == NULL) {
+        return (PLATFORM_ERROR);
+    }
+
+    for (index = 0; index < pis->count; index++) {
+        mreq.imr_interface = pis->entry[index].addr;
+        if ((setsockopt(i_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq))) < 0) {
+            skn_logger(SD_WARNING, "Join Multicast Group %s on %s error=%d, etext=%s", group, pis->entry[index].name, errno, strerror(errno));
+            continue;
+        }
+        joined++;
+    }
+
+    return joined;
+}
+
+/**
+ * skn_udp_batch_create()
+ * - allocates the receive and reply vectors for up to batch_size datagrams
+ *
+ * - returns PUDPBatch | NULL
+ */
+PUDPBatch skn_udp_batch_create(int batch_size) {
+    PUDPBatch pb = NULL;
+    int index = 0;
+
+    if (batch_size < 1) {
+        batch_size = 1;
+    } else if (batch_size > ARY_MAX_BATCH) {
+        batch_size = ARY_MAX_BATCH;
+    }
+
+    pb = (PUDPBatch) malloc(sizeof(UDPBatch));
+    if (pb == NULL) {
+        skn_logger(SD_ERR, "UDPBatch cannot acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+    memset(pb, 0, sizeof(UDPBatch));
+    strcpy(pb->cbName, "PUDPBatch");
+    pb->batch_size = batch_size;
+
+    for (index = 0; index < batch_size; index++) {
+        pb->riov[index].iov_base = pb->request[index];
+        pb->riov[index].iov_len = (SZ_INFO_BUFF - 1);
+    }
+
+    return pb;
+}
+
+void skn_udp_batch_destroy(PUDPBatch pb) {
+    if (pb != NULL)
+        free(pb);
+}
+
+/**
+ * skn_udp_batch_receive()
+ * - blocks for the first datagram, then drains whatever else is queued, up to batch_size
+ * - each request is zero terminated in pb->request[], sender in pb->raddr[]
+ *
+ * - returns count of datagrams | PLATFORM_ERROR with errno set
+ */
+int skn_udp_batch_receive(PUDPBatch pb, int i_socket) {
+    struct msghdr *pmsg = NULL;
+    int index = 0, rc = 0;
+
+    pb->count = 0;
+    pb->replies = 0;
+    for (index = 0; index < pb->batch_size; index++) {
+        pmsg = &pb->rmsgs[index].msg_hdr;
+        memset(pmsg, 0, sizeof(struct msghdr));
+        pmsg->msg_name = &pb->raddr[index];
+        pmsg->msg_namelen = sizeof(struct sockaddr_in);
+        pmsg->msg_iov = &pb->riov[index];
+        pmsg->msg_iovlen = 1;
+        pmsg->msg_control = pb->rcontrol[index];
+        pmsg->msg_controllen = sizeof(pb->rcontrol[index]);
+        pb->rmsgs[index].msg_len = 0;
+    }
+
+    if (pb->batch_size == 1) {
+        rc = recvmsg(i_socket, &pb->rmsgs[0].msg_hdr, 0);
+        if (rc < 0) {
+            return PLATFORM_ERROR;
+        }
+        pb->rmsgs[0].msg_len = rc;
+        rc = 1;
+    } else {
+        rc = recvmmsg(i_socket, pb->rmsgs, pb->batch_size, MSG_WAITFORONE, NULL);
+        if (rc < 0) {
+            return PLATFORM_ERROR;
+        }
+    }
+
+    for (index = 0; index < rc; index++) {
+        pb->request[index][pb->rmsgs[index].msg_len] = 0;
+    }
+    pb->count = rc;
+
+    return rc;
+}
+
+/**
+ * skn_udp_batch_reply()
+ * - queues a reply to the sender of request index
+ * - reply must remain valid until skn_udp_batch_send()
+ *
+ * - returns count of queued replies | PLATFORM_ERROR when full
+ */
+int skn_udp_batch_reply(PUDPBatch pb, int index, const void *reply, int len) {
+    struct msghdr *pmsg = NULL;
+
+    if (pb->replies >= pb->batch_size || index >= pb->count) {
+        return PLATFORM_ERROR;
+    }
+
+    pb->siov[pb->replies].iov_base = (void *) reply;
+    pb->siov[pb->replies].iov_len = len;
+    pmsg = &pb->smsgs[pb->replies].msg_hdr;
+    memset(pmsg, 0, sizeof(struct msghdr));
+    pmsg->msg_name = &pb->raddr[index];
+    pmsg->msg_namelen = sizeof(struct sockaddr_in);
+    pmsg->msg_iov = &pb->siov[pb->replies];
+    pmsg->msg_iovlen = 1;
+
+    return ++pb->replies;
+}
+
+/**
+ * skn_udp_send_failure()
+ * - sorts a failed send by errno: the socket itself, or only the one
+ *   destination, which is logged
+ *
+ * - returns TRUE when the socket failed | FALSE when the rest can still be sent
+ */
+int skn_udp_send_failure(struct sockaddr_in *premaddr) {
+    int err = errno;
+
+    if ((err == EBADF) || (err == ENOTSOCK) || (err == EFAULT)) {
+        return TRUE;
+    }
+    skn_logger(SD_WARNING, "SendTo() %s:%d Failure code=%d, etext=%s",
+               inet_ntoa(premaddr->sin_addr), ntohs(premaddr->sin_port), err, strerror(err));
+    errno = err;
+
+    return FALSE;
+}
+
+/**
+ * skn_udp_batch_send()
+ * - sends every queued reply, one sendmmsg() when batching
+ * - a reply its destination refuses is counted in failed and skipped,
+ *   the rest are still sent
+ *
+ * - returns count sent | PLATFORM_ERROR with errno set when the socket failed
+ */
+int skn_udp_batch_send(PUDPBatch pb, int i_socket) {
+    int next = 0, sent = 0, rc = 0;
+
+    while (next < pb->replies) {
+        if (pb->batch_size == 1) {
+            rc = sendto(i_socket, pb->siov[next].iov_base, pb->siov[next].iov_len, 0,
+                        (struct sockaddr *) pb->smsgs[next].msg_hdr.msg_name, pb->smsgs[next].msg_hdr.msg_namelen);
+            rc = ((rc < 0) ? PLATFORM_ERROR : 1);
+        } else {
+            rc = sendmmsg(i_socket, &pb->smsgs[next], pb->replies - next, 0);
+        }
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (skn_udp_send_failure((struct sockaddr_in *) pb->smsgs[next].msg_hdr.msg_name)) {
+                pb->replies = 0;
+                return PLATFORM_ERROR;
+            }
+            pb->failed++;
+            next++;  // sendmmsg() stops at the first refused reply
+            continue;
+        }
+        next += rc;
+        sent += rc;
+    }
+    pb->replies = 0;
+
+    return sent;
+}
+
 PServiceRequest skn_service_request_create(PRegistryEntry pre, int host_socket, char *request) {
     PServiceRequest psr = NULL;
 
@@ -611,6 +1095,7 @@ PServiceRequest skn_service_request_create(PRegistryEntry pre, int host_socket,
     strcpy(psr->cbName, "PServiceRequest");
     psr->socket = host_socket;
     psr->pre = pre;
+    psr->wire = SKN_WIRE_TEXT;
     strncpy(psr->request, request, SZ_INFO_BUFF-1);
     return psr;
 }
@@ -645,18 +1130,25 @@ double skn_duration_in_milliseconds(struct timeval *pstart, struct timeval *pend
 int skn_udp_service_request(PServiceRequest psr) {
     struct sockaddr_in remaddr; /* remote address */
     socklen_t addrlen = sizeof(remaddr); /* length of addresses */
-    signed int vIndex = 0;
+    char binary[SZ_INFO_BUFF + SKN_WIRE_HEADER + 4];
+    signed int vIndex = 0, len = 0, code = 0;
     struct timeval start, end;
 
     memset(&remaddr, 0, sizeof(remaddr));
     remaddr.sin_family = AF_INET;
-    remaddr.sin_addr.s_addr = inet_addr(psr->pre->ip);
+    remaddr.sin_addr = psr->pre->addr;
     remaddr.sin_port = htons(psr->pre->port);
 
     /*
      * SEND */
     gettimeofday(&start, NULL);
-    if (sendto(psr->socket, psr->request, strlen(psr->request), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
+    if ((psr->wire == SKN_WIRE_BINARY) &&
+        ((len = skn_wire_encode_text(binary, sizeof(binary), SKN_WIRE_MESSAGE, 0, psr->request)) != PLATFORM_ERROR)) {
+        vIndex = sendto(psr->socket, binary, len, 0, (struct sockaddr *) &remaddr, addrlen);
+    } else {
+        vIndex = sendto(psr->socket, psr->request, strlen(psr->request), 0, (struct sockaddr *) &remaddr, addrlen);
+    }
+    if (vIndex < 0) {
         gettimeofday(&end, NULL);
         skn_logger(SD_WARNING, "ServiceRequest: SendTo(%1.6f) Timed out; Failure code=%d, etext=%s", skn_duration_in_milliseconds(&start,&end), errno, strerror(errno));
         return EXIT_FAILURE;
@@ -674,6 +1166,16 @@ int skn_udp_service_request(PServiceRequest psr) {
     psr->response[vIndex] = 0;
     gettimeofday(&end, NULL);
 
+    /* a binary status is kept as its text; a text one may offer the binary format */
+    if (skn_wire_is_binary(psr->response, vIndex)) {
+        if (skn_wire_decode_text(psr->response, vIndex, &code, psr->response, SZ_INFO_BUFF) == PLATFORM_ERROR) {
+            psr->response[0] = 0;
+        }
+    } else if ((gd_i_wire == SKN_WIRE_BINARY) && (psr->wire != SKN_WIRE_BINARY) && (strstr(psr->response, SKN_WIRE_ADVERT) != NULL)) {
+        psr->wire = SKN_WIRE_BINARY;
+        skn_logger(SD_INFO, "ServiceRequest: %s accepts the binary format", psr->pre->name);
+    }
+
     skn_logger(SD_INFO, "Response(%1.3fs) received from [%s] %s:%d",
                     skn_duration_in_milliseconds(&start,&end),
                     psr->response,
@@ -689,22 +1191,45 @@ int skn_udp_service_request(PServiceRequest psr) {
     return (EXIT_SUCCESS);
 }
 
-int service_registry_provider(int i_socket, char *response) {
-    struct sockaddr_in remaddr; /* remote address */
-    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
-    IPBroadcastArray aB;
-    char request[SZ_INFO_BUFF];
-    char recvHostName[SZ_INFO_BUFF];
-    signed int rLen = 0, rc = 0;
-    int exit_code = EXIT_SUCCESS, i_response_len = 0;
-
+/**
+ * service_registry_provider_create()
+ * - builds the default response when none was supplied, advertising the
+ *   address of the default interface
+ *
+ * - returns PServiceProvider | NULL
+ */
+static PServiceProvider service_registry_provider_create(char *response, int workers) {
+    PServiceProvider psp = NULL;
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    PInterfaceEntry pie = skn_interface_cache_default(pis);
+    int index = 0;
 
-    memset(request, 0, sizeof(request));
-    memset(recvHostName, 0, sizeof(recvHostName));
+    if (pie == NULL) {
+        skn_logger(SD_ERR, "ServiceProvider: no broadcast capable interface found");
+        return NULL;
+    }
 
-    rc = get_broadcast_ip_array(&aB);
-    if (rc == PLATFORM_ERROR) {
-        return EXIT_FAILURE;
+    psp = (PServiceProvider) malloc(sizeof(ServiceProvider));
+    if (psp == NULL) {
+        skn_logger(SD_ERR, "ServiceProvider cannot acquire needed resources. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+    memset(psp, 0, sizeof(ServiceProvider));
+    strcpy(psp->cbName, "PServiceProvider");
+    pthread_rwlock_init(&psp->rwlock, NULL);
+    psp->workers = workers;
+    psp->interfaces = pis->generation;
+    strcpy(psp->gossip.cbName, "PRegistryGossip");
+    psp->gossip.i_socket = PLATFORM_ERROR;
+    psp->gossip.round_fd = PLATFORM_ERROR;
+    strcpy(psp->relay.cbName, "PRegistryRelay");
+    psp->relay.i_socket = PLATFORM_ERROR;
+    psp->relay.poll_fd = PLATFORM_ERROR;
+    if ((gd_pch_replicate != NULL) && (service_registry_gossip_seed(psp, gd_pch_replicate) == PLATFORM_ERROR)) {
+        skn_logger(SD_ERR, "ServiceProvider: --replicate wants ip:port,... not '%s'", gd_pch_replicate);
+        pthread_rwlock_destroy(&psp->rwlock);
+        free(psp);
+        return NULL;
     }
 
     if (gd_pch_service_name == NULL) {
@@ -712,458 +1237,2488 @@ int service_registry_provider(int i_socket, char *response) {
     }
 
     if (strlen(response) < 16) {
-        if (gd_i_display) {
-            i_response_len = snprintf(response, (SZ_INFO_BUFF - 1),
-                     "name=rpi_locator_service,ip=%s,port=%d|"
-                     "name=%s,ip=%s,port=%d|",
-                     aB.ipAddrStr[aB.defaultIndex], SKN_FIND_RPI_PORT,
-                     gd_pch_service_name,
-                     aB.ipAddrStr[aB.defaultIndex], SKN_RPI_DISPLAY_SERVICE_PORT);
-        } else {
-            i_response_len = snprintf(response, (SZ_INFO_BUFF - 1),
-                            "name=rpi_locator_service,ip=%s,port=%d|",
-                            aB.ipAddrStr[aB.defaultIndex], SKN_FIND_RPI_PORT);
+        psp->advertised = pie->addr.s_addr;
+        service_registry_provider_base(psp, pie->addr);
+    } else {
+        strncpy(psp->base, response, (SZ_COMM_BUFF - 1));
+    }
+
+    /* leases are appended with the base's own line separator */
+    psp->separator = '|';
+    for (index = 0; psp->base[index] != 0; index++) {
+        if (psp->base[index] == '|' || psp->base[index] == '%' || psp->base[index] == ';') {
+            psp->separator = psp->base[index];
+            break;
         }
     }
-    service_registry_entry_response_message_log(response);
+    skn_timer_wheel_init(&psp->wheel);
+    psp->tick_fd = PLATFORM_ERROR;
+    psp->epoch = (unsigned long) time(NULL);
+    service_registry_shared_open(psp);
+    service_registry_response_scan(psp->base, service_registry_provider_pin, psp, NULL);
+    service_registry_provider_rebuild(psp);
+    service_registry_entry_response_message_log(psp->response);
 
-    skn_logger(SD_DEBUG, "Socket Bound to %s:%s", aB.chDefaultIntfName, aB.ipAddrStr[aB.defaultIndex]);
+    skn_logger(SD_DEBUG, "Socket Bound to %s:%s", pis->defaultName, inet_ntoa(pie->addr));
 
-    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
-        memset(&remaddr, 0, sizeof(remaddr));
-        remaddr.sin_family = AF_INET;
-        remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
-        remaddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        addrlen = sizeof(remaddr);
+    return psp;
+}
 
-        if ((rLen = recvfrom(i_socket, request, (SZ_INFO_BUFF - 1), 0, (struct sockaddr *) &remaddr, &addrlen)) < 0) {
-            if (errno == EAGAIN) {
-                continue;
-            }
-            skn_logger(SD_ERR, "RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = EXIT_FAILURE;
-            break;
+/**
+ * service_registry_provider_base()
+ * - writes the default base response, advertising addr
+ */
+static void service_registry_provider_base(PServiceProvider psp, struct in_addr addr) {
+    char ip[INET_ADDRSTRLEN];
+
+    inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+    if (gd_i_display) {
+        snprintf(psp->base, (SZ_COMM_BUFF - 1),
+                 "name=rpi_locator_service,ip=%s,port=%d|"
+                 "name=%s,ip=%s,port=%d|",
+                 ip, gd_i_locator_port,
+                 gd_pch_service_name,
+                 ip, SKN_RPI_DISPLAY_SERVICE_PORT);
+    } else {
+        snprintf(psp->base, (SZ_COMM_BUFF - 1),
+                        "name=rpi_locator_service,ip=%s,port=%d|",
+                        ip, gd_i_locator_port);
+    }
+}
+
+/**
+ * service_registry_provider_readdress()
+ * - follows the interface cache: when the default address moved, the
+ *   generated base entries are removed at the old address and added at
+ *   the new one, so delta readers see the move
+ * - a base given with -m is the operator's and is left alone
+ */
+static void service_registry_provider_readdress(PServiceProvider psp, PInterfaceSnapshot pis) {
+    PInterfaceEntry pie = skn_interface_cache_default(pis);
+    PRegistryLease pl = NULL;
+    char old_ip[INET_ADDRSTRLEN], new_ip[INET_ADDRSTRLEN];
+    struct in_addr addr;
+    int index = 0;
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    if (psp->interfaces >= pis->generation) {
+        pthread_rwlock_unlock(&psp->rwlock);
+        return;
+    }
+    __atomic_store_n(&psp->interfaces, pis->generation, __ATOMIC_RELAXED);
+    if ((psp->advertised == 0) || (pie == NULL) || (pie->addr.s_addr == psp->advertised)) {
+        pthread_rwlock_unlock(&psp->rwlock);
+        return;
+    }
+
+    addr.s_addr = psp->advertised;
+    inet_ntop(AF_INET, &addr, old_ip, sizeof(old_ip));
+    inet_ntop(AF_INET, &pie->addr, new_ip, sizeof(new_ip));
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use && pl->pinned && (strcmp(pl->ip, old_ip) == 0)) {
+            service_registry_provider_retire(psp, pl);
+            strcpy(pl->ip, new_ip);
+            pl->version = ++psp->version;
+            psp->claims++;
         }
-        request[rLen] = 0;
+    }
+    psp->advertised = pie->addr.s_addr;
+    service_registry_provider_base(psp, pie->addr);
+    service_registry_provider_rebuild(psp);
+    pthread_rwlock_unlock(&psp->rwlock);
 
-        rc = getnameinfo(((struct sockaddr *) &remaddr), sizeof(struct sockaddr_in), recvHostName, (SZ_INFO_BUFF-1), NULL, 0, NI_DGRAM);
-        if (rc != 0) {
-            skn_logger(SD_ERR, "GetNameInfo() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = EXIT_FAILURE;
+    skn_logger(SD_NOTICE, "ServiceProvider: default address moved from %s to %s on %s, version %lu",
+               old_ip, new_ip, pis->defaultName, psp->version);
+}
+
+/**
+ * service_registry_provider_destroy()
+ * - logs the lease counters, then frees the provider
+ */
+static void service_registry_provider_destroy(PServiceProvider psp) {
+    if (psp == NULL)
+        return;
+
+    skn_logger(SD_NOTICE, "ServiceProvider: %d leases live, %lu registrations, %lu renewals, %lu expirations, %lu rejected",
+               psp->wheel.pending, psp->registrations, psp->renewals, psp->expirations, psp->rejected);
+    service_registry_gossip_log_counters(psp);
+    service_registry_relay_log_counters(psp);
+    service_registry_shared_close(psp);
+    pthread_rwlock_destroy(&psp->rwlock);
+    free(psp);
+}
+
+/**
+ * service_registry_provider_is_broadcast()
+ * - reads the IP_PKTINFO destination of a received datagram
+ *
+ * - returns TRUE when it was sent to a broadcast or multicast address
+ */
+static int service_registry_provider_is_broadcast(PInterfaceSnapshot pis, struct msghdr *pmsg) {
+    struct cmsghdr *pcmsg = NULL;
+    struct in_pktinfo *ppki = NULL;
+    int index = 0;
+
+    for (pcmsg = CMSG_FIRSTHDR(pmsg); pcmsg != NULL; pcmsg = CMSG_NXTHDR(pmsg, pcmsg)) {
+        if (pcmsg->cmsg_level == IPPROTO_IP && pcmsg->cmsg_type == IP_PKTINFO) {
+            ppki = (struct in_pktinfo *) CMSG_DATA(pcmsg);
             break;
         }
-        skn_logger(SD_NOTICE, "Received request from %s @ %s:%d", recvHostName, inet_ntoa(remaddr.sin_addr), ntohs(remaddr.sin_port));
-        skn_logger(SD_NOTICE, "Request data: [%s]\n", request);
+    }
+    if (ppki == NULL) {
+        return FALSE;
+    }
 
-        /*
-         * Add new registry entry by command */
-        if ((strncmp("ADD ", request, sizeof("ADD")) == 0) &&
-            (service_registry_valiadate_response_format(&request[4]) == EXIT_SUCCESS)) {
-            if ((response[i_response_len-1] == '|') ||
-                (response[i_response_len-1] == '%') ||
-                (response[i_response_len-1] == ';')) {
-                strncpy(&response[i_response_len], &request[4], ((SZ_COMM_BUFF - 1) - (strlen(response) + strlen(&request[4]))) );
-                i_response_len += (rLen - 4);
-                skn_logger(SD_NOTICE, "COMMAND: Add New RegistryEntry Request Accepted!");
-            }
+    if (IN_MULTICAST(ntohl(ppki->ipi_addr.s_addr)) || (ppki->ipi_addr.s_addr == htonl(INADDR_BROADCAST))) {
+        return TRUE;
+    }
+    for (index = 0; (pis != NULL) && (index < pis->count); index++) {
+        if (ppki->ipi_addr.s_addr == pis->entry[index].broadcast.s_addr) {
+            return TRUE;
         }
+    }
 
-        if (sendto(i_socket, response, strlen(response), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
-            skn_logger(SD_EMERG, "SendTo() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = EXIT_FAILURE;
-            break;
+    return FALSE;
+}
+
+/**
+ * service_registry_provider_is_sibling_copy()
+ * - The kernel hashes unicast datagrams to exactly one SO_REUSEPORT socket, but
+ *   broadcast and multicast datagrams are copied to every socket in the group.
+ * - Broadcast copies are sharded by the requester's address and port, so only
+ *   one worker answers each request; only asked of broadcast datagrams.
+ *
+ * - returns TRUE when another worker owns this datagram
+ */
+static int service_registry_provider_is_sibling_copy(PProviderWorker pw, struct sockaddr_in *premaddr) {
+    PServiceProvider psp = (PServiceProvider) pw->psp;
+    uint32_t shard = 0;
+
+    shard = (ntohl(premaddr->sin_addr.s_addr) * 2654435761U) ^ ntohs(premaddr->sin_port);
+
+    return ((int)(shard % (uint32_t) psp->workers) != pw->index);
+}
+
+/**
+ * service_registry_provider_worker_stats()
+ * - logs requests/sec for the current interval, or the worker's lifetime when final
+ */
+static void service_registry_provider_worker_stats(PProviderWorker pw, int final) {
+    double interval = 0.0;
+
+    if (final) {
+        interval = skn_duration_in_milliseconds(&pw->start, NULL);
+        skn_logger(SD_NOTICE, "ProviderWorker[%02d]: %lu requests in %1.3fs, %1.1f req/s, %lu datagrams sent, %lu failed, %lu broadcast copies sharded, %lu replies jittered, %lu queries suppressed",
+                   pw->index, pw->requests, interval,
+                   (interval > 0.0 ? (pw->requests / interval) : 0.0), pw->datagrams, pw->failed, pw->sharded, pw->jittered, pw->suppressed);
+        return;
+    }
+
+    interval = skn_duration_in_milliseconds(&pw->interval_start, NULL);
+    if (interval < SKN_PROVIDER_STATS_INTERVAL) {
+        return;
+    }
+    if (pw->interval_requests > 0) {
+        skn_logger(SD_INFO, "ProviderWorker[%02d]: %lu requests in %1.3fs, %1.1f req/s",
+                   pw->index, pw->interval_requests, interval, (pw->interval_requests / interval));
+    }
+    if (pw->interval_shed > 0) {
+        skn_logger(SD_WARNING, "ProviderWorker[%02d]: %lu datagrams shed in %1.3fs, over the per-source rate limit",
+                   pw->index, pw->interval_shed, interval);
+    }
+    pw->interval_requests = 0;
+    pw->interval_shed = 0;
+    gettimeofday(&pw->interval_start, NULL);
+}
+
+/*
+ * Page builder state; the body is kept apart from the header so both
+ * passes break pages at the same entries */
+typedef struct _registryPager {
+    PServiceProvider psp;
+    char body[SKN_REGISTRY_PAGE - SKN_PAGE_HEADER];
+    char page[SKN_REGISTRY_PAGE];
+    int  len;
+    const char *op;
+    int  count;                  // pages finished
+    int  pages;                  // total, known on the emitting pass
+    int  (*emit)(const char *page, int len, void *context);
+    void *context;
+} RegistryPager, *PRegistryPager;
+
+/**
+ * service_registry_provider_page_flush()
+ * - finishes the current page, emitting it once the total is known
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when emit() refused the page
+ */
+static int service_registry_provider_page_flush(PRegistryPager ppg) {
+    int len = 0;
+
+    ppg->count++;
+    if (ppg->emit != NULL) {
+        len = snprintf(ppg->page, SKN_PAGE_HEADER, "version=%lu.%lu,page=%d/%d,op=%s%c",
+                       ppg->psp->epoch, ppg->psp->version, ppg->count, ppg->pages, ppg->op, ppg->psp->separator);
+        memcpy(&ppg->page[len], ppg->body, ppg->len);
+        len += ppg->len;
+        ppg->page[len] = 0;
+        if (ppg->emit(ppg->page, len, ppg->context) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
         }
+    }
+    ppg->len = 0;
 
-        /*
-         * Shutdown by command */
-        if (strcmp("QUIT!", request) == 0) {
-            skn_logger(SD_NOTICE, "COMMAND: Shutdown Requested! exit code=%d", gi_exit_flag);
-            break;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_page_line()
+ * - appends one entry under op, starting a new page when op changes or the body is full
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int service_registry_provider_page_line(PRegistryPager ppg, const char *op, const char *name, const char *ip, int port) {
+    char line[SZ_INFO_BUFF];
+    int len = 0;
+
+    len = snprintf(line, sizeof(line), "name=%s,ip=%s,port=%d%c", name, ip, port, ppg->psp->separator);
+    if ((ppg->len > 0) && ((ppg->op != op) || ((ppg->len + len) > (int) (sizeof(ppg->body) - 1)))) {
+        if (service_registry_provider_page_flush(ppg) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
         }
     }
+    ppg->op = op;
+    memcpy(&ppg->body[ppg->len], line, len);
+    ppg->len += len;
 
-    return exit_code;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_paginate()
+ * - full lists every entry, otherwise entries added (op=add) then removed
+ *   (op=del) after version since; an empty answer is still one page
+ * - counts the pages first, so every header carries the total
+ * - caller holds a lock
+ *
+ * - returns count of pages | PLATFORM_ERROR when emit() refused one
+ */
+static int service_registry_provider_paginate(PServiceProvider psp, int full, unsigned long since,
+                                              int (*emit)(const char *page, int len, void *context), void *context) {
+    static const char *ops[] = { "full", "add", "del" };
+    RegistryPager pager;
+    PRegistryLease pl = NULL;
+    PRegistryTombstone pt = NULL;
+    int pass = 0, index = 0, rc = EXIT_SUCCESS;
+
+    memset(&pager, 0, sizeof(pager));
+    pager.psp = psp;
+    pager.context = context;
+
+    for (pass = 0; pass < 2; pass++) {
+        pager.emit = (pass == 0 ? NULL : emit);
+        pager.pages = pager.count;
+        pager.count = 0;
+        pager.len = 0;
+        pager.op = ops[full ? 0 : 1];
+
+        for (index = 0; index < ARY_MAX_LEASES && rc == EXIT_SUCCESS; index++) {
+            pl = &psp->lease[index];
+            if (pl->in_use && (full || pl->version > since)) {
+                rc = service_registry_provider_page_line(&pager, ops[full ? 0 : 1], pl->name, pl->ip, pl->port);
+            }
+        }
+        for (index = 0; index < ARY_MAX_TOMBSTONES && full == 0 && rc == EXIT_SUCCESS; index++) {
+            pt = &psp->tombstone[index];
+            if (pt->in_use && pt->version > since) {
+                rc = service_registry_provider_page_line(&pager, ops[2], pt->name, pt->ip, pt->port);
+            }
+        }
+        if ((rc == EXIT_SUCCESS) && ((pager.len > 0) || (pager.count == 0))) {
+            rc = service_registry_provider_page_flush(&pager);
+        }
+        if (rc != EXIT_SUCCESS) {
+            return PLATFORM_ERROR;
+        }
+    }
+
+    return pager.count;
 }
 
 /*
- * Remote Service Registry routines
-*/
+ * emit() for the full reply kept in the provider */
+static int service_registry_provider_store_page(const char *page, int len, void *context) {
+    PServiceProvider psp = (PServiceProvider) context;
+
+    if (psp->pages >= ARY_MAX_PAGES) {
+        return EXIT_FAILURE;
+    }
+    memcpy(psp->page[psp->pages], page, len + 1);
+    psp->page_len[psp->pages++] = len;
+
+    return EXIT_SUCCESS;
+}
+
+static struct in_addr service_registry_lease_addr(PRegistryLease pl) {
+    struct in_addr addr;
+
+    addr.s_addr = inet_addr(pl->ip);
+    return addr;
+}
+
 /**
- * service_registry_create()
+ * service_registry_provider_rebuild()
+ * - response is the base entries, then one line per live lease that fits
+ * - the full paged reply is rebuilt alongside and lists every entry,
+ *   the binary reply as many as fit one page
+ * - caller holds the write lock
  *
- * - Collection of Services and their locations
- * - Returns the Registry
+ * - returns count of leases only listed in paged replies
  */
-static PServiceRegistry service_registry_create() {
-    PServiceRegistry psreg = NULL;
+int service_registry_provider_rebuild(PServiceProvider psp) {
+    PRegistryLease pl = NULL;
+    int len = 0, added = 0, omitted = 0, index = 0;
+
+    len = snprintf(psp->response, SZ_COMM_BUFF, "%s", psp->base);
+    if ((len > 0) && (len < (SZ_COMM_BUFF - 1)) &&
+        (psp->response[len - 1] != psp->separator) && (psp->wheel.pending > 0)) {
+        psp->response[len++] = psp->separator;
+        psp->response[len] = 0;
+    }
 
-    psreg = (PServiceRegistry) malloc(sizeof(ServiceRegistry));
-    if (psreg != NULL) {
-        memset(psreg, 0, sizeof(ServiceRegistry));
-        strcpy(psreg->cbName, "PServiceRegistry");
-        psreg->computedMax = (sizeof(psreg->entry) / sizeof(void *));
-        psreg->count = 0;
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if ((pl->in_use == 0) || pl->pinned) {
+            continue;
+        }
+        added = snprintf(&psp->response[len], SZ_COMM_BUFF - len, "name=%s,ip=%s,port=%d%c",
+                         pl->name, pl->ip, pl->port, psp->separator);
+        if (added >= (SZ_COMM_BUFF - len)) {
+            psp->response[len] = 0;
+            omitted++;
+            continue;
+        }
+        len += added;
     }
+    psp->response_len = len;
 
-    return psreg;
+    psp->pages = 0;
+    if (service_registry_provider_paginate(psp, 1, 0, service_registry_provider_store_page, psp) == PLATFORM_ERROR) {
+        skn_logger(SD_WARNING, "ServiceProvider: paged reply truncated at %d pages", ARY_MAX_PAGES);
+    }
+
+    psp->binary_len = skn_wire_registry_begin(psp->binary, SKN_REGISTRY_PAGE);
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if ((pl->in_use == 0) ||
+            ((len = skn_wire_registry_add(psp->binary, SKN_REGISTRY_PAGE, psp->binary_len, pl->name, service_registry_lease_addr(pl), pl->port)) == PLATFORM_ERROR)) {
+            continue;
+        }
+        psp->binary_len = len;
+    }
+    service_registry_shared_publish(psp);
+
+    return omitted;
 }
 
 /**
- * service_registry_entry_create()
+ * service_registry_provider_pin()
+ * - scan callback over the base response, holds each entry as a pinned lease
+ * - entries too long for a lease stay in the text response only
+ */
+static int service_registry_provider_pin(PRegistryRecord prec, void *context) {
+    PServiceProvider psp = (PServiceProvider) context;
+    PRegistryLease pl = NULL;
+    int index = 0;
+
+    if ((prec->name.len >= SZ_CHAR_LABEL) || (prec->ip.len >= SZ_CHAR_LABEL)) {
+        return EXIT_FAILURE;
+    }
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use == 0) {
+            memcpy(pl->name, prec->name.start, prec->name.len);
+            memcpy(pl->ip, prec->ip.start, prec->ip.len);
+            pl->port = service_registry_span_port(&prec->port);
+            pl->pinned = 1;
+            pl->in_use = 1;
+            pl->holders = 1;
+            pl->version = ++psp->version;
+            psp->claims++;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    return EXIT_FAILURE;
+}
+
+/**
+ * service_registry_provider_lease()
+ * - scan callback for an ADD request: renews the lease on a known
+ *   (name, ip, port), or registers a new one while a lease is free
+ * - caller holds the write lock
  *
- * - Create a Service Entry and adds it to the Registry collection
- * - Returns EXIT_FAILURE/SUCCESS
-*/
-static int service_registry_entry_create(PServiceRegistry psreg, char *name, char *ip, char *port, int *errors) {
-    PRegistryEntry prent = NULL;
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int service_registry_provider_lease(PRegistryRecord prec, void *context) {
+    PServiceProvider psp = (PServiceProvider) context;
+    PRegistryLease pl = NULL, pfree = NULL;
+    unsigned long ticks = (unsigned long) (gd_i_lease / SKN_LEASE_TICK);
+    uint16_t port = service_registry_span_port(&prec->port);
+    int index = 0;
 
-    if ((psreg == NULL) || (name == NULL) || (ip == NULL) || (port == NULL)) {
-        skn_logger(SD_DEBUG, "Parse failure missing value: (%s,%s,%s)", name, ip, port);
-        if (errors != NULL)
-            (*errors)++;
+    if ((prec->name.len >= SZ_CHAR_LABEL) || (prec->ip.len >= SZ_CHAR_LABEL)) {
+        psp->rejected++;
         return EXIT_FAILURE;
     }
 
-    if (psreg->count >= psreg->computedMax) {
-        skn_logger(SD_WARNING, "Capacity Error: Too many! New entry %d:%s exceeds maximum of %d allowed! Consider using the --unique-registry option.", psreg->count, name, psreg->computedMax);
-        if (errors != NULL)
-            (*errors)++;
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use == 0) {
+            if (pfree == NULL) {
+                pfree = pl;
+            }
+        } else if ((pl->port == port) &&
+                   (strncmp(pl->name, prec->name.start, prec->name.len) == 0) && (pl->name[prec->name.len] == 0) &&
+                   (strncmp(pl->ip, prec->ip.start, prec->ip.len) == 0) && (pl->ip[prec->ip.len] == 0)) {
+            if (pl->pinned) {
+                return EXIT_SUCCESS;
+            }
+            skn_timer_wheel_add(&psp->wheel, &pl->timer, ticks);
+            if ((pl->holders & 1) == 0) {  // listed already, as a peer's
+                pl->holders |= 1;
+                psp->claims++;
+                psp->registrations++;
+                if ((psp->wheel.pending == 1) && (psp->tick_fd != PLATFORM_ERROR)) {
+                    skn_event_timer_arm(psp->tick_fd, SKN_LEASE_TICK, SKN_LEASE_TICK);
+                }
+                skn_logger(SD_NOTICE, "COMMAND: RegistryEntry %s held by a peer, now leased here for %ds", pl->name, gd_i_lease);
+                return EXIT_SUCCESS;
+            }
+            psp->renewals++;
+            skn_logger(SD_NOTICE, "COMMAND: RegistryEntry %s lease renewed for %ds", pl->name, gd_i_lease);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if (pfree == NULL) {
+        psp->rejected++;
+        skn_logger(SD_WARNING, "COMMAND: Add New RegistryEntry Rejected, all %d leases in use", ARY_MAX_LEASES);
+        return EXIT_FAILURE;
+    }
+
+    pl = pfree;
+    memset(pl, 0, sizeof(RegistryLease));
+    memcpy(pl->name, prec->name.start, prec->name.len);
+    memcpy(pl->ip, prec->ip.start, prec->ip.len);
+    pl->port = port;
+    pl->in_use = 1;
+    pl->holders = 1;
+    service_registry_provider_admit(psp, pl);
+    skn_timer_wheel_add(&psp->wheel, &pl->timer, ticks);
+    psp->claims++;
+
+    if (service_registry_provider_rebuild(psp) > 0) {
+        skn_logger(SD_NOTICE, "COMMAND: RegistryEntry %s listed in paged replies only, text response is full", pl->name);
+    }
+    if ((psp->wheel.pending == 1) && (psp->tick_fd != PLATFORM_ERROR)) {
+        skn_event_timer_arm(psp->tick_fd, SKN_LEASE_TICK, SKN_LEASE_TICK);
+    }
+    psp->registrations++;
+    skn_logger(SD_NOTICE, "COMMAND: Add New RegistryEntry Request Accepted! lease %ds, version %lu", gd_i_lease, psp->version);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_retire()
+ * - records the removal of pl, so deltas report it
+ * - caller holds the write lock
+ */
+void service_registry_provider_retire(PServiceProvider psp, PRegistryLease pl) {
+    PRegistryTombstone pt = &psp->tombstone[psp->tombstone_next];
+
+    /* the ring forgets its oldest removal; deltas from before it become full replies */
+    if (pt->version != 0) {
+        psp->horizon = pt->version;
+    }
+    pt->in_use = 1;
+    pt->version = ++psp->version;
+    strcpy(pt->name, pl->name);
+    strcpy(pt->ip, pl->ip);
+    pt->port = pl->port;
+    psp->tombstone_next = (psp->tombstone_next + 1) % ARY_MAX_TOMBSTONES;
+}
+
+/**
+ * service_registry_provider_admit()
+ * - stamps a new entry with the next version
+ * - a delta now reports it added; a stale removal would undo that
+ * - caller holds the write lock
+ */
+void service_registry_provider_admit(PServiceProvider psp, PRegistryLease pl) {
+    int index = 0;
+
+    pl->version = ++psp->version;
+    for (index = 0; index < ARY_MAX_TOMBSTONES; index++) {
+        if (psp->tombstone[index].in_use && (psp->tombstone[index].port == pl->port) &&
+            (strcmp(psp->tombstone[index].name, pl->name) == 0) && (strcmp(psp->tombstone[index].ip, pl->ip) == 0)) {
+            psp->tombstone[index].in_use = 0;
+        }
+    }
+}
+
+/*
+ * a peer still holding the entry keeps it listed */
+static void service_registry_provider_on_expire(PWheelTimer pwt, void *context) {
+    PServiceProvider psp = (PServiceProvider) context;
+    PRegistryLease pl = (PRegistryLease) pwt;
+
+    skn_logger(SD_NOTICE, "RegistryEntry lease expired: name=%s, ip=%s, port=%d", pl->name, pl->ip, pl->port);
+    pl->holders &= ~((uint64_t) 1);
+    psp->claims++;
+    psp->expirations++;
+    if (pl->holders == 0) {
+        pl->in_use = 0;
+        service_registry_provider_retire(psp, pl);
+    }
+}
+
+/**
+ * service_registry_provider_on_tick()
+ * - advances the lease wheel once per tick elapsed, dropping expired
+ *   entries from the response; idles the timer when no lease is left
+ */
+static int service_registry_provider_on_tick(void *pem, void *pes) {
+    PServiceProvider psp = (PServiceProvider) ((PEventSource) pes)->context;
+    uint64_t tick = 0;
+    int fired = 0;
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    for (tick = 0; tick < ((PEventSource) pes)->expirations; tick++) {
+        fired += skn_timer_wheel_advance(&psp->wheel, service_registry_provider_on_expire, psp);
+    }
+    if (fired > 0) {
+        service_registry_provider_rebuild(psp);
+    }
+    if (psp->wheel.pending == 0) {
+        skn_event_timer_arm(psp->tick_fd, 0.0, 0.0);
+    }
+    pthread_rwlock_unlock(&psp->rwlock);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * emit() for a delta, built per request and sent as it is built */
+typedef struct _pageSend {
+    int i_socket;
+    struct sockaddr_in *premaddr;
+    int sent;
+} PageSend, *PPageSend;
+
+static int service_registry_provider_send_page(const char *page, int len, void *context) {
+    PPageSend pps = (PPageSend) context;
+
+    if (sendto(pps->i_socket, page, len, 0, (struct sockaddr *) pps->premaddr, sizeof(struct sockaddr_in)) < 0) {
+        return EXIT_FAILURE;
+    }
+    pps->sent++;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_answer()
+ * - the entries prq asks for, as one text or binary datagram; entries
+ *   past SKN_REGISTRY_PAGE are left out, a PAGES request lists them all
+ * - caller holds a lock
+ *
+ * - returns length of the answer | zero when there is nothing to send
+ */
+static int service_registry_provider_answer(PServiceProvider psp, PRegistryQuery prq, int binary, char *answer, int size) {
+    PRegistryLease pl = NULL;
+    struct in_addr addr;
+    int index = 0, len = 0, added = 0, count = 0;
+
+    answer[0] = 0;
+    if (binary) {
+        len = skn_wire_registry_begin(answer, size);
+    }
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use == 0) {
+            continue;
+        }
+        addr = service_registry_lease_addr(pl);
+        if (!service_registry_query_wants(prq, pl->name, addr.s_addr, pl->port)) {
+            continue;
+        }
+        if (binary) {
+            if ((added = skn_wire_registry_add(answer, size, len, pl->name, addr, pl->port)) == PLATFORM_ERROR) {
+                continue;
+            }
+            len = added;
+        } else {
+            added = snprintf(&answer[len], size - len, "name=%s,ip=%s,port=%d%c", pl->name, pl->ip, pl->port, psp->separator);
+            if (added >= (size - len)) {
+                answer[len] = 0;
+                continue;
+            }
+            len += added;
+        }
+        count++;
+    }
+
+    return (count > 0 ? len : 0);
+}
+
+/**
+ * service_registry_provider_defer()
+ * - holds a copy of a reply for delay milliseconds, sent by on_deferred()
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when the queue is full, send it now
+ */
+static int service_registry_provider_defer(PProviderWorker pw, struct sockaddr_in *premaddr, const char *data, int len, int delay) {
+    PDeferredReply pdr = NULL;
+
+    if ((pw->deferred == NULL) || (pw->deferred_count >= ARY_MAX_DEFERRED) || (len > SKN_REGISTRY_PAGE)) {
         return EXIT_FAILURE;
     }
 
-    /* update or create entry */
-    if (gd_i_unique_registry) {
-        prent = service_registry_find_entry(psreg, name);
+    pdr = &pw->deferred[pw->deferred_count++];
+    clock_gettime(CLOCK_MONOTONIC, &pdr->due);
+    pdr->due.tv_nsec += delay * 1000000L;
+    while (pdr->due.tv_nsec >= 1000000000L) {
+        pdr->due.tv_sec++;
+        pdr->due.tv_nsec -= 1000000000L;
+    }
+    pdr->addr = *premaddr;
+    memcpy(pdr->data, data, len);
+    pdr->len = len;
+    pw->jittered++;
+
+    service_registry_provider_deferred_arm(pw);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_deferred_arm()
+ * - one shot at the earliest due reply, disarmed when none are held
+ */
+static void service_registry_provider_deferred_arm(PProviderWorker pw) {
+    struct timespec now;
+    double wait = 0.0, next = 0.0;
+    int index = 0;
+
+    if (pw->deferred_count == 0) {
+        skn_event_timer_arm(pw->jitter_fd, 0.0, 0.0);
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    for (index = 0; index < pw->deferred_count; index++) {
+        next = (double) (pw->deferred[index].due.tv_sec - now.tv_sec) +
+               ((double) (pw->deferred[index].due.tv_nsec - now.tv_nsec) / 1000000000.0);
+        if ((index == 0) || (next < wait)) {
+            wait = next;
+        }
+    }
+    if (wait < 0.000001) {  // already due, a zero would disarm
+        wait = 0.000001;
+    }
+    skn_event_timer_arm(pw->jitter_fd, wait, 0.0);
+}
+
+/**
+ * service_registry_provider_on_deferred()
+ * - sends every held reply now due, then re-arms for the rest
+ * - a failed send loses that reply only
+ *
+ * - returns EXIT_SUCCESS
+ */
+static int service_registry_provider_on_deferred(void *pem, void *pes) {
+    PProviderWorker pw = (PProviderWorker) ((PEventSource) pes)->context;
+    PDeferredReply pdr = NULL;
+    struct timespec now;
+    int index = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (index < pw->deferred_count) {
+        pdr = &pw->deferred[index];
+        if ((pdr->due.tv_sec > now.tv_sec) ||
+            ((pdr->due.tv_sec == now.tv_sec) && (pdr->due.tv_nsec > now.tv_nsec))) {
+            index++;
+            continue;
+        }
+        if (sendto(pw->i_socket, pdr->data, pdr->len, 0, (struct sockaddr *) &pdr->addr, sizeof(struct sockaddr_in)) < 0) {
+            skn_logger(SD_WARNING, "SendTo() deferred reply Failure code=%d, etext=%s", errno, strerror(errno));
+        } else {
+            pw->datagrams++;
+        }
+        if (index != --pw->deferred_count) {
+            *pdr = pw->deferred[pw->deferred_count];
+        }
+    }
+    service_registry_provider_deferred_arm(pw);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_on_request()
+ * - answers one batch of requests each time the worker's socket is readable
+ * - single datagram replies to broadcast requests are jittered, and a
+ *   QUERY or FIND with nothing left to answer gets no reply
+ * - a broadcast PAGES gets only the first page of the full set, the rest
+ *   go to unicast requests; a broadcast SYNC gets nothing
+ * - each datagram of a paged reply past the first costs the requester a
+ *   token, so a small request cannot draw pages faster than the rate limit
+ * - a send one destination refuses is counted and logged, and the rest of
+ *   the batch is still answered; only a failed socket stops the worker
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int service_registry_provider_on_request(void *pem, void *pes) {
+    PProviderWorker pw = (PProviderWorker) ((PEventSource) pes)->context;
+    PServiceProvider psp = (PServiceProvider) pw->psp;
+    PUDPBatch pb = pw->pb;
+    struct sockaddr_in *premaddr = NULL;
+    char *request = NULL;
+    char recvHostName[SZ_INFO_BUFF];
+    char answer[SKN_REGISTRY_PAGE];
+    const char *reply = NULL;
+    signed int rc = 0, count = 0, index = 0, page = 0, sent = 0, len = 0, broadcast = 0;
+    int answered[ARY_MAX_BATCH], answers = 0;
+    int paged[ARY_MAX_BATCH], binary[ARY_MAX_BATCH], queried[ARY_MAX_BATCH], delay[ARY_MAX_BATCH];
+    unsigned long epoch[ARY_MAX_BATCH], since[ARY_MAX_BATCH];
+    RegistryQuery query[ARY_MAX_BATCH];
+    PageSend ps;
+    PInterfaceSnapshot pis = NULL;
+    double now = 0.0;
+    int quit = 0, fatal = 0;
+
+    if ((count = skn_udp_batch_receive(pb, pw->i_socket)) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return EXIT_SUCCESS;
+        }
+        skn_logger(SD_ERR, "RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* one pointer read, unless an interface changed since the last batch */
+    pis = skn_interface_cache_snapshot();
+    if ((pis != NULL) && (pis->generation != __atomic_load_n(&psp->interfaces, __ATOMIC_RELAXED))) {
+        service_registry_provider_readdress(psp, pis);
+    }
+    if (pw->limiter != NULL) {
+        now = skn_rate_limiter_now();
+    }
+
+    for (index = 0; index < count && quit == 0; index++) {
+        request = pb->request[index];
+        premaddr = &pb->raddr[index];
+
+        /* a flooding source is turned away before anything is decoded, logged or resolved */
+        if ((pw->limiter != NULL) && ((rc = skn_rate_limiter_admit(pw->limiter, premaddr->sin_addr.s_addr, now)) != SKN_RATE_ADMITTED)) {
+            if (rc == SKN_RATE_BUSY) {
+                skn_udp_batch_reply(pb, index, SKN_RATE_BUSY_REPLY, sizeof(SKN_RATE_BUSY_REPLY) - 1);
+            }
+            pw->interval_shed++;
+            rc = 0;
+            continue;
+        }
+
+        broadcast = service_registry_provider_is_broadcast(pis, &pb->rmsgs[index].msg_hdr);
+        if (broadcast && (psp->workers > 1) && service_registry_provider_is_sibling_copy(pw, premaddr)) {
+            pw->sharded++;
+            continue;
+        }
+        delay[answers] = ((broadcast && (gd_i_jitter > 0)) ? (int) (rand_r(&pw->seed) % (unsigned int) (gd_i_jitter + 1)) : 0);
+
+        /* a binary query carries an ordinary request, answered in binary */
+        binary[answers] = (skn_wire_decode_text(request, pb->rmsgs[index].msg_len, NULL, request, SZ_INFO_BUFF) == SKN_WIRE_QUERY);
+
+        /*
+         * Replication between locators, counted apart from requests */
+        if (strncmp(SKN_SYNC_REQUEST " ", request, sizeof(SKN_SYNC_REQUEST)) == 0) {
+            if (broadcast == 0) {    // peers are always asked by unicast
+                pthread_rwlock_wrlock(&psp->rwlock);
+                page = service_registry_gossip_answer(psp, pw->i_socket, premaddr, request, (int) pb->rmsgs[index].msg_len);
+                pthread_rwlock_unlock(&psp->rwlock);
+                skn_rate_limiter_charge(pw->limiter, premaddr->sin_addr.s_addr, page - 1);
+            }
+            continue;
+        }
+        if (strcmp(SKN_RELAY_REQUEST, request) == 0) {
+            pthread_rwlock_wrlock(&psp->rwlock);
+            page = service_registry_relay_answer(psp, pw->i_socket, premaddr);
+            pthread_rwlock_unlock(&psp->rwlock);
+            skn_rate_limiter_charge(pw->limiter, premaddr->sin_addr.s_addr, page - 1);
+            continue;
+        }
+
+        skn_resolver_host_name(premaddr, recvHostName, SZ_INFO_BUFF);
+        skn_logger(SD_NOTICE, "Received request from %s @ %s:%d", recvHostName, inet_ntoa(premaddr->sin_addr), ntohs(premaddr->sin_port));
+        skn_logger(SD_NOTICE, "Request data: [%s]%s\n", request, (binary[answers] ? " binary" : ""));
+
+        /*
+         * Add or renew leased registry entries by command */
+        if ((strncmp("ADD ", request, sizeof("ADD")) == 0) &&
+            (service_registry_valiadate_response_format(&request[4]) == EXIT_SUCCESS)) {
+            pthread_rwlock_wrlock(&psp->rwlock);
+            service_registry_response_scan(&request[4], service_registry_provider_lease, psp, NULL);
+            pthread_rwlock_unlock(&psp->rwlock);
+        }
+
+        /*
+         * Paged replies, all entries or the changes since a version; most
+         * pages to send, a broadcast gets the first and asks again by unicast */
+        paged[answers] = 0;
+        if (strncmp(SKN_PAGES_REQUEST, request, sizeof(SKN_PAGES_REQUEST) - 1) == 0) {
+            paged[answers] = (broadcast ? 1 : ARY_MAX_PAGES);
+        }
+        if ((paged[answers] != ARY_MAX_PAGES) ||
+            (sscanf(&request[sizeof(SKN_PAGES_REQUEST) - 1], " since=%lu.%lu", &epoch[answers], &since[answers]) != 2)) {
+            epoch[answers] = since[answers] = 0;
+        }
+
+        /*
+         * Known-answer queries and FIND, only what the requester is missing */
+        queried[answers] = (service_registry_query_parse(request, &query[answers]) == EXIT_SUCCESS);
+        answered[answers++] = index;
+
+        /*
+         * Shutdown by command */
+        if (strcmp("QUIT!", request) == 0) {
+            skn_logger(SD_NOTICE, "COMMAND: Shutdown Requested! exit code=%d", gi_exit_flag);
+            delay[answers - 1] = 0;  // answered before the workers stop
+            quit = 1;
+        }
+    }
+
+    /* every reply references the shared response or pages, so send under the read lock */
+    pthread_rwlock_rdlock(&psp->rwlock);
+    for (index = 0; index < answers && fatal == 0; index++) {
+        premaddr = &pb->raddr[answered[index]];
+        if (queried[index]) {
+            if ((len = service_registry_provider_answer(psp, &query[index], binary[index], answer, sizeof(answer))) == 0) {
+                pw->suppressed++;
+            } else if ((delay[index] == 0) || (service_registry_provider_defer(pw, premaddr, answer, len, delay[index]) != EXIT_SUCCESS)) {
+                if (sendto(pw->i_socket, answer, len, 0, (struct sockaddr *) premaddr, sizeof(struct sockaddr_in)) < 0) {
+                    fatal = skn_udp_send_failure(premaddr);
+                    pw->failed++;
+                } else {
+                    sent++;
+                }
+            }
+        } else if (paged[index] == 0) {
+            reply = (binary[index] ? psp->binary : psp->response);
+            len = (binary[index] ? psp->binary_len : psp->response_len);
+            if ((delay[index] == 0) || (service_registry_provider_defer(pw, premaddr, reply, len, delay[index]) != EXIT_SUCCESS)) {
+                skn_udp_batch_reply(pb, answered[index], reply, len);
+            }
+        } else if ((epoch[index] == psp->epoch) && (since[index] >= psp->horizon) && (since[index] <= psp->version)) {
+            ps.i_socket = pw->i_socket;
+            ps.premaddr = premaddr;
+            ps.sent = 0;
+            if (service_registry_provider_paginate(psp, 0, since[index], service_registry_provider_send_page, &ps) == PLATFORM_ERROR) {
+                fatal = skn_udp_send_failure(premaddr);  // the rest of this delta is lost
+                pw->failed++;
+            }
+            sent += ps.sent;
+            skn_rate_limiter_charge(pw->limiter, premaddr->sin_addr.s_addr, ps.sent - 1);
+        } else {
+            for (page = 0; page < psp->pages && page < paged[index] && fatal == 0; page++) {
+                if (skn_udp_batch_reply(pb, answered[index], psp->page[page], psp->page_len[page]) == PLATFORM_ERROR) {
+                    if ((rc = skn_udp_batch_send(pb, pw->i_socket)) < 0) {  // batch is full
+                        fatal = 1;
+                        break;
+                    }
+                    sent += rc;
+                    skn_udp_batch_reply(pb, answered[index], psp->page[page], psp->page_len[page]);
+                }
+            }
+            skn_rate_limiter_charge(pw->limiter, premaddr->sin_addr.s_addr, page - 1);
+        }
+    }
+    if ((fatal == 0) && ((rc = skn_udp_batch_send(pb, pw->i_socket)) < 0)) {
+        fatal = 1;
+    }
+    pthread_rwlock_unlock(&psp->rwlock);
+    if (fatal) {
+        skn_logger(SD_EMERG, "SendTo() Failure code=%d, etext=%s", errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    pw->failed += pb->failed;
+    pb->failed = 0;
+    pw->requests += answers;
+    pw->interval_requests += answers;
+    pw->datagrams += rc + sent;
+    service_registry_provider_worker_stats(pw, 0);
+
+    if (quit) {
+        psp->shutdown = 1;
+        skn_event_manager_request_shutdown();  // wakes every worker
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_worker()
+ * - answers requests on this worker's socket until shutdown is requested
+ * - worker 0 also ticks the lease wheel and runs the gossip rounds
+ * - with gd_i_jitter set, a one shot timer sends the jittered replies
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+static int service_registry_provider_worker(PProviderWorker pw) {
+    PServiceProvider psp = (PServiceProvider) pw->psp;
+    PEventManager pem = NULL;
+    char name[SZ_CHAR_LABEL];
+    int exit_code = EXIT_SUCCESS, tick_fd = PLATFORM_ERROR, joined = 0;
+
+    gettimeofday(&pw->start, NULL);
+    pw->interval_start = pw->start;
+
+    pw->pb = skn_udp_batch_create(gd_i_batch_size);
+    if (pw->pb == NULL) {
+        return EXIT_FAILURE;
+    }
+    pw->seed = (unsigned int) (time(NULL) ^ getpid() ^ (pw->index * 2654435761U));
+    pw->jitter_fd = PLATFORM_ERROR;
+    pw->deferred_count = 0;
+    if (gd_i_jitter > 0) {
+        pw->deferred = (PDeferredReply) calloc(ARY_MAX_DEFERRED, sizeof(DeferredReply));
+    }
+    pw->limiter = skn_rate_limiter_create(gd_i_rate_limit);
+
+    /* broadcast still reaches us when no interface takes the group */
+    if (strcmp(gd_pch_multicast_group, "none") != 0) {
+        joined = skn_udp_host_join_multicast_group(pw->i_socket, gd_pch_multicast_group);
+        if (pw->index == 0) {
+            skn_logger(SD_NOTICE, "ProviderWorker[%02d]: multicast group %s joined on %d interfaces", pw->index, gd_pch_multicast_group, (joined > 0 ? joined : 0));
+        }
+    }
+
+    pem = skn_event_manager_create("ProviderWorker");
+    if ((pem == NULL) ||
+        (skn_event_manager_add_socket(pem, pw->i_socket, service_registry_provider_on_request, pw) == EXIT_FAILURE)) {
+        exit_code = EXIT_FAILURE;
+    } else if ((pw->deferred != NULL) &&
+               (((pw->jitter_fd = skn_event_manager_add_timer(pem, 1.0, service_registry_provider_on_deferred, pw)) == PLATFORM_ERROR) ||
+                (skn_event_timer_arm(pw->jitter_fd, 0.0, 0.0) == PLATFORM_ERROR))) {
+        exit_code = EXIT_FAILURE;
+    } else if ((pw->index == 0) &&
+               ((tick_fd = skn_event_manager_add_timer(pem, SKN_LEASE_TICK, service_registry_provider_on_tick, psp)) == PLATFORM_ERROR)) {
+        exit_code = EXIT_FAILURE;
+    } else if ((pw->index == 0) && (service_registry_gossip_start(psp, pem) == EXIT_FAILURE)) {
+        exit_code = EXIT_FAILURE;
+    } else if ((pw->index == 0) && (service_registry_relay_start(psp, pem) == EXIT_FAILURE)) {
+        exit_code = EXIT_FAILURE;
+    } else {
+        if (pw->index == 0) {  // the first worker sweeps the lease wheel, while there are leases
+            pthread_rwlock_wrlock(&psp->rwlock);
+            psp->tick_fd = tick_fd;
+            if (psp->wheel.pending == 0) {
+                skn_event_timer_arm(psp->tick_fd, 0.0, 0.0);
+            }
+            pthread_rwlock_unlock(&psp->rwlock);
+        }
+        exit_code = skn_event_manager_run(pem);
+    }
+    if (pw->index == 0) {
+        pthread_rwlock_wrlock(&psp->rwlock);
+        psp->tick_fd = PLATFORM_ERROR;  // closed with the event manager
+        pthread_rwlock_unlock(&psp->rwlock);
+        service_registry_gossip_stop(psp);
+        service_registry_relay_stop(psp);
+    }
+
+    skn_event_manager_destroy(pem);
+    skn_udp_batch_destroy(pw->pb);
+    pw->pb = NULL;
+    if (pw->deferred_count > 0) {
+        skn_logger(SD_NOTICE, "ProviderWorker[%02d]: %d jittered replies dropped at shutdown", pw->index, pw->deferred_count);
+    }
+    free(pw->deferred);  // jitter_fd closed with the event manager
+    pw->deferred = NULL;
+    pw->deferred_count = 0;
+    pw->jitter_fd = PLATFORM_ERROR;
+    snprintf(name, sizeof(name), "ProviderWorker[%02d]", pw->index);
+    skn_rate_limiter_log_counters(pw->limiter, name);
+    skn_rate_limiter_destroy(pw->limiter);
+    pw->limiter = NULL;
+
+    return exit_code;
+}
+
+static void * service_registry_provider_worker_thread(void * ptr) {
+    PProviderWorker pw = (PProviderWorker) ptr;
+    long int exit_code = EXIT_SUCCESS;
+
+    pw->thread_complete = 1;
+    exit_code = service_registry_provider_worker(pw);
+    if (exit_code != EXIT_SUCCESS) {
+        skn_event_manager_request_shutdown();  // take the pool down with us
+    }
+    pw->thread_complete = 0;
+
+    pthread_exit((void *) exit_code);
+}
+
+/**
+ * service_registry_provider()
+ * - single threaded provider on a caller supplied socket
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int service_registry_provider(int i_socket, char *response) {
+    PServiceProvider psp = NULL;
+    int exit_code = EXIT_SUCCESS;
+
+    psp = service_registry_provider_create(response, 1);
+    if (psp == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    strcpy(psp->worker[0].cbName, "PProviderWorker");
+    psp->worker[0].i_socket = i_socket;
+    psp->worker[0].psp = psp;
+
+    exit_code = service_registry_provider_worker(&psp->worker[0]);
+    service_registry_provider_worker_stats(&psp->worker[0], 1);
+
+    service_registry_provider_destroy(psp);
+
+    return exit_code;
+}
+
+/**
+ * service_registry_provider_on_signal()
+ * - SIGINT, SIGQUIT or SIGTERM; record it for signals_cleanup() and stop the pool
+ */
+static int service_registry_provider_on_signal(void *pem, void *pes) {
+    struct signalfd_siginfo *psi = &((PEventSource) pes)->siginfo;
+
+    gi_exit_flag = psi->ssi_signo;
+    skn_logger(SD_NOTICE, "Program Exiting, from signal=%d:%s\n", psi->ssi_signo, strsignal(psi->ssi_signo));
+    skn_event_manager_request_shutdown();
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_provider_workers()
+ * - runs a pool of workers, each on its own SO_REUSEPORT socket bound to
+ *   gd_i_locator_port, sharing one read-mostly response
+ * - workers of zero uses one per cpu core
+ * - the calling thread waits on a signalfd; a signal, a QUIT! request or a
+ *   failed worker wakes every worker through the shutdown eventfd
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int service_registry_provider_workers(char *response, int workers) {
+    PServiceProvider psp = NULL;
+    PProviderWorker pw = NULL;
+    PEventManager pem = NULL;
+    sigset_t signal_set, saved_set;
+    void *trc = NULL;
+    unsigned long total = 0;
+    double elapsed = 0.0;
+    int index = 0, started = 0, exit_code = EXIT_SUCCESS;
+    struct timeval start;
+
+    if (workers < 1) {
+        workers = (int) skn_get_number_of_cpu_cores();
+    }
+    if (workers < 1) {
+        workers = 1;
+    } else if (workers > ARY_MAX_WORKERS) {
+        workers = ARY_MAX_WORKERS;
+    }
+
+    psp = service_registry_provider_create(response, workers);
+    if (psp == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    /* threads inherit the blocked mask, leaving the signals to our signalfd */
+    sigemptyset(&signal_set);
+    sigaddset(&signal_set, SIGINT);
+    sigaddset(&signal_set, SIGQUIT);
+    sigaddset(&signal_set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signal_set, &saved_set);
+
+    skn_resolver_startup();
+
+    gettimeofday(&start, NULL);
+    for (index = 0; index < workers; index++) {
+        pw = &psp->worker[index];
+        strcpy(pw->cbName, "PProviderWorker");
+        pw->index = index;
+        pw->psp = psp;
+        pw->i_socket = skn_udp_host_create_reuseport_socket(gd_i_locator_port, 0.0);
+        if (pw->i_socket == EXIT_FAILURE) {
+            skn_logger(SD_EMERG, "ProviderWorker[%02d]: Host Init Failed!", index);
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+        if (pthread_create(&pw->worker_thread, NULL, service_registry_provider_worker_thread, (void *) pw) != 0) {
+            skn_logger(SD_EMERG, "ProviderWorker[%02d]: Create thread failed: %s", index, strerror(errno));
+            close(pw->i_socket);
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+        started++;
+    }
+
+    if (exit_code == EXIT_SUCCESS) {
+        skn_logger(SD_NOTICE, "ServiceProvider: %d workers sharing port %d", started, gd_i_locator_port);
+        pem = skn_event_manager_create("ServiceProvider");
+        if ((pem == NULL) ||
+            (skn_event_manager_add_signals(pem, &signal_set, service_registry_provider_on_signal, psp) == EXIT_FAILURE)) {
+            exit_code = EXIT_FAILURE;
+        } else {
+            exit_code = skn_event_manager_run(pem);
+        }
+        skn_event_manager_destroy(pem);
+    }
+    skn_event_manager_request_shutdown();
+
+    for (index = 0; index < started; index++) {
+        pw = &psp->worker[index];
+        pthread_join(pw->worker_thread, &trc);
+        if ((long int) trc != EXIT_SUCCESS) {
+            exit_code = EXIT_FAILURE;
+        }
+        close(pw->i_socket);
+    }
+    pthread_sigmask(SIG_SETMASK, &saved_set, NULL);
+
+    elapsed = skn_duration_in_milliseconds(&start, NULL);
+    for (index = 0; index < started; index++) {
+        service_registry_provider_worker_stats(&psp->worker[index], 1);
+        total += psp->worker[index].requests;
+    }
+    skn_logger(SD_NOTICE, "ServiceProvider: %lu requests in %1.3fs, %1.1f req/s across %d workers",
+               total, elapsed, (elapsed > 0.0 ? (total / elapsed) : 0.0), started);
+    skn_resolver_shutdown();
+    skn_interface_cache_shutdown();
+
+    service_registry_provider_destroy(psp);
+
+    return exit_code;
+}
+
+/*
+ * Remote Service Registry routines
+*/
+/**
+ * service_registry_arena_alloc()
+ * - hands out 8 byte aligned space from the registry's arena
+ * - returns NULL when a new block cannot be had
+ */
+static void * service_registry_arena_alloc(PRegistryArena pra, size_t size) {
+    PArenaBlock pab = pra->head;
+    void *result = NULL;
+
+    size = (size + 7) & ~((size_t) 7);
+    if ((pab == NULL) || ((pab->size - pab->used) < size)) {
+        if (pra->next_size < SKN_REGISTRY_ARENA_BLOCK) {
+            pra->next_size = SKN_REGISTRY_ARENA_BLOCK;
+        }
+        while (pra->next_size < size) {
+            pra->next_size <<= 1;
+        }
+        pab = (PArenaBlock) malloc(sizeof(ArenaBlock) + pra->next_size);
+        if (pab == NULL) {
+            skn_logger(SD_WARNING, "Internal Memory Error: Could not grow registry arena by %lu bytes!", (unsigned long) pra->next_size);
+            return NULL;
+        }
+        pab->size = pra->next_size;
+        pab->used = 0;
+        pab->next = pra->head;
+        pra->head = pab;
+        pra->reserved += sizeof(ArenaBlock) + pab->size;
+        pra->blocks++;
+        pra->next_size <<= 1;
+    }
+
+    result = &pab->data[pab->used];
+    pab->used += size;
+    pra->used += size;
+
+    return result;
+}
+
+static void service_registry_arena_release(PRegistryArena pra) {
+    PArenaBlock pab = pra->head, next = NULL;
+
+    while (pab != NULL) {
+        next = pab->next;
+        free(pab);
+        pab = next;
+    }
+    memset(pra, 0, sizeof(RegistryArena));
+}
+
+/**
+ * service_registry_hash()
+ * - FNV-1a of len bytes, for the intern table
+ */
+static uint32_t service_registry_hash(const char *value, size_t len) {
+    uint32_t hash = 2166136261U;
+    const unsigned char *pch = (const unsigned char *) value;
+
+    while (len-- > 0) {
+        hash = (hash ^ *pch++) * 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * service_registry_hash_key()
+ * - interned strings compare by address, so the key hashes the pointers
+ */
+static uint32_t service_registry_hash_key(const char *name, const char *ip, int port) {
+    uint64_t key = (uint64_t) (uintptr_t) name;
+
+    key = (key * 0x9E3779B97F4A7C15ULL) ^ (uint64_t) (uintptr_t) ip;
+    key = (key * 0x9E3779B97F4A7C15ULL) ^ (uint64_t) port;
+    key *= 0x9E3779B97F4A7C15ULL;
+
+    return (uint32_t) (key >> 32);
+}
+
+/**
+ * service_registry_intern()
+ * - returns the registry's single copy of the len bytes at value, which need not be terminated
+ * - when add is false, returns NULL for a value never seen
+ */
+static const char * service_registry_intern(PServiceRegistry psreg, const char *value, size_t len, int add) {
+    const char **intern = NULL, **old = psreg->intern;
+    char *copy = NULL;
+    uint32_t slot = 0;
+    int slots = 0, index = 0;
+
+    slot = service_registry_hash(value, len) & psreg->intern_mask;
+    while (psreg->intern[slot] != NULL) {
+        if ((strncmp(psreg->intern[slot], value, len) == 0) && (psreg->intern[slot][len] == 0)) {
+            return psreg->intern[slot];
+        }
+        slot = (slot + 1) & psreg->intern_mask;
+    }
+    if (!add) {
+        return NULL;
+    }
+
+    copy = (char *) service_registry_arena_alloc(&psreg->arena, len + 1);
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, value, len);
+    copy[len] = 0;
+    psreg->intern[slot] = copy;
+    psreg->intern_count++;
+
+    /* keep the table at most half full */
+    if ((psreg->intern_count * 2) > psreg->intern_mask) {
+        slots = (psreg->intern_mask + 1) * 2;
+        intern = (const char **) calloc(slots, sizeof(const char *));
+        if (intern != NULL) {
+            psreg->intern = intern;
+            psreg->intern_mask = slots - 1;
+            for (index = 0; index < (slots / 2); index++) {
+                if (old[index] != NULL) {
+                    slot = service_registry_hash(old[index], strlen(old[index])) & psreg->intern_mask;
+                    while (intern[slot] != NULL) {
+                        slot = (slot + 1) & psreg->intern_mask;
+                    }
+                    intern[slot] = old[index];
+                }
+            }
+            free(old);
+        }
+    }
+
+    return copy;
+}
+
+/**
+ * service_registry_index_slot()
+ * - probes key_index, or name_index when ip is NULL; name and ip are interned
+ * - returns the slot holding a match, or the empty slot ending the probe
+ */
+static int * service_registry_index_slot(PServiceRegistry psreg, const char *name, const char *ip, int port) {
+    PRegistryEntry prent = NULL;
+    int *index = (ip == NULL) ? psreg->name_index : psreg->key_index;
+    uint32_t slot = service_registry_hash_key(name, ip, port) & psreg->index_mask;
+
+    while (index[slot] != 0) {
+        prent = psreg->entry[index[slot] - 1];
+        if ((prent->name == name) &&
+            ((ip == NULL) || ((prent->ip == ip) && (prent->port == port)))) {
+            break;
+        }
+        slot = (slot + 1) & psreg->index_mask;  // linear probe
+    }
+
+    return &index[slot];
+}
+
+/**
+ * service_registry_index_add()
+ * - indexes entry at position; an existing key keeps its first entry
+ */
+static void service_registry_index_add(PServiceRegistry psreg, int position) {
+    PRegistryEntry prent = psreg->entry[position];
+    int *slot = NULL;
+
+    slot = service_registry_index_slot(psreg, prent->name, prent->ip, prent->port);
+    if (*slot == 0) {
+        *slot = position + 1;
+    }
+    slot = service_registry_index_slot(psreg, prent->name, NULL, 0);
+    if (*slot == 0) {
+        *slot = position + 1;
+    }
+}
+
+/**
+ * service_registry_resize()
+ * - sizes .entry for capacity entries and rebuilds both indexes
+ * - Returns EXIT_FAILURE/SUCCESS
+ */
+static int service_registry_resize(PServiceRegistry psreg, int capacity) {
+    PRegistryEntry *entry = NULL;
+    int *key_index = NULL, *name_index = NULL;
+    int slots = 1, position = 0;
+
+    while (slots < (capacity * 2)) {
+        slots <<= 1;
+    }
+
+    entry = (PRegistryEntry *) realloc(psreg->entry, capacity * sizeof(PRegistryEntry));
+    key_index = (int *) calloc(slots, sizeof(int));
+    name_index = (int *) calloc(slots, sizeof(int));
+    if (entry != NULL) {
+        psreg->entry = entry;
+    }
+    if ((entry == NULL) || (key_index == NULL) || (name_index == NULL)) {
+        skn_logger(SD_WARNING, "Internal Memory Error: Could not grow registry to %d entries!", capacity);
+        free(key_index);
+        free(name_index);
+        return EXIT_FAILURE;
+    }
+
+    free(psreg->key_index);
+    free(psreg->name_index);
+    psreg->key_index = key_index;
+    psreg->name_index = name_index;
+    psreg->index_mask = slots - 1;
+    psreg->computedMax = capacity;
+
+    for (position = 0; position < psreg->count; position++) {
+        service_registry_index_add(psreg, position);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_create()
+ *
+ * - Collection of Services and their locations
+ * - Returns the Registry
+ */
+PServiceRegistry service_registry_create() {
+    PServiceRegistry psreg = NULL;
+
+    psreg = (PServiceRegistry) malloc(sizeof(ServiceRegistry));
+    if (psreg != NULL) {
+        memset(psreg, 0, sizeof(ServiceRegistry));
+        strcpy(psreg->cbName, "PServiceRegistry");
+        psreg->count = 0;
+        psreg->intern_mask = (ARY_MAX_REGISTRY * 2) - 1;
+        psreg->intern = (const char **) calloc(psreg->intern_mask + 1, sizeof(const char *));
+        if ((psreg->intern == NULL) ||
+            (service_registry_resize(psreg, ARY_MAX_REGISTRY) == EXIT_FAILURE)) {
+            service_registry_destroy(psreg);
+            psreg = NULL;
+        }
+    }
+
+    return psreg;
+}
+
+/**
+ * service_registry_entry_add()
+ * - appends an entry of interned name and ip, or with --unique-registry
+ *   finds the entry already holding (name, ip, port)
+ * - Returns EXIT_SUCCESS | EXIT_FAILURE
+*/
+static int service_registry_entry_add(PServiceRegistry psreg, const char *iname, const char *iip, uint16_t iport) {
+    PRegistryEntry prent = NULL;
+    int *slot = NULL;
+
+    if (gd_i_unique_registry) {
+        slot = service_registry_index_slot(psreg, iname, iip, iport);
+        if (*slot != 0) {
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if ((psreg->count >= psreg->computedMax) &&
+        (service_registry_resize(psreg, psreg->computedMax * 2) == EXIT_FAILURE)) {
+        return EXIT_FAILURE;
+    }
+    prent = (PRegistryEntry) service_registry_arena_alloc(&psreg->arena, sizeof(RegistryEntry));
+    if (prent == NULL) {
+        skn_logger(SD_WARNING, "Internal Memory Error: Could not allocate memory for entry %d:%s !", psreg->count, iname);
+        return EXIT_FAILURE;
+    }
+    prent->name = iname;
+    prent->ip = iip;
+    prent->addr.s_addr = inet_addr(iip);
+    prent->port = iport;
+    psreg->entry[psreg->count] = prent;
+    service_registry_index_add(psreg, psreg->count);
+    psreg->count++;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_entry_create()
+ *
+ * - Create a Service Entry and adds it to the Registry collection
+ * - with --unique-registry an entry already holding (name, ip, port) is updated instead
+ * - Returns count of entries, or EXIT_FAILURE
+*/
+int service_registry_entry_create(PServiceRegistry psreg, char *name, char *ip, char *port, int *errors) {
+    const char *iname = NULL, *iip = NULL;
+    int rc = EXIT_FAILURE;
+
+    if ((psreg == NULL) || (name == NULL) || (ip == NULL) || (port == NULL)) {
+        skn_logger(SD_DEBUG, "Parse failure missing value: (%s,%s,%s)", name, ip, port);
+        if (errors != NULL)
+            (*errors)++;
+        return EXIT_FAILURE;
+    }
+
+    iname = service_registry_intern(psreg, name, strlen(name), 1);
+    iip = service_registry_intern(psreg, ip, strlen(ip), 1);
+    if ((iname != NULL) && (iip != NULL)) {
+        rc = service_registry_entry_add(psreg, iname, iip, (uint16_t) atoi(port));
+    }
+    if (rc == EXIT_FAILURE) {
+        if (errors != NULL)
+            (*errors)++;
+        return EXIT_FAILURE;
+    }
+
+    return psreg->count;
+}
+
+/**
+ * service_registry_valiadate_response_format()
+ *
+ * - Validates a text registry entry format, allocates nothing
+ * - Returns EXIT_FAILURE/SUCCESS
+*/
+int service_registry_valiadate_response_format(const char *response) {
+    int errors = 0; // false
+
+    service_registry_response_scan(response, NULL, NULL, &errors);
+
+    if (errors > 0) {
+        return EXIT_FAILURE; // false
+    } else {
+        return EXIT_SUCCESS; // true
+    }
+}
+
+/**
+ * service_registry_valiadated_registry()
+ *
+ * - Validate the text formatted entry and return registry collection
+ * - Returns a Registry with one entry
+*/
+PServiceRegistry service_registry_valiadated_registry(const char *response) {
+    int errors = 0;
+
+    PServiceRegistry psr = service_registry_create();
+    service_registry_response_parse(psr, response, &errors);
+    if (errors > 0) {
+        service_registry_destroy(psr);
+        return NULL; // false
+    }
+
+    return psr;
+}
+
+/**
+ * service_registry_entry_response_message_log()
+ *
+ * - Prints each pair of values from a text registry entry
+*/
+void service_registry_entry_response_message_log(const char * response) {
+    char * worker = NULL, *parser = NULL, *base = strdup(response);
+    parser = base;
+    skn_logger(SD_NOTICE, "Response Message:");
+    while (( ((worker = strsep(&parser, "|")) != NULL) ||
+          ((worker = strsep(&parser, "%")) != NULL) ||
+          ((worker = strsep(&parser, ";")) != NULL)) &&
+          (strlen(worker) > 8)) {
+        skn_logger(SD_NOTICE, "[%s]", worker);
+    }
+    free(base);
+}
+
+/**
+ * service_registry_find_entry()
+ *
+ * - Finds the first entry with this name, through name_index
+ * - Returns the entry or NULL
+*/
+PRegistryEntry service_registry_find_entry(PServiceRegistry psreg, char *serviceName) {
+    const char *name = NULL;
+    int *slot = NULL;
+
+    if ((psreg == NULL) || (serviceName == NULL))
+        return NULL;
+
+    name = service_registry_intern(psreg, serviceName, strlen(serviceName), 0);
+    if (name == NULL) {
+        return NULL;
+    }
+    slot = service_registry_index_slot(psreg, name, NULL, 0);
+    if (*slot == 0) {
+        return NULL;
+    }
+
+    return psreg->entry[*slot - 1];
+}
+
+/**
+ * Returns the number of services in registry
+ */
+int service_registry_entry_count(PServiceRegistry psr) {
+    return psr->count;
+}
+
+/**
+ * Logs each entry in service registry
+ */
+int service_registry_list_entries(PServiceRegistry psr) {
+    int index = 0;
+
+    skn_logger(" ", "\nServiceRegistry:");
+    for (index = 0; index < psr->count; index++) {
+        skn_logger(SD_INFO, "RegistryEntry(%02d) name=%s, ip=%s, port=%d", index, psr->entry[index]->name, psr->entry[index]->ip, psr->entry[index]->port);
+    }
+    return index;
+}
+
+/**
+ * service_registry_get_entry_field_ref()
+ * - shim over the compact entry, by field name
+ * - Returns the name or ip string, or the address of the uint16_t port
+*/
+void * service_registry_get_entry_field_ref(PRegistryEntry prent, char *field) {
+    void * result = NULL;
+
+    if ((prent == NULL) || (field == NULL)) {
+        return NULL;
+    }
+    if (strcmp("name", field) == 0) {
+        result = (void *) prent->name;
+    } else if (strcmp("ip", field) == 0) {
+        result = (void *) prent->ip;
+    } else if (strcmp("port", field) == 0) {
+        result = (void *) &prent->port;
+    }
+
+    return result;
+}
+
+/**
+ * service_registry_span_strip()
+ * - skn_strip() without writing: trims trailing blanks, then leading
+ *   non-alphanumerics unless that would leave nothing
+*/
+static void service_registry_span_strip(PRegistrySpan psp) {
+    const unsigned char *pch = (const unsigned char *) psp->start;
+    int end = psp->len - 1, start = 0;
+
+    if (psp->len < 1) {
+        return;
+    }
+    while ((isgraph(pch[end]) == 0) && end > 0) {
+        end--;
+    }
+    psp->len = end + 1;
+
+    while ((isalnum(pch[start]) == 0) && start < psp->len) {
+        start++;
+    }
+    if (start < psp->len) {
+        psp->start += start;
+        psp->len -= start;
+    }
+}
+
+/**
+ * service_registry_span_port()
+ * - atoi() bounded by the span
+*/
+uint16_t service_registry_span_port(PRegistrySpan psp) {
+    const unsigned char *pch = (const unsigned char *) psp->start;
+    unsigned int value = 0;
+    int index = 0, negative = 0;
+
+    while (index < psp->len && isspace(pch[index])) {
+        index++;
+    }
+    if (index < psp->len && (pch[index] == '-' || pch[index] == '+')) {
+        negative = (pch[index] == '-');
+        index++;
+    }
+    while (index < psp->len && isdigit(pch[index])) {
+        value = (value * 10) + (pch[index] - '0');
+        index++;
+    }
+
+    return (uint16_t) (negative ? (0U - value) : value);
+}
+
+/**
+ * service_registry_record_field()
+ * - Determines which field a stripped key names, guessing at misspellings
+ * - Returns the record's span for that field, or NULL
+*/
+static PRegistrySpan service_registry_record_field(PRegistryRecord prec, PRegistrySpan pkey) {
+    if ((pkey->len == 4) && (memcmp(pkey->start, "name", 4) == 0)) {
+        return &prec->name;
+    } else if ((pkey->len == 2) && (memcmp(pkey->start, "ip", 2) == 0)) {
+        return &prec->ip;
+    } else if ((pkey->len == 4) && (memcmp(pkey->start, "port", 4) == 0)) {
+        return &prec->port;
+    }
+
+    /* try to guess what the key is */
+    if (memchr(pkey->start, 'e', pkey->len) != NULL) {
+        return &prec->name;
+    } else if (memchr(pkey->start, 'i', pkey->len) != NULL) {
+        return &prec->ip;
+    } else if (memchr(pkey->start, 't', pkey->len) != NULL) {
+        return &prec->port;
+    }
+
+    return NULL;
+}
+
+/**
+ * service_registry_response_scan()
+ *
+ * Tokenize a response message in one pass over the caller's buffer, without
+ * copying or allocating; record() is called for each complete line.
+ *
+ * Format: name=rpi_locator_service,ip=10.100.1.19,port=48028|
+ *         name=lcd_display_service,ip=10.100.1.19,port=48029|
+ *
+ *  the line separator is the first '|', '%' or ';' in the message
+ *  lines shorter than 16 chars and pairs without '=' are skipped
+ *  an unknown key or empty value fails its line, as does a missing field
+ *
+ * - record may be NULL to only validate; a record() failure counts as an error
+ * - Returns count of complete lines, errors holds the failed ones
+*/
+int service_registry_response_scan(const char *response, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors) {
+    const char *pch = NULL, *line = response, *pair = response, *equal = NULL;
+    RegistryRecord rec = { { "", 0 }, { "", 0 }, { "", 0 } };
+    RegistrySpan key, value, failed = { NULL, 0 };
+    PRegistrySpan pfield = NULL;
+    int records = 0, failures = 0;
+    char sep = 0, ch = 0;
+
+    for (pch = response; ; pch++) {
+        ch = *pch;
+        if ((sep == 0) && (ch == '|' || ch == '%' || ch == ';')) {
+            sep = ch;
+        }
+
+        if (ch == '=' && equal == NULL) {
+            equal = pch;
+        } else if (ch == ',' || ch == sep || ch == 0) { // end of a key=value pair
+            if (failed.start == NULL && equal != NULL) {
+                key.start = pair;
+                key.len = (int) (equal - pair);
+                value.start = equal + 1;
+                value.len = (int) (pch - value.start);
+                service_registry_span_strip(&key);
+                pfield = service_registry_record_field(&rec, &key);
+                if (pfield != NULL && value.len > 0) {
+                    service_registry_span_strip(&value);
+                    *pfield = value;
+                } else {
+                    failed = key;
+                }
+            }
+            pair = pch + 1;
+            equal = NULL;
+        }
+
+        if (ch == sep || ch == 0) { // end of a line
+            if ((pch - line) < 16) {
+                ;
+            } else if (failed.start != NULL) {
+                failures++;
+                skn_logger(SD_WARNING, "Response format failure: for name=%.*s, ip=%.*s, port=%.*s, first failing entry: [%.*s]",
+                           rec.name.len, rec.name.start, rec.ip.len, rec.ip.start, rec.port.len, rec.port.start,
+                           failed.len, failed.start);
+            } else if (rec.name.len == 0 || rec.ip.len == 0 || rec.port.len == 0) {
+                failures++;
+                skn_logger(SD_DEBUG, "Parse failure missing value: (%.*s,%.*s,%.*s)",
+                           rec.name.len, rec.name.start, rec.ip.len, rec.ip.start, rec.port.len, rec.port.start);
+            } else {
+                records++;
+                if ((record != NULL) && (record(&rec, context) != EXIT_SUCCESS)) {
+                    failures++;
+                }
+            }
+
+            if (ch == 0) {
+                break;
+            }
+            rec.name.start = rec.ip.start = rec.port.start = "";
+            rec.name.len = rec.ip.len = rec.port.len = 0;
+            failed.start = NULL;
+            line = pch + 1;
+        }
+    }
+
+    if (errors != NULL) {
+        (*errors) += failures;
+    }
+
+    return records;
+}
+
+/**
+ * service_registry_response_record()
+ * - scan callback, adds one record to the registry in context
+*/
+static int service_registry_response_record(PRegistryRecord prec, void *context) {
+    PServiceRegistry psreg = (PServiceRegistry) context;
+    const char *iname = NULL, *iip = NULL;
+
+    iname = service_registry_intern(psreg, prec->name.start, prec->name.len, 1);
+    iip = service_registry_intern(psreg, prec->ip.start, prec->ip.len, 1);
+    if ((iname == NULL) || (iip == NULL)) {
+        return EXIT_FAILURE;
+    }
+
+    return service_registry_entry_add(psreg, iname, iip, service_registry_span_port(&prec->port));
+}
+
+/**
+ * service_registry_response_parse()
+ * - adds each complete line of response to psreg, export error count
+ * - Returns count of entries
+*/
+static int service_registry_response_parse(PServiceRegistry psreg, const char *response, int *errors) {
+    service_registry_response_scan(response, service_registry_response_record, psreg, errors);
+
+    return psreg->count;
+}
+
+/**
+ * service_registry_request_encode()
+ * - with --encoding=binary, wraps request as a binary query so the
+ *   locator answers in binary; PAGES replies stay text either way
+ * - Returns length encoded, or zero to send request as text
+*/
+static int service_registry_request_encode(char *request, char *binary, int size) {
+    int len = 0;
+
+    if ((gd_i_wire != SKN_WIRE_BINARY) || (strncmp(request, SKN_PAGES_REQUEST, sizeof(SKN_PAGES_REQUEST) - 1) == 0)) {
+        return 0;
+    }
+    len = skn_wire_encode_text(binary, size, SKN_WIRE_QUERY, 0, request);
+
+    return (len == PLATFORM_ERROR ? 0 : len);
+}
+
+/**
+ * service_registry_broadcast_request()
+ * - sends request to the locator port on every interface's broadcast address
+ * - Returns count of datagrams sent
+*/
+static int service_registry_broadcast_request(int i_socket, char *request) {
+    struct sockaddr_in remaddr; /* remote address */
+    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    char binary[SZ_INFO_BUFF + SKN_WIRE_HEADER + 4];
+    const char *message = request;
+    int vIndex = 0, len = service_registry_request_encode(request, binary, sizeof(binary));
+
+    if (pis == NULL) {
+        return 0;
+    }
+    get_default_interface_name_and_ipv4_address(gd_ch_intfName, gd_ch_ipAddress);
+
+    skn_logger(SD_NOTICE, "Socket Bound to %s", gd_ch_ipAddress);
+
+    for (vIndex = 0; vIndex < pis->count; vIndex++) {
+        memset(&remaddr, 0, sizeof(remaddr));
+        remaddr.sin_family = AF_INET;
+        remaddr.sin_addr = pis->entry[vIndex].broadcast;
+        remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
+
+        if (sendto(i_socket, (len > 0 ? binary : message), (len > 0 ? len : (int) strlen(message)), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
+            skn_logger(SD_WARNING, "SendTo() Timed out; Failure code=%d, etext=%s", errno, strerror(errno));
+            break;
+        }
+        skn_logger(SD_NOTICE, "Message Broadcasted on %s:%s:%d", pis->entry[vIndex].name, inet_ntoa(remaddr.sin_addr), SKN_FIND_RPI_PORT);
+    }
+
+    return vIndex;
+}
+
+/**
+ * service_registry_multicast_request()
+ * - sends request to gd_pch_multicast_group out of every interface, only
+ *   hosts that joined the group receive it
+ * - Returns count of datagrams sent
+*/
+static int service_registry_multicast_request(int i_socket, char *request) {
+    struct sockaddr_in remaddr; /* remote address */
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    char binary[SZ_INFO_BUFF + SKN_WIRE_HEADER + 4];
+    const char *message = request;
+    unsigned char ttl = (unsigned char) gd_i_multicast_ttl;
+    int vIndex = 0, sent = 0, len = service_registry_request_encode(request, binary, sizeof(binary));
+
+    memset(&remaddr, 0, sizeof(remaddr));
+    remaddr.sin_family = AF_INET;
+    remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
+    if ((inet_pton(AF_INET, gd_pch_multicast_group, &remaddr.sin_addr) != 1) || (pis == NULL)) {
+        return 0;
+    }
+    if ((setsockopt(i_socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl))) < 0) {
+        skn_logger(SD_WARNING, "Set Socket Multicast TTL Option error=%d, etext=%s", errno, strerror(errno));
+    }
+
+    for (vIndex = 0; vIndex < pis->count; vIndex++) {
+        if (((setsockopt(i_socket, IPPROTO_IP, IP_MULTICAST_IF, &pis->entry[vIndex].addr, sizeof(struct in_addr))) < 0) ||
+            (sendto(i_socket, (len > 0 ? binary : message), (len > 0 ? len : (int) strlen(message)), 0, (struct sockaddr *) &remaddr, sizeof(remaddr)) < 0)) {
+            skn_logger(SD_WARNING, "Multicast on %s Failure code=%d, etext=%s", pis->entry[vIndex].name, errno, strerror(errno));
+            continue;
+        }
+        sent++;
+        skn_logger(SD_NOTICE, "Message Multicast on %s:%s:%d", pis->entry[vIndex].name, gd_pch_multicast_group, SKN_FIND_RPI_PORT);
+    }
+
+    return sent;
+}
+
+/**
+ * service_registry_get_via_udp_broadcast()
+ *
+ * - Retrieves entries from every service that responds to the broadcast
+ *   parses and builds a new Registry of all entries, or unique entries.
+ * - Waits until the socket receive timeout expires, see service_registry_discover()
+ *
+ * - Returns Populated Registry
+*/
+PServiceRegistry service_registry_get_via_udp_broadcast(int i_socket, char *request) {
+    struct sockaddr_in remaddr; /* remote address */
+    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
+    char response[SKN_REGISTRY_PAGE + 1];
+    char recvHostName[SZ_INFO_BUFF];
+    signed int rLen = 0;
+    struct timeval start;
+
+    memset(response, 0, sizeof(response));
+    memset(recvHostName, 0, sizeof(recvHostName));
+
+    gettimeofday(&start, NULL);
+    service_registry_broadcast_request(i_socket, request);
+
+    PServiceRegistry psr = service_registry_create();
+    skn_logger(SD_DEBUG, "Waiting for all responses\n");
+    while (gi_exit_flag == SKN_RUN_MODE_RUN) { // depends on a socket timeout of 5 seconds
+
+        rLen = recvfrom(i_socket, response, (sizeof(response) - 1), 0, (struct sockaddr *) &remaddr, &addrlen);
+        if (rLen == PLATFORM_ERROR) {  // EAGAIN
+            break;
+        }
+        response[rLen] = 0;
+
+        skn_resolver_host_name(&remaddr, recvHostName, SZ_INFO_BUFF);
+        skn_logger(SD_DEBUG, "Response(%1.3fs) received from %s @ %s:%d",
+                        skn_duration_in_milliseconds(&start, NULL),
+                        recvHostName,
+                        inet_ntoa(remaddr.sin_addr),
+                        ntohs(remaddr.sin_port)
+                  );
+        service_registry_message_scan(response, rLen, service_registry_response_record, psr, NULL);
+    }
+
+    return (psr);
+}
+
+/**
+ * service_registry_discovery_init()
+ * - prepares pdr to wait at most timeout seconds from now
+ * - service_name may be NULL, min_responders zero waits out the timeout
+ * - broadcasts up to SKN_QUERY_ROUNDS times, set pdr->rounds to change it
+ * - the first round goes to gd_pch_multicast_group unless it is 'none'
+ * - with --relay-host, the only request goes to that relay instead
+*/
+void service_registry_discovery_init(PDiscoveryRequest pdr, const char *service_name, int min_responders, double timeout) {
+    memset(pdr, 0, sizeof(DiscoveryRequest));
+    strcpy(pdr->cbName, "PDiscoveryRequest");
+    pdr->service_name = service_name;
+    pdr->min_responders = min_responders;
+    pdr->rounds = SKN_QUERY_ROUNDS;
+    pdr->multicast = (strcmp(gd_pch_multicast_group, "none") != 0);
+    if (gd_pch_relay_host != NULL) {
+        inet_pton(AF_INET, gd_pch_relay_host, &pdr->unicast);
     }
-    if (prent == NULL) {
-        prent = (PRegistryEntry) malloc(sizeof(RegistryEntry));
-        if (prent != NULL) {
-            psreg->entry[psreg->count] = prent;
-            psreg->count++;
-        }
+
+    clock_gettime(CLOCK_MONOTONIC, &pdr->deadline);
+    pdr->deadline.tv_sec += (time_t) timeout;
+    pdr->deadline.tv_nsec += (long) ((timeout - (time_t) timeout) * 1000000000L);
+    if (pdr->deadline.tv_nsec >= 1000000000L) {
+        pdr->deadline.tv_sec++;
+        pdr->deadline.tv_nsec -= 1000000000L;
     }
+}
 
-    if (prent != NULL) {
-        memset(prent, 0, sizeof(RegistryEntry));
-        strcpy(prent->cbName, "PRegistryEntry");
-        strcpy(prent->name, name);
-        strcpy(prent->ip, ip);
-        prent->port = atoi(port);
-    } else {
-        skn_logger(SD_WARNING, "Internal Memory Error: Could not allocate memory for entry %d:%s !", name, psreg->count);
-        if (errors != NULL)
-            (*errors)++;
+/*
+ * discovery scan context: the registry being built and whether this
+ * response named the wanted service */
+typedef struct _discoveryScan {
+    PServiceRegistry psr;
+    const char *service_name;
+    int matched;
+} DiscoveryScan, *PDiscoveryScan;
 
-        return EXIT_FAILURE;
+/**
+ * service_registry_discovery_record()
+ * - scan callback, adds the record and notes a match on the wanted name
+*/
+static int service_registry_discovery_record(PRegistryRecord prec, void *context) {
+    PDiscoveryScan pds = (PDiscoveryScan) context;
+
+    if ((pds->service_name == NULL) ||
+        ((prec->name.len == (int) strlen(pds->service_name)) &&
+         (memcmp(prec->name.start, pds->service_name, prec->name.len) == 0))) {
+        pds->matched = 1;
     }
 
-    return psreg->count;
+    return service_registry_response_record(prec, pds->psr);
 }
 
 /**
- * service_registry_valiadate_response_format()
- *
- * - Validates a text registry entry format
- * - Returns EXIT_FAILURE/SUCCESS
+ * service_registry_discovery_remaining()
+ * - Returns milliseconds left before the deadline, rounded up, or zero
 */
-int service_registry_valiadate_response_format(const char *response) {
-    int errors = 0; // false
+static int service_registry_discovery_remaining(struct timespec *pdeadline) {
+    struct timespec now;
+    long long remaining = 0;
 
-    PServiceRegistry psr = service_registry_create();
-    service_registry_response_parse(psr, response, &errors);
-    service_registry_destroy(psr);
-
-    if (errors > 0) {
-        return EXIT_FAILURE; // false
-    } else {
-        return EXIT_SUCCESS; // true
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    remaining = ((long long) (pdeadline->tv_sec - now.tv_sec) * 1000000000LL) + (pdeadline->tv_nsec - now.tv_nsec);
+    if (remaining <= 0) {
+        return 0;
     }
+
+    return (int) ((remaining + 999999LL) / 1000000LL);
 }
 
 /**
- * service_registry_valiadated_registry()
- *
- * - Validate the text formatted entry and return registry collection
- * - Returns a Registry with one entry
+ * service_registry_discovery_send()
+ * - sends request to pdr->unicast when set, else to the multicast group
+ *   while pdr->multicast is set, else broadcasts it
 */
-PServiceRegistry service_registry_valiadated_registry(const char *response) {
-    int errors = 0;
+static void service_registry_discovery_send(int i_socket, char *request, PDiscoveryRequest pdr) {
+    struct sockaddr_in remaddr;
+    char binary[SZ_INFO_BUFF + SKN_WIRE_HEADER + 4];
+    int len = 0, sent = 0;
 
-    PServiceRegistry psr = service_registry_create();
-    service_registry_response_parse(psr, response, &errors);
-    if (errors > 0) {
-        free(psr);
-        return NULL; // false
+    if (pdr->unicast.s_addr != 0) {
+        memset(&remaddr, 0, sizeof(remaddr));
+        remaddr.sin_family = AF_INET;
+        remaddr.sin_addr = pdr->unicast;
+        remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
+        len = service_registry_request_encode(request, binary, sizeof(binary));
+        if (sendto(i_socket, (len > 0 ? binary : request), (len > 0 ? len : (int) strlen(request)), 0, (struct sockaddr *) &remaddr, sizeof(remaddr)) < 0) {
+            skn_logger(SD_WARNING, "SendTo() Timed out; Failure code=%d, etext=%s", errno, strerror(errno));
+        } else {
+            pdr->probes++;
+            skn_logger(SD_NOTICE, "Message Sent to %s:%d", inet_ntoa(pdr->unicast), SKN_FIND_RPI_PORT);
+        }
+    } else {
+        if (pdr->multicast) {
+            sent = service_registry_multicast_request(i_socket, request);
+            pdr->multicasts += sent;
+        }
+        if (sent == 0) {  // no interface took the group
+            pdr->broadcasts += service_registry_broadcast_request(i_socket, request);
+        }
     }
-
-    return psr;
 }
 
 /**
- * service_registry_entry_response_message_log()
- *
- * - Prints each pair of values from a text registry entry
+ * service_registry_discovery_round()
+ * - pnext gets the time of broadcast round, the first being round zero:
+ *   round r goes out at window / 2^(rounds - r), the intervals doubling
+ *   like mDNS, so the last one has half the window left to be answered
 */
-void service_registry_entry_response_message_log(const char * response) {
-    char * worker = NULL, *parser = NULL, *base = strdup(response);
-    parser = base;
-    skn_logger(SD_NOTICE, "Response Message:");
-    while (( ((worker = strsep(&parser, "|")) != NULL) ||
-          ((worker = strsep(&parser, "%")) != NULL) ||
-          ((worker = strsep(&parser, ";")) != NULL)) &&
-          (strlen(worker) > 8)) {
-        skn_logger(SD_NOTICE, "[%s]", worker);
+static void service_registry_discovery_round(PDiscoveryRequest pdr, struct timespec *pstart, long long window, int round, struct timespec *pnext) {
+    long long offset = window >> (pdr->rounds - round);
+
+    pnext->tv_sec = pstart->tv_sec + (time_t) (offset / 1000000000LL);
+    pnext->tv_nsec = pstart->tv_nsec + (long) (offset % 1000000000LL);
+    if (pnext->tv_nsec >= 1000000000L) {
+        pnext->tv_sec++;
+        pnext->tv_nsec -= 1000000000L;
     }
-    free(base);
 }
 
 /**
- * service_registry_find_entry()
- *
- * - Finds an existing entry
- * - Returns EXIT_FAILURE/SUCCESS
+ * service_registry_discovery_wait()
+ * - polls i_socket until a datagram is ready or the deadline passes
+ * - Returns EXIT_SUCCESS | EXIT_FAILURE at the deadline or on error
 */
-PRegistryEntry service_registry_find_entry(PServiceRegistry psreg, char *serviceName) {
-    PRegistryEntry prent = NULL;
-    int index = 0;
+static int service_registry_discovery_wait(int i_socket, struct timespec *pdeadline) {
+    struct pollfd pfd;
+    int timeout = 0, rc = 0;
 
-    if (psreg == NULL)
-        return NULL;
+    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
+        timeout = service_registry_discovery_remaining(pdeadline);
+        if (timeout == 0) {
+            break;
+        }
 
-    while (index < psreg->count) {
-        if (strcmp(serviceName, psreg->entry[index]->name) == 0) {
-            prent = psreg->entry[index];
+        pfd.fd = i_socket;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        rc = poll(&pfd, 1, timeout);
+        if (rc == PLATFORM_ERROR) {
+            if (errno == EINTR) {
+                continue;
+            }
+            skn_logger(SD_WARNING, "Discovery: poll() Failure code=%d, etext=%s", errno, strerror(errno));
             break;
         }
-        index++;
+        if (rc > 0) {
+            return EXIT_SUCCESS;
+        }
+        break; // deadline
     }
 
-    return prent;
+    return EXIT_FAILURE;
 }
 
 /**
- * Returns the number of services in registry
- */
-int service_registry_entry_count(PServiceRegistry psr) {
-    return psr->count;
-}
+ * service_registry_discover()
+ *
+ * - Broadcasts request and parses responses as they arrive, like
+ *   service_registry_get_via_udp_broadcast(), but waits on pdr's deadline
+ *   rather than the socket timeout, and stops once the quorum is met
+ * - with pdr->unicast set, sends the request to that locator only
+ * - otherwise broadcasts again while the quorum is short, up to pdr->rounds
+ *   times; each later round is a QUERY for service_name listing the
+ *   providers already heard, so only the missing ones answer
+ * - a round is skipped once the providers heard no longer fit one QUERY,
+ *   as every one left off it would answer again
+ * - with pdr->multicast set, rounds go to the multicast group until one
+ *   finds nobody, then fall back to broadcast for older locators
+ * - takes paged replies too, each page parsed as it arrives
+ * - pdr counts the datagrams sent, responses and responders heard
+ *
+ * - Returns Populated Registry
+*/
+PServiceRegistry service_registry_discover(int i_socket, char *request, PDiscoveryRequest pdr) {
+    struct sockaddr_in remaddr; /* remote address */
+    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
+    DiscoveryScan ds;
+    RegistryPageHeader rph;
+    char response[SKN_REGISTRY_PAGE + 1];
+    char recvHostName[SZ_INFO_BUFF];
+    char query[SZ_INFO_BUFF - SKN_WIRE_HEADER - 4];  // fits the locator's request buffer in either encoding
+    signed int rLen = 0;
+    int records = 0, index = 0, body = 0, round = 1, heard = pdr->responses;
+    struct timeval start;
+    struct timespec first, next, *until = NULL;
+    long long window = 0;
 
-/**
- * Logs each entry in service registry
- */
-int service_registry_list_entries(PServiceRegistry psr) {
-    int index = 0;
+    memset(response, 0, sizeof(response));
+    memset(recvHostName, 0, sizeof(recvHostName));
 
-    skn_logger(" ", "\nServiceRegistry:");
-    for (index = 0; index < psr->count; index++) {
-        skn_logger(SD_INFO, "RegistryEntry(%02d) name=%s, ip=%s, port=%d", index, psr->entry[index]->name, psr->entry[index]->ip, psr->entry[index]->port);
+    gettimeofday(&start, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &first);
+    window = ((long long) (pdr->deadline.tv_sec - first.tv_sec) * 1000000000LL) + (pdr->deadline.tv_nsec - first.tv_nsec);
+    if ((pdr->unicast.s_addr != 0) || (window <= 0) || (pdr->rounds < 1)) {
+        pdr->rounds = 1;
+    } else if (pdr->rounds > 16) {
+        pdr->rounds = 16;
     }
-    return index;
+    if (pdr->rounds == 1) {
+        pdr->multicast = 0;  // no later round to fall back on
+    }
+    service_registry_discovery_send(i_socket, request, pdr);
+    if (pdr->rounds > 1) {
+        service_registry_discovery_round(pdr, &first, window, round, &next);
+    }
+
+    PServiceRegistry psr = service_registry_create();
+    skn_logger(SD_DEBUG, "Waiting for %d responders of %s\n", pdr->min_responders,
+               (pdr->service_name != NULL ? pdr->service_name : "any service"));
+    while ((pdr->broadcasts + pdr->multicasts + pdr->probes) > 0) {
+        until = (round < pdr->rounds ? &next : &pdr->deadline);
+        if (service_registry_discovery_wait(i_socket, until) != EXIT_SUCCESS) {
+            if ((until == &pdr->deadline) || (gi_exit_flag != SKN_RUN_MODE_RUN)) {
+                break;
+            }
+            if (pdr->multicast && (pdr->responses == heard)) {
+                pdr->multicast = 0;
+                skn_logger(SD_NOTICE, "Discovery: no answer from multicast group %s, broadcasting", gd_pch_multicast_group);
+            }
+            if (service_registry_query_request(query, sizeof(query), pdr->service_name, psr) > 0) {
+                skn_logger(SD_DEBUG, "Discovery round %d of %d: [%s]", round + 1, pdr->rounds, query);
+                service_registry_discovery_send(i_socket, query, pdr);
+            } else {
+                skn_logger(SD_DEBUG, "Discovery round %d of %d skipped, %d heard do not fit a QUERY", round + 1, pdr->rounds, psr->count);
+            }
+            if (++round < pdr->rounds) {
+                service_registry_discovery_round(pdr, &first, window, round, &next);
+            }
+            continue;
+        }
+        rLen = recvfrom(i_socket, response, (sizeof(response) - 1), MSG_DONTWAIT, (struct sockaddr *) &remaddr, &addrlen);
+        if (rLen == PLATFORM_ERROR) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        response[rLen] = 0;
+        pdr->responses++;
+
+        skn_resolver_host_name(&remaddr, recvHostName, SZ_INFO_BUFF);
+        skn_logger(SD_DEBUG, "Response(%1.3fs) received from %s @ %s:%d",
+                        skn_duration_in_milliseconds(&start, NULL),
+                        recvHostName,
+                        inet_ntoa(remaddr.sin_addr),
+                        ntohs(remaddr.sin_port)
+                  );
+
+        /* a page's header is not an entry, and its removals are not wanted here */
+        body = 0;
+        if (!skn_wire_is_binary(response, rLen) && (service_registry_page_header(response, &rph) == EXIT_SUCCESS)) {
+            body = (strcmp(rph.op, "del") == 0 ? rLen : rph.body);
+        }
+
+        ds.psr = psr;
+        ds.service_name = pdr->service_name;
+        ds.matched = 0;
+        records = service_registry_message_scan(&response[body], rLen - body, service_registry_discovery_record, &ds, NULL);
+
+        if (ds.matched) { // count each provider once, whichever interface it answered on
+            for (index = 0; index < pdr->responders && index < ARY_MAX_RESPONDERS; index++) {
+                if (pdr->responder[index] == remaddr.sin_addr.s_addr) {
+                    break;
+                }
+            }
+            if (index == pdr->responders || index == ARY_MAX_RESPONDERS) {
+                if (index < ARY_MAX_RESPONDERS) {
+                    pdr->responder[index] = remaddr.sin_addr.s_addr;
+                }
+                pdr->responders++;
+            }
+        }
+
+        if ((pdr->on_response != NULL) && (pdr->on_response(pdr, psr, &remaddr, records) != EXIT_SUCCESS)) {
+            break;
+        }
+        if ((pdr->min_responders > 0) && (pdr->responders >= pdr->min_responders)) {
+            break;
+        }
+    }
+
+    skn_logger(SD_DEBUG, "Discovery ended after %1.3fs: %d responses, %d of %d responders",
+               skn_duration_in_milliseconds(&start, NULL), pdr->responses, pdr->responders, pdr->min_responders);
+
+    return (psr);
 }
 
 /**
- * service_registry_get_entry_field_ref()
- * - compute the address of each field on demand, from struct
- * - Returns the address offset of the registry field requested
+ * service_registry_page_header()
+ * - parses the header line of a paged reply into prph
+ *
+ * - Returns EXIT_SUCCESS | EXIT_FAILURE when response is not a page
 */
-void * service_registry_get_entry_field_ref(PRegistryEntry prent, char *field) {
-    int index = 0;
-    void * result = NULL;
-    char * names[4] = { "name", "ip", "port", NULL };
-    int offsets[4] = { offsetof(RegistryEntry, name),
-                       offsetof(RegistryEntry, ip),
-                       offsetof(RegistryEntry, port),
-                       0
-                     };
-    for (index = 0; names[index] != NULL; index++) {
-        if (strcmp(names[index], field) == 0) {
-            result = (void *) prent + offsets[index];
-            break;
-        }
+int service_registry_page_header(const char *response, PRegistryPageHeader prph) {
+    int body = 0;
+
+    memset(prph, 0, sizeof(RegistryPageHeader));
+    if ((sscanf(response, "version=%lu.%lu,page=%d/%d,op=%7[a-z]%n",
+                &prph->epoch, &prph->version, &prph->page, &prph->pages, prph->op, &body) != 5) ||
+        (body == 0) || (prph->page < 1) || (prph->page > prph->pages) || (prph->pages > ARY_MAX_PAGES) ||
+        ((response[body] != '|') && (response[body] != '%') && (response[body] != ';'))) {
+        return EXIT_FAILURE;
     }
-    return result;
+    if ((strcmp(prph->op, "full") != 0) && (strcmp(prph->op, "add") != 0) && (strcmp(prph->op, "del") != 0)) {
+        return EXIT_FAILURE;
+    }
+    prph->body = body + 1;
+
+    return EXIT_SUCCESS;
+}
+
+void service_registry_view_init(PRegistryView prv) {
+    memset(prv, 0, sizeof(RegistryView));
+    strcpy(prv->cbName, "PRegistryView");
+}
+
+void service_registry_view_destroy(PRegistryView prv) {
+    service_registry_destroy(prv->psr);
+    prv->psr = NULL;
 }
 
+/*
+ * view scan context: the registry being built and, for removals,
+ * the previous registry and which of its entries are gone */
+typedef struct _viewScan {
+    PServiceRegistry psr;
+    PServiceRegistry previous;
+    char *removed;
+    int changes;
+} ViewScan, *PViewScan;
+
 /**
- * service_registry_entry_create_helper()
- * - Determines which field should be updated
- * - compute the address of each field on demand, from local vars
- * - Returns the address offset of the registry field requested
+ * service_registry_view_record()
+ * - scan callback: with removed set, marks the matching previous entry,
+ *   otherwise adds the record unless the registry already holds it
 */
-static void * service_registry_entry_create_helper(char *key, char **name, char **ip, char **port) {
-    int index = 0;
-    char * guess = NULL;
-    void * result = NULL;
-    char * names[4] = { "name", "ip", "port", NULL };
-    void * offsets[] = { name, ip, port, NULL };
+static int service_registry_view_record(PRegistryRecord prec, void *context) {
+    PViewScan pvs = (PViewScan) context;
+    PServiceRegistry psreg = (pvs->removed != NULL ? pvs->previous : pvs->psr);
+    const char *iname = NULL, *iip = NULL;
+    uint16_t port = service_registry_span_port(&prec->port);
+    int *slot = NULL;
+
+    iname = service_registry_intern(psreg, prec->name.start, prec->name.len, (pvs->removed == NULL));
+    iip = service_registry_intern(psreg, prec->ip.start, prec->ip.len, (pvs->removed == NULL));
+    if ((iname == NULL) || (iip == NULL)) {
+        return (pvs->removed != NULL ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
 
-    skn_strip(key); // cleanup first
-    for (index = 0; names[index] != NULL; index++) { // find direct match
-        if (strcmp(names[index], key) == 0) {
-            result = offsets[index];
-            break;
+    slot = service_registry_index_slot(psreg, iname, iip, port);
+    if (pvs->removed != NULL) {
+        if ((*slot != 0) && (pvs->removed[*slot - 1] == 0)) {
+            pvs->removed[*slot - 1] = 1;
+            pvs->changes++;
         }
+        return EXIT_SUCCESS;
     }
-    if (result == NULL) { // try to guess what the key is
-        if ((guess = strstr(key, "e")) != NULL) {
-            result = offsets[0];
-        } else if ((guess = strstr(key, "i")) != NULL) {
-            result = offsets[1];
-        } else if ((guess = strstr(key, "t")) != NULL) {
-            result = offsets[2];
-        }
+    if (*slot != 0) {
+        return EXIT_SUCCESS;
     }
+    pvs->changes++;
 
-    return result;
+    return service_registry_entry_add(psreg, iname, iip, port);
 }
 
 /**
- * service_registry_response_parse()
- *
- * Parse this response message, guess spellings, skip invalid, export error count
- *
- * Format: name=rpi_locator_service,ip=10.100.1.19,port=48028|
- *         name=lcd_display_service,ip=10.100.1.19,port=48029|
- *
- *  the vertical bar char '|' is the line separator, % and ; are also supported
- *
+ * service_registry_view_apply()
+ * - builds the next registry from a complete set of pages: a full reply
+ *   replaces the view, a delta drops its removals and adds its additions
+ * - Returns EXIT_SUCCESS | EXIT_FAILURE
 */
-static int service_registry_response_parse(PServiceRegistry psreg, const char *response, int *errors) {
-    int control = 1;
-    char *base = NULL, *psep = NULL, *resp = NULL, *line = NULL,
-         *keypair = NULL, *element = NULL,
-         *name = NULL, *ip = NULL, *pport = NULL,
-         **meta = NULL;
-
-    base = resp = strdup(response);
+static int service_registry_view_apply(PRegistryView prv, char **page, int pages) {
+    RegistryPageHeader rph;
+    PRegistryEntry prent = NULL;
+    ViewScan vs;
+    int index = 0, full = 0, body = 0;
 
-    if (strstr(response, "|")) {
-        psep = "|";
-    } else if (strstr(response, "%")) {
-        psep = "%";
-    } else if (strstr(response, ";")) {
-        psep = ";";
+    memset(&vs, 0, sizeof(vs));
+    vs.psr = service_registry_create();
+    vs.previous = prv->psr;
+    if (vs.psr == NULL) {
+        return EXIT_FAILURE;
     }
 
-    while ((line = strsep(&resp, psep)) != NULL) {
-        if (strlen(line) < 16) {
-            continue;
+    for (index = 0; index < pages; index++) {
+        if (service_registry_page_header(page[index], &rph) == EXIT_FAILURE) {
+            full = 1;                    // a text response, from a locator without pages
+        } else if (strcmp(rph.op, "full") == 0) {
+            full = 1;
         }
+    }
 
-        pport = ip = name = NULL;
-        while ((keypair = strsep(&line, ",")) != NULL) {
-            if (strlen(keypair) < 1) {
-                continue;
+    /* removals first, against the previous registry */
+    if ((full == 0) && (vs.previous != NULL)) {
+        vs.removed = (char *) calloc(vs.previous->count + 1, sizeof(char));
+        if (vs.removed == NULL) {
+            service_registry_destroy(vs.psr);
+            return EXIT_FAILURE;
+        }
+        for (index = 0; index < pages; index++) {
+            if ((service_registry_page_header(page[index], &rph) == EXIT_SUCCESS) && (strcmp(rph.op, "del") == 0)) {
+                service_registry_response_scan(&page[index][rph.body], service_registry_view_record, &vs, NULL);
             }
-
-            control = 1;
-            element = strstr(keypair, "=");
-            if (element != NULL) {
-                element[0] = 0;
-                meta = service_registry_entry_create_helper(keypair, &name, &ip, &pport);
-                if (meta != NULL && (element[1] != 0)) {
-                    *meta = skn_strip(++element);
-                } else {
-                    control = 0;
-                    if (errors != NULL)
-                        (*errors)++;
-                    skn_logger(SD_WARNING, "Response format failure: for name=%s, ip=%s, port=%s, first failing entry: [%s]", name, ip, pport, keypair);
-                    break;
-                }
+        }
+        for (index = 0; index < vs.previous->count; index++) {
+            prent = vs.previous->entry[index];
+            if (vs.removed[index] == 0) {
+                service_registry_entry_add(vs.psr,
+                                           service_registry_intern(vs.psr, prent->name, strlen(prent->name), 1),
+                                           service_registry_intern(vs.psr, prent->ip, strlen(prent->ip), 1),
+                                           prent->port);
             }
-        } // end while line
+        }
+        free(vs.removed);
+        vs.removed = NULL;
+    }
 
-        if (control == 1) { // catch a breakout caused by no value
-            service_registry_entry_create(psreg, name, ip, pport, errors);
+    for (index = 0; index < pages; index++) {
+        body = 0;
+        if (service_registry_page_header(page[index], &rph) == EXIT_SUCCESS) {
+            if (strcmp(rph.op, "del") == 0) {
+                continue;
+            }
+            body = rph.body;
         }
+        service_registry_response_scan(&page[index][body], service_registry_view_record, &vs, NULL);
+    }
 
-    } // end while buffer
+    service_registry_destroy(prv->psr);
+    prv->psr = vs.psr;
+    prv->changes = vs.changes;
 
-    free(base);
-    return psreg->count;
+    return EXIT_SUCCESS;
 }
 
 /**
- * service_registry_get_via_udp_broadcast()
+ * service_registry_view_refresh()
  *
- * - Retrieves entries from every service that responds to the broadcast
- *   parses and builds a new Registry of all entries, or unique entries.
+ * - asks the view's locator for the changes since the view's version, or
+ *   broadcasts for every entry the first time and keeps the first locator
+ *   to answer; the view only changes once every page has arrived
+ * - a broadcast is answered with the first page only, so when there are
+ *   more that locator is asked again by unicast
+ * - a locator that restarted, or forgot that far back, answers in full
+ * - a locator without paged replies answers with its text response,
+ *   taken as the whole registry
  *
- * - Returns Populated Registry
+ * - Returns EXIT_SUCCESS | EXIT_FAILURE, the view unchanged
 */
-PServiceRegistry service_registry_get_via_udp_broadcast(int i_socket, char *request) {
-    struct sockaddr_in remaddr; /* remote address */
-    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
-    IPBroadcastArray aB;
-    int vIndex = 0;
-    char response[SZ_INFO_BUFF];
-    char recvHostName[SZ_INFO_BUFF];
+int service_registry_view_refresh(int i_socket, PRegistryView prv, double timeout) {
+    struct sockaddr_in remaddr;
+    socklen_t addrlen = sizeof(remaddr);
+    DiscoveryRequest dr;
+    RegistryPageHeader rph, first;
+    char *page[ARY_MAX_PAGES];
+    char request[SZ_CHAR_BUFF];
+    char response[SKN_REGISTRY_PAGE + 1];
+    struct in_addr locator;
     signed int rLen = 0;
-    struct timeval start;
-
-    memset(response, 0, sizeof(response));
-    memset(recvHostName, 0, sizeof(recvHostName));
-
-    get_broadcast_ip_array(&aB);
-    strncpy(gd_ch_intfName, aB.chDefaultIntfName, SZ_CHAR_BUFF);
-    strncpy(gd_ch_ipAddress, aB.ipAddrStr[aB.defaultIndex], SZ_CHAR_BUFF);
-
-    skn_logger(SD_NOTICE, "Socket Bound to %s", aB.ipAddrStr[aB.defaultIndex]);
-
-    gettimeofday(&start, NULL);
-    for (vIndex = 0; vIndex < aB.count; vIndex++) {
-        memset(&remaddr, 0, sizeof(remaddr));
-        remaddr.sin_family = AF_INET;
-        remaddr.sin_addr.s_addr = inet_addr(aB.broadAddrStr[vIndex]);
-        remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
+    int received = 0, pages = 0, bytes = 0, index = 0, rc = EXIT_FAILURE;
 
-        if (sendto(i_socket, request, strlen(request), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
-            skn_logger(SD_WARNING, "SendTo() Timed out; Failure code=%d, etext=%s", errno, strerror(errno));
-            break;
-        }
-        skn_logger(SD_NOTICE, "Message Broadcasted on %s:%s:%d", aB.ifNameStr[vIndex], aB.broadAddrStr[vIndex], SKN_FIND_RPI_PORT);
+    memset(page, 0, sizeof(page));
+    memset(&first, 0, sizeof(first));
+    locator = prv->locator;
+    if (prv->psr == NULL) {
+        snprintf(request, sizeof(request), "%s", SKN_PAGES_REQUEST);
+    } else {
+        snprintf(request, sizeof(request), "%s since=%lu.%lu", SKN_PAGES_REQUEST, prv->epoch, prv->version);
     }
 
-    PServiceRegistry psr = service_registry_create();
-    skn_logger(SD_DEBUG, "Waiting for all responses\n");
-    while (gi_exit_flag == SKN_RUN_MODE_RUN) { // depends on a socket timeout of 5 seconds
+    service_registry_discovery_init(&dr, NULL, 1, timeout);
+    dr.unicast = locator;
+    service_registry_discovery_send(i_socket, request, &dr);
 
-        rLen = recvfrom(i_socket, response, (SZ_INFO_BUFF - 1), 0, (struct sockaddr *) &remaddr, &addrlen);
-        if (rLen == PLATFORM_ERROR) {  // EAGAIN
+    while (((dr.broadcasts + dr.probes) > 0) && (service_registry_discovery_wait(i_socket, &dr.deadline) == EXIT_SUCCESS)) {
+        addrlen = sizeof(remaddr);
+        rLen = recvfrom(i_socket, response, (sizeof(response) - 1), MSG_DONTWAIT, (struct sockaddr *) &remaddr, &addrlen);
+        if (rLen == PLATFORM_ERROR) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
             break;
         }
         response[rLen] = 0;
 
-        rLen = getnameinfo(((struct sockaddr *) &remaddr), sizeof(struct sockaddr_in), recvHostName, (SZ_INFO_BUFF -1), NULL, 0, NI_DGRAM);
-        if (rLen != 0) {
-            skn_logger(SD_EMERG, "getnameinfo() failed: %s\n", gai_strerror(rLen));
+        if (service_registry_page_header(response, &rph) == EXIT_FAILURE) {
+            rph.page = rph.pages = 1;    // text response
+        }
+        if (locator.s_addr == 0) {
+            locator = remaddr.sin_addr;
+        }
+        if ((remaddr.sin_addr.s_addr != locator.s_addr) ||
+            ((received > 0) && ((rph.epoch != first.epoch) || (rph.version != first.version) || (rph.pages != first.pages))) ||
+            ((rph.epoch == prv->epoch) && (rph.version < prv->version)) ||
+            (page[rph.page - 1] != NULL)) {
+            continue;                    // another locator, a late page of an earlier reply, or a duplicate
+        }
+        if ((received == 0) && (dr.unicast.s_addr == 0) && (rph.pages > 1)) {
+            dr.unicast = locator;
+            service_registry_discovery_send(i_socket, request, &dr);
+            continue;
+        }
+        if (received == 0) {
+            first = rph;
+            pages = rph.pages;
+        }
+        page[rph.page - 1] = strdup(response);
+        bytes += rLen;
+        if (++received == pages) {
             break;
         }
+    }
 
-        skn_logger(SD_DEBUG, "Response(%1.3fs) received from %s @ %s:%d",
-                        skn_duration_in_milliseconds(&start, NULL),
-                        recvHostName,
-                        inet_ntoa(remaddr.sin_addr),
-                        ntohs(remaddr.sin_port)
-                  );
-        service_registry_response_parse(psr, response, NULL);
+    if ((received > 0) && (received == pages) && (service_registry_view_apply(prv, page, pages) == EXIT_SUCCESS)) {
+        prv->locator = locator;
+        prv->epoch = first.epoch;
+        prv->version = first.version;
+        prv->pages = pages;
+        prv->bytes = bytes;
+        rc = EXIT_SUCCESS;
+    } else {
+        skn_logger(SD_NOTICE, "RegistryView: refresh from %s incomplete, %d of %d pages",
+                   (locator.s_addr != 0 ? inet_ntoa(locator) : "broadcast"), received, pages);
     }
 
-    return (psr);
+    for (index = 0; index < ARY_MAX_PAGES; index++) {
+        free(page[index]);
+    }
+
+    return rc;
 }
 
 /**
  * service_registry_destroy()
- * - Free each entry, then the Registry itself.
+ * - Release the arena holding every entry and string, then the Registry itself.
 */
 void service_registry_destroy(PServiceRegistry psreg) {
-    int index = 0;
-
     if (psreg == NULL)
         return;
 
-    for (index = 0; index < psreg->count; index++) {
-        free(psreg->entry[index]);
-    }
+    service_registry_arena_release(&psreg->arena);
+    free(psreg->entry);
+    free(psreg->key_index);
+    free(psreg->name_index);
+    free(psreg->intern);
     free(psreg);
 }
@@ -31,9 +31,42 @@ extern char gd_ch_hostShortName[SZ_CHAR_BUFF];
 extern int gd_i_display;
 extern int gd_i_unique_registry;
 extern int gd_i_update;
+extern int gd_i_workers;
+extern int gd_i_batch_size;
+extern int gd_i_quorum;
+extern int gd_i_lease;
+extern int gd_i_wire;
+extern int gd_i_jitter;
+extern char * gd_pch_discovery_cache;
+extern char * gd_pch_multicast_group;
+extern int gd_i_multicast_ttl;
+extern int gd_i_locator_port;
+extern char * gd_pch_replicate;
+extern char * gd_pch_shared_registry;
+extern int gd_i_rate_limit;
+extern int gd_i_relay;
+extern char * gd_pch_relay_host;
 extern char * gd_pch_service_name;
 extern int gd_i_i2c_address;
 
+/*
+ * Globals defined in skn_display_render.c
+*/
+extern int gd_i_rows;
+extern int gd_i_cols;
+extern char *gd_pch_device_name;
+extern int gd_i_ring_policy;
+extern int gd_i_frame_rate;
+extern double gd_d_scroll_speed[ARY_MAX_LCD_ROWS];
+extern PDisplayManager gp_structure_pdm;
+
+/*
+ * Globals defined in skn_display_serial.c
+*/
+extern char *gd_pch_serial_port;
+extern int gd_i_serial_baud;
+extern int gd_i_serial_pacing;
+
 /*
  * General Utilities
 */
@@ -58,6 +91,14 @@ extern void signals_cleanup(int sig);
 */
 extern int skn_udp_host_create_broadcast_socket(int port, double rcvTimeout);
 extern int skn_udp_host_create_regular_socket(int port, double rcvTimeout);
+extern int skn_udp_host_create_reuseport_socket(int port, double rcvTimeout);
+extern int skn_udp_host_join_multicast_group(int i_socket, const char *group);
+extern PUDPBatch skn_udp_batch_create(int batch_size);
+extern void skn_udp_batch_destroy(PUDPBatch pb);
+extern int skn_udp_batch_receive(PUDPBatch pb, int i_socket);
+extern int skn_udp_batch_reply(PUDPBatch pb, int index, const void *reply, int len);
+extern int skn_udp_batch_send(PUDPBatch pb, int i_socket);
+extern int skn_udp_send_failure(struct sockaddr_in *premaddr);
 extern PServiceRequest skn_service_request_create(PRegistryEntry pre, int host_socket, char *request);
 extern int skn_udp_service_request(PServiceRequest psr);
 extern int skn_display_manager_message_consumer_startup(PDisplayManager pdm);
@@ -68,17 +109,158 @@ extern int get_broadcast_ip_array(PIPBroadcastArray paB);
 extern void service_registry_entry_response_message_log(const char * response);
 extern void get_default_interface_name_and_ipv4_address(char * intf, char * ipv4);
 
+/*
+ * Event Manager Routines
+ */
+extern PEventManager skn_event_manager_create(const char *name);
+extern void skn_event_manager_destroy(PEventManager pem);
+extern int skn_event_manager_add_socket(PEventManager pem, int fd, int (*handler)(void *pem, void *pes), void *context);
+extern int skn_event_manager_add_timer(PEventManager pem, double interval, int (*handler)(void *pem, void *pes), void *context);
+extern int skn_event_manager_add_signals(PEventManager pem, sigset_t *mask, int (*handler)(void *pem, void *pes), void *context);
+extern int skn_event_timer_arm(int fd, double initial, double interval);
+extern int skn_event_manager_run(PEventManager pem);
+extern void skn_event_manager_stop(PEventManager pem);
+extern void skn_event_manager_request_shutdown();
+
+/*
+ * Interface Cache Routines
+ */
+extern int skn_interface_cache_startup();
+extern void skn_interface_cache_shutdown();
+extern PInterfaceSnapshot skn_interface_cache_snapshot();
+extern PInterfaceEntry skn_interface_cache_default(PInterfaceSnapshot pis);
+
+/*
+ * Reverse DNS Cache Routines
+ */
+extern int skn_resolver_startup();
+extern void skn_resolver_shutdown();
+extern int skn_resolver_host_name(struct sockaddr_in *paddr, char *name, int len);
+extern void skn_resolver_log_counters();
+
+/*
+ * Timer wheel Routines
+ */
+extern void skn_timer_wheel_init(PTimerWheel ptw);
+extern void skn_timer_wheel_add(PTimerWheel ptw, PWheelTimer pwt, unsigned long ticks);
+extern void skn_timer_wheel_remove(PTimerWheel ptw, PWheelTimer pwt);
+extern int skn_timer_wheel_advance(PTimerWheel ptw, void (*expire)(PWheelTimer pwt, void *context), void *context);
+
+/*
+ * Rate limiter Routines
+ */
+extern PRateLimiter skn_rate_limiter_create(int rate);
+extern void skn_rate_limiter_destroy(PRateLimiter prl);
+extern double skn_rate_limiter_now();
+extern int skn_rate_limiter_admit(PRateLimiter prl, in_addr_t addr, double now);
+extern void skn_rate_limiter_charge(PRateLimiter prl, in_addr_t addr, int tokens);
+extern void skn_rate_limiter_log_counters(PRateLimiter prl, const char *owner);
+
 /*
  * Service Registry Public Routines
  */
+extern PServiceRegistry service_registry_create();
+extern int service_registry_entry_create(PServiceRegistry psreg, char *name, char *ip, char *port, int *errors);
+extern int service_registry_response_scan(const char *response, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors);
 extern PServiceRegistry service_registry_valiadated_registry(const char *response);
 extern int service_registry_valiadate_response_format(const char *response);
 extern int service_registry_provider(int i_socket, char *response);
+extern int service_registry_provider_workers(char *response, int workers);
 extern PServiceRegistry service_registry_get_via_udp_broadcast(int i_socket, char *request);
+extern void service_registry_discovery_init(PDiscoveryRequest pdr, const char *service_name, int min_responders, double timeout);
+extern PServiceRegistry service_registry_discover(int i_socket, char *request, PDiscoveryRequest pdr);
+extern int skn_wire_is_binary(const char *message, int len);
+extern int skn_wire_encode_text(char *buffer, int size, int type, int code, const char *text);
+extern int skn_wire_decode_text(const char *message, int len, int *code, char *text, int size);
+extern int skn_wire_registry_begin(char *buffer, int size);
+extern int skn_wire_registry_add(char *buffer, int size, int len, const char *name, struct in_addr addr, uint16_t port);
+extern int skn_wire_registry_scan(const char *message, int len, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors);
+extern int service_registry_message_scan(const char *message, int len, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors);
+extern int service_registry_page_header(const char *response, PRegistryPageHeader prph);
+extern void service_registry_view_init(PRegistryView prv);
+extern int service_registry_view_refresh(int i_socket, PRegistryView prv, double timeout);
+extern void service_registry_view_destroy(PRegistryView prv);
+extern int service_registry_query_parse(const char *request, PRegistryQuery prq);
+extern int service_registry_query_wants(PRegistryQuery prq, const char *name, in_addr_t addr, uint16_t port);
+extern int service_registry_query_request(char *request, int size, const char *want, PServiceRegistry known);
+extern uint16_t service_registry_span_port(PRegistrySpan psp);
+
+/*
+ * Registry provider internals, shared with gossip; callers hold the write lock
+ */
+extern int service_registry_provider_rebuild(PServiceProvider psp);
+extern void service_registry_provider_retire(PServiceProvider psp, PRegistryLease pl);
+extern void service_registry_provider_admit(PServiceProvider psp, PRegistryLease pl);
+
+/*
+ * Registry gossip Routines
+ */
+extern int service_registry_gossip_seed(PServiceProvider psp, const char *list);
+extern int service_registry_gossip_is_self(struct in_addr addr, uint16_t port);
+extern int service_registry_gossip_paginate(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, int pages, uint64_t mask);
+extern int service_registry_gossip_answer(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, const char *request, int len);
+extern int service_registry_gossip_start(PServiceProvider psp, PEventManager pem);
+extern void service_registry_gossip_stop(PServiceProvider psp);
+extern void service_registry_gossip_log_counters(PServiceProvider psp);
+
+/*
+ * Registry relay Routines
+ */
+extern int service_registry_relay_answer(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr);
+extern int service_registry_relay_start(PServiceProvider psp, PEventManager pem);
+extern void service_registry_relay_stop(PServiceProvider psp);
+extern void service_registry_relay_log_counters(PServiceProvider psp);
+
+/*
+ * Shared registry Routines
+ */
+extern int service_registry_shared_open(PServiceProvider psp);
+extern void service_registry_shared_publish(PServiceProvider psp);
+extern void service_registry_shared_close(PServiceProvider psp);
+extern PServiceRegistry service_registry_shared_lookup(const char *service_name);
+extern PServiceRegistry service_registry_discover_shared(int i_socket, char *request, PDiscoveryRequest pdr);
+
+/*
+ * Discovery cache Routines
+ */
+extern PServiceRegistry service_registry_discover_cached(int i_socket, char *request, PDiscoveryRequest pdr);
 extern int service_registry_entry_count(PServiceRegistry psr);
 extern int service_registry_list_entries(PServiceRegistry psr);
 extern PRegistryEntry service_registry_find_entry(PServiceRegistry psreg, char *serviceName);
 extern void * service_registry_get_entry_field_ref(PRegistryEntry prent, char *field);
 extern void service_registry_destroy(PServiceRegistry psreg);
 
+/*
+ * Display render Routines
+ */
+extern PDisplayManager skn_display_manager_create(char * welcome);
+extern void skn_display_manager_destroy(PDisplayManager pdm);
+extern PDisplayManager skn_get_display_manager_ref();
+extern PDisplayLine skn_display_manager_add_line(PDisplayManager pdmx, char * client_request_message);
+extern int skn_display_manager_render_frame(PDisplayManager pdm, double elapsed);
+extern void skn_display_manager_log_counters(PDisplayManager pdm);
+extern int skn_scroller_scroll_lines(PDisplayLine pdl, char *row, double cells);
+extern char * skn_scroller_pad_right(char *buffer);
+extern char * skn_scroller_wrap_blanks(char *buffer);
+extern int skn_display_ring_publish(PDisplayRing prg, const char *message);
+extern void skn_display_frame_init(PDisplayManager pdm);
+extern void skn_display_frame_schedule(PDisplayManager pdm, double interval);
+extern double skn_display_frame_tick(PDisplayManager pdm, uint64_t expirations);
+
+/*
+ * Display simulator Routines
+ */
+extern PLCDDevice skn_device_manager_Simulator(PDisplayManager pdm);
+extern int skn_display_sim_compare(PDisplayManager pdm);
+extern void skn_display_sim_dump(PDisplayManager pdm);
+extern void skn_display_sim_log_counters(PDisplayManager pdm);
+extern void skn_display_sim_destroy(PDisplayManager pdm);
+
+/*
+ * Display serial Routines
+ */
+extern PLCDDevice skn_device_manager_SerialPort(PDisplayManager pdm);
+extern void skn_device_manager_serial_shutdown(PDisplayManager pdm);
+extern int skn_display_serial_baud_valid(int baud);
+
 #endif // SKN_NETWORK_HELPERS_H__
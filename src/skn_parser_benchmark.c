@@ -0,0 +1,310 @@
+/**
+ * skn_parser_benchmark.c
+ * - Developer tool, not installed
+ *
+ * Compares service_registry_response_scan() against the strdup()/strsep()
+ * parser it replaced.  Random responses using each of the '|', '%' and ';'
+ * separators must produce the same records and error counts from both, then
+ * parse and validate-only cost is reported per response.
+ *
+ * cmdline: ./skn_parser_benchmark [rounds]
+*/
+
+#include "skn_network_helpers.h"
+
+#define BENCH_MAX_RECORDS 64
+#define BENCH_RESPONSES   2000
+
+typedef struct _legacyRecord {
+    char name[SZ_INFO_BUFF];
+    char ip[SZ_INFO_BUFF];
+    char port[SZ_INFO_BUFF];
+} LegacyRecord, *PLegacyRecord;
+
+typedef struct _parseResult {
+    int count;
+    int errors;
+    LegacyRecord record[BENCH_MAX_RECORDS];
+} ParseResult, *PParseResult;
+
+static char gs_response[BENCH_RESPONSES][SZ_INFO_BUFF];
+
+/*
+ * The previous parser, kept verbatim apart from where its entries go */
+static void * legacy_entry_create_helper(char *key, char **name, char **ip, char **port) {
+    int index = 0;
+    char * guess = NULL;
+    void * result = NULL;
+    char * names[4] = { "name", "ip", "port", NULL };
+    void * offsets[] = { name, ip, port, NULL };
+
+    skn_strip(key); // cleanup first
+    for (index = 0; names[index] != NULL; index++) { // find direct match
+        if (strcmp(names[index], key) == 0) {
+            result = offsets[index];
+            break;
+        }
+    }
+    if (result == NULL) { // try to guess what the key is
+        if ((guess = strstr(key, "e")) != NULL) {
+            result = offsets[0];
+        } else if ((guess = strstr(key, "i")) != NULL) {
+            result = offsets[1];
+        } else if ((guess = strstr(key, "t")) != NULL) {
+            result = offsets[2];
+        }
+    }
+
+    return result;
+}
+
+static void legacy_entry_create(PServiceRegistry psreg, PParseResult ppr, char *name, char *ip, char *port, int *errors) {
+    if (psreg != NULL) {
+        service_registry_entry_create(psreg, name, ip, port, errors);
+        return;
+    }
+    if ((name == NULL) || (ip == NULL) || (port == NULL)) {
+        (*errors)++;
+        return;
+    }
+    if (ppr->count < BENCH_MAX_RECORDS) {
+        strcpy(ppr->record[ppr->count].name, name);
+        strcpy(ppr->record[ppr->count].ip, ip);
+        strcpy(ppr->record[ppr->count].port, port);
+        ppr->count++;
+    }
+}
+
+static void legacy_response_parse(PServiceRegistry psreg, PParseResult ppr, const char *response, int *errors) {
+    int control = 1;
+    char *base = NULL, *psep = NULL, *resp = NULL, *line = NULL,
+         *keypair = NULL, *element = NULL,
+         *name = NULL, *ip = NULL, *pport = NULL,
+         **meta = NULL;
+
+    base = resp = strdup(response);
+
+    if (strstr(response, "|")) {
+        psep = "|";
+    } else if (strstr(response, "%")) {
+        psep = "%";
+    } else if (strstr(response, ";")) {
+        psep = ";";
+    }
+
+    while ((line = strsep(&resp, psep)) != NULL) {
+        if (strlen(line) < 16) {
+            continue;
+        }
+
+        pport = ip = name = NULL;
+        while ((keypair = strsep(&line, ",")) != NULL) {
+            if (strlen(keypair) < 1) {
+                continue;
+            }
+
+            control = 1;
+            element = strstr(keypair, "=");
+            if (element != NULL) {
+                element[0] = 0;
+                meta = legacy_entry_create_helper(keypair, &name, &ip, &pport);
+                if (meta != NULL && (element[1] != 0)) {
+                    *meta = skn_strip(++element);
+                } else {
+                    control = 0;
+                    (*errors)++;
+                    break;
+                }
+            }
+        } // end while line
+
+        if (control == 1) { // catch a breakout caused by no value
+            legacy_entry_create(psreg, ppr, name, ip, pport, errors);
+        }
+
+    } // end while buffer
+
+    free(base);
+}
+
+static int scan_record(PRegistryRecord prec, void *context) {
+    PParseResult ppr = (PParseResult) context;
+
+    if (ppr->count < BENCH_MAX_RECORDS) {
+        snprintf(ppr->record[ppr->count].name, SZ_INFO_BUFF, "%.*s", prec->name.len, prec->name.start);
+        snprintf(ppr->record[ppr->count].ip, SZ_INFO_BUFF, "%.*s", prec->ip.len, prec->ip.start);
+        snprintf(ppr->record[ppr->count].port, SZ_INFO_BUFF, "%.*s", prec->port.len, prec->port.start);
+        ppr->count++;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Random responses built from well formed, misspelled, padded and broken
+ * pieces; fragments never contain a separator character */
+static void bench_generate(char sep, int malformed) {
+    static const char *keys[] = { "name", "ip", "port", " name", "port ", "nmae", "ipaddr", "prot", "Name", "xyz", "" };
+    static const char *values[] = { "svc_a", "lcd_display_service", "10.100.1.19", "48028", " 48029 ",
+                                    "-junk", "a=b", "4802 8", " ", "", "...", "\tpad\t" };
+    static const char *good[] = { "name=rpi_locator_service", "ip=10.100.1.19", "port=48028" };
+    char *presp = NULL;
+    int index = 0, line = 0, lines = 0, pair = 0, pairs = 0, len = 0;
+
+    for (index = 0; index < BENCH_RESPONSES; index++) {
+        presp = gs_response[index];
+        len = 0;
+        lines = 1 + (rand() % 6);
+        for (line = 0; line < lines && len < (SZ_INFO_BUFF - 128); line++) {
+            pairs = (malformed ? 1 + (rand() % 4) : 3);
+            for (pair = 0; pair < pairs; pair++) {
+                if ((rand() % 100) >= malformed) {
+                    len += snprintf(&presp[len], SZ_INFO_BUFF - len, "%s%s", (pair ? "," : ""), good[pair % 3]);
+                } else if (rand() % 4 == 0) {
+                    len += snprintf(&presp[len], SZ_INFO_BUFF - len, "%s%s", (pair ? ",," : ""), values[rand() % 12]);
+                } else {
+                    len += snprintf(&presp[len], SZ_INFO_BUFF - len, "%s%s=%s", (pair ? "," : ""),
+                                    keys[rand() % 11], values[rand() % 12]);
+                }
+            }
+            if ((line + 1) < lines || lines == 1 || (rand() % 2)) {  // the old parser needs one separator
+                presp[len++] = sep;
+                presp[len] = 0;
+            }
+        }
+    }
+}
+
+/*
+ * Returns count of responses where the two parsers disagree */
+static int bench_compare(int *records, int *errors) {
+    static ParseResult legacy, scan;
+    int index = 0, record = 0, diffs = 0;
+
+    for (index = 0; index < BENCH_RESPONSES; index++) {
+        memset(&legacy, 0, sizeof(legacy));
+        memset(&scan, 0, sizeof(scan));
+        legacy_response_parse(NULL, &legacy, gs_response[index], &legacy.errors);
+        service_registry_response_scan(gs_response[index], scan_record, &scan, &scan.errors);
+        *records += legacy.count;
+        *errors += legacy.errors;
+
+        if ((legacy.count != scan.count) || (legacy.errors != scan.errors)) {
+            diffs++;
+            skn_logger(SD_ERR, "Differs: records %d/%d errors %d/%d [%s]",
+                       legacy.count, scan.count, legacy.errors, scan.errors, gs_response[index]);
+            continue;
+        }
+        for (record = 0; record < legacy.count; record++) {
+            if ((strcmp(legacy.record[record].name, scan.record[record].name) != 0) ||
+                (strcmp(legacy.record[record].ip, scan.record[record].ip) != 0) ||
+                (strcmp(legacy.record[record].port, scan.record[record].port) != 0)) {
+                diffs++;
+                skn_logger(SD_ERR, "Differs: record %d (%s,%s,%s)/(%s,%s,%s) [%s]", record,
+                           legacy.record[record].name, legacy.record[record].ip, legacy.record[record].port,
+                           scan.record[record].name, scan.record[record].ip, scan.record[record].port,
+                           gs_response[index]);
+                break;
+            }
+        }
+    }
+
+    return diffs;
+}
+
+/*
+ * ns per response: parse into a registry, then validate only;
+ * the responses are well formed so neither parser logs */
+static void bench_time(char sep, int rounds) {
+    PServiceRegistry psr = NULL;
+    struct timeval start;
+    double parse = 0.0, validate = 0.0, lparse = 0.0, lvalidate = 0.0;
+    int round = 0, index = 0, errors = 0;
+
+    for (round = 0; round < rounds; round++) {
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_RESPONSES; index++) {
+            service_registry_destroy(service_registry_valiadated_registry(gs_response[index]));
+        }
+        parse += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_RESPONSES; index++) {
+            errors += service_registry_valiadate_response_format(gs_response[index]);
+        }
+        validate += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_RESPONSES; index++) {
+            psr = service_registry_create();
+            legacy_response_parse(psr, NULL, gs_response[index], &errors);
+            service_registry_destroy(psr);
+        }
+        lparse += skn_duration_in_milliseconds(&start, NULL);
+
+        /* the old validate built and destroyed a registry too */
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_RESPONSES; index++) {
+            psr = service_registry_create();
+            legacy_response_parse(psr, NULL, gs_response[index], &errors);
+            service_registry_destroy(psr);
+        }
+        lvalidate += skn_duration_in_milliseconds(&start, NULL);
+    }
+
+    /* seconds per round to nanoseconds per response */
+    parse     *= 1.0e9 / ((double) rounds * BENCH_RESPONSES);
+    validate  *= 1.0e9 / ((double) rounds * BENCH_RESPONSES);
+    lparse    *= 1.0e9 / ((double) rounds * BENCH_RESPONSES);
+    lvalidate *= 1.0e9 / ((double) rounds * BENCH_RESPONSES);
+
+    skn_logger(" ", "   '%c'  %10.1f %10.1f   %10.1f %10.1f", sep, parse, validate, lparse, lvalidate);
+}
+
+int main(int argc, char *argv[]) {
+    char seps[] = { '|', '%', ';' };
+    int rounds = 10, index = 0, diffs = 0, quiet = 0, saved = 0, records = 0, errors = 0;
+
+    skn_program_name_and_description_set(
+            "skn_parser_benchmark",
+            "Registry response parser comparison and benchmark."
+            );
+
+    if (argc > 1) {
+        rounds = atoi(argv[1]);
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    /* both parsers log every malformed line; keep the report readable */
+    saved = dup(STDERR_FILENO);
+    quiet = open("/dev/null", O_WRONLY);
+
+    srand(1);
+    for (index = 0; index < (int) sizeof(seps); index++) {
+        bench_generate(seps[index], 30);
+        records = errors = 0;
+        dup2(quiet, STDERR_FILENO);
+        diffs = bench_compare(&records, &errors);
+        dup2(saved, STDERR_FILENO);
+        skn_logger(" ", "Separator '%c': %d random responses, %d records, %d errors, %d differ from the previous parser",
+                   seps[index], BENCH_RESPONSES, records, errors, diffs);
+        if (diffs > 0) {
+            bench_compare(&records, &errors);  // again, with the differences logged
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    skn_logger(" ", "\nResponse parser benchmark, %d rounds of %d well formed responses, ns per response",
+               rounds, BENCH_RESPONSES);
+    skn_logger(" ", "%6s  %10s %10s   %10s %10s", "sep", "parse", "validate", "old-parse", "old-valid");
+    for (index = 0; index < (int) sizeof(seps); index++) {
+        bench_generate(seps[index], 0);
+        bench_time(seps[index], rounds);
+    }
+
+    close(quiet);
+    close(saved);
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,213 @@
+/*
+ * skn_rate_limiter.c
+ *
+ *  Per-source token buckets for the locator and display services.
+ *  - one table per receiving thread, so admitting takes no lock
+ *  - sources are found by address hash, and kept in least recently seen order
+ *  - a full table gives the least recently seen source's slot to a new one
+ */
+
+#include "skn_network_helpers.h"
+
+static int skn_rate_limiter_find(PRateLimiter prl, in_addr_t addr, unsigned int slot);
+static void skn_rate_limiter_unhash(PRateLimiter prl, int index);
+static void skn_rate_limiter_touch(PRateLimiter prl, int index);
+
+static unsigned int skn_rate_limiter_slot(in_addr_t addr) {
+    return (((uint32_t) addr * 2654435761U) >> 16) & (ARY_MAX_RATE_SOURCES - 1);
+}
+
+static int skn_rate_limiter_find(PRateLimiter prl, in_addr_t addr, unsigned int slot) {
+    int index = prl->hash[slot];
+
+    while ((index != -1) && (prl->source[index].addr != addr)) {
+        index = prl->source[index].hash_next;
+    }
+
+    return index;
+}
+
+/*
+ * takes a source out of its hash chain, before its slot is reused */
+static void skn_rate_limiter_unhash(PRateLimiter prl, int index) {
+    int *link = &prl->hash[skn_rate_limiter_slot(prl->source[index].addr)];
+
+    while ((*link != -1) && (*link != index)) {
+        link = &prl->source[*link].hash_next;
+    }
+    if (*link == index) {
+        *link = prl->source[index].hash_next;
+    }
+}
+
+/*
+ * moves a source to the head of the least recently seen list */
+static void skn_rate_limiter_touch(PRateLimiter prl, int index) {
+    PRateSource prs = &prl->source[index];
+
+    if (prl->lru_head == index) {
+        return;
+    }
+    if (prs->lru_prev != -1) {
+        prl->source[prs->lru_prev].lru_next = prs->lru_next;
+    }
+    if (prs->lru_next != -1) {
+        prl->source[prs->lru_next].lru_prev = prs->lru_prev;
+    }
+    if (prl->lru_tail == index) {
+        prl->lru_tail = prs->lru_prev;
+    }
+
+    prs->lru_prev = -1;
+    prs->lru_next = prl->lru_head;
+    if (prl->lru_head != -1) {
+        prl->source[prl->lru_head].lru_prev = index;
+    }
+    prl->lru_head = index;
+    if (prl->lru_tail == -1) {
+        prl->lru_tail = index;
+    }
+}
+
+/**
+ * skn_rate_limiter_create()
+ * - a table admitting rate datagrams a second from each source, in bursts
+ *   of up to SKN_RATE_BURST seconds' worth
+ *
+ * - returns PRateLimiter | NULL when rate is 0, unlimited
+ */
+PRateLimiter skn_rate_limiter_create(int rate) {
+    PRateLimiter prl = NULL;
+    int index = 0;
+
+    if (rate <= 0) {
+        return NULL;
+    }
+    prl = (PRateLimiter) malloc(sizeof(RateLimiter));
+    if (prl == NULL) {
+        skn_logger(SD_WARNING, "RateLimiter: cannot acquire needed resources, unlimited. %d:%s", errno, strerror(errno));
+        return NULL;
+    }
+
+    memset(prl, 0, sizeof(RateLimiter));
+    strcpy(prl->cbName, "PRateLimiter");
+    prl->rate = (double) rate;
+    prl->burst = prl->rate * SKN_RATE_BURST;
+    for (index = 0; index < ARY_MAX_RATE_SOURCES; index++) {
+        prl->hash[index] = -1;
+    }
+    prl->lru_head = prl->lru_tail = -1;
+
+    return prl;
+}
+
+void skn_rate_limiter_destroy(PRateLimiter prl) {
+    if (prl != NULL) {
+        free(prl);
+    }
+}
+
+/**
+ * skn_rate_limiter_now()
+ * - the clock admit() counts in; read once per batch, not per datagram
+ */
+double skn_rate_limiter_now() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (double) now.tv_sec + (now.tv_nsec / 1000000000.0);
+}
+
+/**
+ * skn_rate_limiter_admit()
+ * - takes a token from addr's bucket, topping it up for the time since
+ *   it was last seen; a new source starts with a full bucket
+ *
+ * - returns SKN_RATE_ADMITTED | SKN_RATE_SHED | SKN_RATE_BUSY when shed
+ *   and no busy reply went to addr in the last SKN_RATE_BUSY_INTERVAL
+ */
+int skn_rate_limiter_admit(PRateLimiter prl, in_addr_t addr, double now) {
+    PRateSource prs = NULL;
+    unsigned int slot = skn_rate_limiter_slot(addr);
+    int index = 0;
+
+    if (prl == NULL) {
+        return SKN_RATE_ADMITTED;
+    }
+
+    index = skn_rate_limiter_find(prl, addr, slot);
+    if (index == -1) {
+        if (prl->used < ARY_MAX_RATE_SOURCES) {
+            index = prl->used++;
+            prl->source[index].lru_prev = prl->source[index].lru_next = -1;  // not yet listed
+        } else {
+            index = prl->lru_tail;
+            skn_rate_limiter_unhash(prl, index);
+            prl->evicted++;
+        }
+        prs = &prl->source[index];
+        prs->addr = addr;
+        prs->tokens = prl->burst;
+        prs->stamp = now;
+        prs->busy = 0.0;
+        prs->hash_next = prl->hash[slot];
+        prl->hash[slot] = index;
+    }
+    prs = &prl->source[index];
+    skn_rate_limiter_touch(prl, index);
+
+    if (now > prs->stamp) {
+        prs->tokens += (now - prs->stamp) * prl->rate;
+        if (prs->tokens > prl->burst) {
+            prs->tokens = prl->burst;
+        }
+        prs->stamp = now;
+    }
+    if (prs->tokens >= 1.0) {
+        prs->tokens -= 1.0;
+        prl->admitted++;
+        return SKN_RATE_ADMITTED;
+    }
+
+    prl->shed++;
+    if ((now - prs->busy) >= SKN_RATE_BUSY_INTERVAL) {
+        prs->busy = now;
+        prl->busy++;
+        return SKN_RATE_BUSY;
+    }
+
+    return SKN_RATE_SHED;
+}
+
+/**
+ * skn_rate_limiter_charge()
+ * - takes tokens more from addr's bucket, for the datagrams sent past the
+ *   first in reply to a request it just admitted
+ * - the bucket may go below zero, the source is then shed until it refills
+ */
+void skn_rate_limiter_charge(PRateLimiter prl, in_addr_t addr, int tokens) {
+    int index = 0;
+
+    if ((prl == NULL) || (tokens <= 0)) {
+        return;
+    }
+
+    index = skn_rate_limiter_find(prl, addr, skn_rate_limiter_slot(addr));
+    if (index != -1) {
+        prl->source[index].tokens -= tokens;
+        prl->charged += (unsigned long) tokens;
+    }
+}
+
+/**
+ * skn_rate_limiter_log_counters()
+ * - one line of what owner admitted and shed, nothing when unlimited
+ */
+void skn_rate_limiter_log_counters(PRateLimiter prl, const char *owner) {
+    if (prl == NULL) {
+        return;
+    }
+
+    skn_logger(SD_NOTICE, "%s: rate limit %1.0f/s, %lu admitted, %lu shed, %lu busy replies, %lu charged, %d sources, %lu evicted",
+               owner, prl->rate, prl->admitted, prl->shed, prl->busy, prl->charged, prl->used, prl->evicted);
+}
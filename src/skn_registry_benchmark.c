@@ -0,0 +1,216 @@
+/**
+ * skn_registry_benchmark.c
+ * - Developer tool, not installed
+ *
+ * Measures ServiceRegistry build, merge and lookup cost at 128, 1k and 10k
+ * entries, against the linear strcmp scan the registry used before it was
+ * hash indexed.  Then reports the memory held per 1k entries by the arena
+ * backed registry against the old one-malloc-per-entry layout.
+ *
+ * cmdline: ./skn_registry_benchmark [rounds]
+*/
+
+#include "skn_network_helpers.h"
+
+#define BENCH_MAX_ENTRIES 10000
+
+static char gs_names[BENCH_MAX_ENTRIES][SZ_CHAR_LABEL];
+static char gs_ips[BENCH_MAX_ENTRIES][SZ_CHAR_LABEL];
+static char gs_ports[BENCH_MAX_ENTRIES][8];
+
+/*
+ * The previous registry: a flat array of separately malloc'd entries, searched by name */
+typedef struct _legacyEntry {
+    char cbName[SZ_CHAR_BUFF];
+    char name[SZ_INFO_BUFF];
+    char ip[SZ_INFO_BUFF];
+    int port;
+} LegacyEntry, *PLegacyEntry;
+
+typedef struct _linearRegistry {
+    int count;
+    PLegacyEntry entry[BENCH_MAX_ENTRIES];
+} LinearRegistry, *PLinearRegistry;
+
+static PLegacyEntry linear_find(PLinearRegistry plr, const char *name) {
+    int index = 0;
+
+    for (index = 0; index < plr->count; index++) {
+        if (strcmp(name, plr->entry[index]->name) == 0) {
+            return plr->entry[index];
+        }
+    }
+    return NULL;
+}
+
+static void linear_upsert(PLinearRegistry plr, int item) {
+    PLegacyEntry prent = linear_find(plr, gs_names[item]);
+
+    if (prent == NULL) {
+        prent = (PLegacyEntry) malloc(sizeof(LegacyEntry));
+        plr->entry[plr->count++] = prent;
+    }
+    memset(prent, 0, sizeof(LegacyEntry));
+    strcpy(prent->cbName, "PRegistryEntry");
+    strcpy(prent->name, gs_names[item]);
+    strcpy(prent->ip, gs_ips[item]);
+    prent->port = atoi(gs_ports[item]);
+}
+
+static void linear_destroy(PLinearRegistry plr) {
+    int index = 0;
+
+    for (index = 0; index < plr->count; index++) {
+        free(plr->entry[index]);
+    }
+    plr->count = 0;
+}
+
+static void bench_generate(int entries) {
+    int index = 0;
+
+    for (index = 0; index < entries; index++) {
+        snprintf(gs_names[index], SZ_CHAR_LABEL, "service_%05d", index);
+        snprintf(gs_ips[index], SZ_CHAR_LABEL, "10.%d.%d.%d", (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+        snprintf(gs_ports[index], sizeof(gs_ports[index]), "%d", 48000 + (index % 1000));
+    }
+}
+
+/*
+ * One size: build, merge the same entries again (every one a duplicate),
+ * then find each entry by name; reported per operation */
+static void bench_size(int entries, int rounds) {
+    static LinearRegistry lr;
+    PServiceRegistry psr = NULL;
+    struct timeval start;
+    double build = 0.0, merge = 0.0, lookup = 0.0,
+           lbuild = 0.0, lmerge = 0.0, llookup = 0.0;
+    int round = 0, index = 0, found = 0;
+
+    bench_generate(entries);
+
+    for (round = 0; round < rounds; round++) {
+        psr = service_registry_create();
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            service_registry_entry_create(psr, gs_names[index], gs_ips[index], gs_ports[index], NULL);
+        }
+        build += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            service_registry_entry_create(psr, gs_names[index], gs_ips[index], gs_ports[index], NULL);
+        }
+        merge += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            found += (service_registry_find_entry(psr, gs_names[index]) != NULL);
+        }
+        lookup += skn_duration_in_milliseconds(&start, NULL);
+
+        if (service_registry_entry_count(psr) != entries) {
+            skn_logger(SD_ERR, "Registry holds %d entries, expected %d", service_registry_entry_count(psr), entries);
+        }
+        service_registry_destroy(psr);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            linear_upsert(&lr, index);
+        }
+        lbuild += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            linear_upsert(&lr, index);
+        }
+        lmerge += skn_duration_in_milliseconds(&start, NULL);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < entries; index++) {
+            found -= (linear_find(&lr, gs_names[index]) != NULL);
+        }
+        llookup += skn_duration_in_milliseconds(&start, NULL);
+
+        linear_destroy(&lr);
+    }
+
+    if (found != 0) {
+        skn_logger(SD_ERR, "Hashed and linear lookups disagree by %d", found);
+    }
+
+    /* seconds per round to nanoseconds per operation */
+    build  *= 1.0e9 / ((double) rounds * entries);
+    merge  *= 1.0e9 / ((double) rounds * entries);
+    lookup *= 1.0e9 / ((double) rounds * entries);
+    lbuild *= 1.0e9 / ((double) rounds * entries);
+    lmerge *= 1.0e9 / ((double) rounds * entries);
+    llookup *= 1.0e9 / ((double) rounds * entries);
+
+    skn_logger(" ", "%7d  %10.1f %10.1f %10.1f   %10.1f %10.1f %10.1f",
+               entries, build, merge, lookup, lbuild, lmerge, llookup);
+}
+
+/*
+ * Memory held by a registry of 1000 entries, ten services on each of 100 hosts.
+ * malloc's own per allocation overhead is not counted */
+static void bench_memory() {
+    PServiceRegistry psr = NULL;
+    char name[SZ_CHAR_LABEL], ip[SZ_CHAR_LABEL], port[8];
+    size_t legacy = 0, compact = 0, indexes = 0;
+    int index = 0, entries = 1000, mallocs = 0;
+
+    psr = service_registry_create();
+    for (index = 0; index < entries; index++) {
+        snprintf(name, sizeof(name), "service_%02d", index % 10);
+        snprintf(ip, sizeof(ip), "10.100.1.%d", index / 10);
+        snprintf(port, sizeof(port), "%d", 48000 + (index % 10));
+        service_registry_entry_create(psr, name, ip, port, NULL);
+    }
+
+    /* both layouts need the entry pointer array, the old one allocated it inline */
+    legacy = (entries * sizeof(LegacyEntry)) + (psr->computedMax * sizeof(PRegistryEntry));
+    indexes = (2 * (psr->index_mask + 1) * sizeof(int)) + ((psr->intern_mask + 1) * sizeof(char *));
+    compact = psr->arena.reserved + (psr->computedMax * sizeof(PRegistryEntry)) + indexes;
+    mallocs = psr->arena.blocks + 5;  // arena blocks, registry, entry, two indexes, intern
+
+    skn_logger(" ", "\nMemory per 1k entries (%d distinct strings)", psr->intern_count);
+    skn_logger(" ", "  legacy:  %7lu bytes, %lu bytes/entry, %d mallocs",
+               (unsigned long) legacy, (unsigned long) (legacy / entries), entries + 1);
+    skn_logger(" ", "  arena:   %7lu bytes, %lu bytes/entry, %d mallocs (arena %lu used of %lu, indexes %lu)",
+               (unsigned long) compact, (unsigned long) (compact / entries), mallocs,
+               (unsigned long) psr->arena.used, (unsigned long) psr->arena.reserved, (unsigned long) indexes);
+    skn_logger(" ", "  saved:   %7lu bytes", (unsigned long) (legacy - compact));
+
+    service_registry_destroy(psr);
+}
+
+int main(int argc, char *argv[]) {
+    int sizes[] = { 128, 1000, 10000 };
+    int rounds = 10, index = 0;
+
+    skn_program_name_and_description_set(
+            "skn_registry_benchmark",
+            "ServiceRegistry build/merge/lookup benchmark."
+            );
+
+    if (argc > 1) {
+        rounds = atoi(argv[1]);
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    gd_i_unique_registry = 1;  // merge replaces duplicates, like --unique-registry
+
+    skn_logger(" ", "ServiceRegistry benchmark, %d rounds, ns per operation", rounds);
+    skn_logger(" ", "%7s  %10s %10s %10s   %10s %10s %10s",
+               "entries", "build", "merge", "find", "lin-build", "lin-merge", "lin-find");
+    for (index = 0; index < (int) (sizeof(sizes) / sizeof(int)); index++) {
+        bench_size(sizes[index], rounds);
+    }
+    bench_memory();
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,565 @@
+/*
+ * skn_registry_gossip.c
+ *
+ *  Registry replication between locators.
+ *  - each round asks every peer for its own entries, naming the digest of
+ *    the copy already held, so an unchanged peer costs two short datagrams
+ *  - a peer's entries are held as leases with its bit set in holders; the
+ *    entry leaves the registry when no holder is left
+ *  - peers are learned from the --replicate seeds, from the locators that
+ *    ask us, and from the known= list of every PEERS reply
+ */
+
+#include "skn_network_helpers.h"
+
+/*
+ * page scan context: the peer's holder bit and what the page changed */
+typedef struct _gossipScan {
+    PServiceProvider psp;
+    uint64_t bit;
+    int changed;
+    int rejected;
+} GossipScan, *PGossipScan;
+
+static int service_registry_gossip_is_local(struct in_addr addr);
+static PGossipPeer service_registry_gossip_peer(PServiceProvider psp, struct in_addr addr, uint16_t port, int add, int seed);
+static int service_registry_gossip_send(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, const char *data, int len);
+static int service_registry_gossip_release(PServiceProvider psp, int index, uint64_t keep);
+static int service_registry_gossip_record(PRegistryRecord prec, void *context);
+static void service_registry_gossip_on_peers(PServiceProvider psp, PGossipPeer ppeer, const char *reply);
+static int service_registry_gossip_on_page(PServiceProvider psp, PGossipPeer ppeer, const char *reply);
+static int service_registry_gossip_on_round(void *pem, void *pes);
+static int service_registry_gossip_on_reply(void *pem, void *pes);
+
+/*
+ * TRUE when addr:port is this locator */
+int service_registry_gossip_is_self(struct in_addr addr, uint16_t port) {
+    PInterfaceSnapshot pis = NULL;
+    int index = 0;
+
+    if (port != gd_i_locator_port) {
+        return FALSE;
+    }
+    if ((addr.s_addr == htonl(INADDR_ANY)) || ((ntohl(addr.s_addr) >> 24) == IN_LOOPBACKNET)) {
+        return TRUE;
+    }
+    pis = skn_interface_cache_snapshot();
+    for (index = 0; (pis != NULL) && (index < pis->count); index++) {
+        if (pis->entry[index].addr.s_addr == addr.s_addr) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * TRUE when addr is this host, loopback included as is_self() takes it,
+ * or on the subnet of one of its interfaces */
+static int service_registry_gossip_is_local(struct in_addr addr) {
+    PInterfaceSnapshot pis = NULL;
+    int index = 0;
+
+    if ((ntohl(addr.s_addr) >> 24) == IN_LOOPBACKNET) {
+        return TRUE;
+    }
+    pis = skn_interface_cache_snapshot();
+    for (index = 0; (pis != NULL) && (index < pis->count); index++) {
+        if ((pis->entry[index].addr.s_addr & pis->entry[index].mask.s_addr) ==
+            (addr.s_addr & pis->entry[index].mask.s_addr)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * service_registry_gossip_peer()
+ * - finds the peer at addr:port, adding it when add is set and a slot is free
+ * - this locator is never its own peer
+ *
+ * - returns PGossipPeer | NULL
+ */
+static PGossipPeer service_registry_gossip_peer(PServiceProvider psp, struct in_addr addr, uint16_t port, int add, int seed) {
+    PGossipPeer ppeer = NULL, pfree = NULL;
+    int index = 0;
+
+    for (index = 0; index < ARY_MAX_PEERS; index++) {
+        ppeer = &psp->gossip.peer[index];
+        if (ppeer->in_use == 0) {
+            if (pfree == NULL) {
+                pfree = ppeer;
+            }
+        } else if ((ppeer->addr.sin_addr.s_addr == addr.s_addr) && (ppeer->addr.sin_port == htons(port))) {
+            return ppeer;
+        }
+    }
+    if ((add == FALSE) || service_registry_gossip_is_self(addr, port)) {
+        return NULL;
+    }
+    if (pfree == NULL) {
+        skn_logger(SD_WARNING, "Gossip: peer %s:%d ignored, all %d peers in use", inet_ntoa(addr), port, ARY_MAX_PEERS);
+        return NULL;
+    }
+
+    memset(pfree, 0, sizeof(GossipPeer));
+    pfree->in_use = 1;
+    pfree->seed = seed;
+    pfree->addr.sin_family = AF_INET;
+    pfree->addr.sin_addr = addr;
+    pfree->addr.sin_port = htons(port);
+    skn_logger(SD_NOTICE, "Gossip: peer %s:%d added%s", inet_ntoa(addr), port, (seed ? " as a seed" : ""));
+
+    return pfree;
+}
+
+/*
+ * sends one gossip datagram and counts it */
+static int service_registry_gossip_send(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, const char *data, int len) {
+    if (sendto(i_socket, data, len, 0, (struct sockaddr *) premaddr, sizeof(struct sockaddr_in)) < 0) {
+        skn_logger(SD_DEBUG, "Gossip: SendTo() %s:%d Failure code=%d, etext=%s",
+                   inet_ntoa(premaddr->sin_addr), ntohs(premaddr->sin_port), errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    psp->gossip.sent++;
+    psp->gossip.sent_bytes += len;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_gossip_release()
+ * - takes peer index off every entry it holds, except those staged in keep;
+ *   an entry nobody holds any more is removed
+ * - caller holds the write lock
+ *
+ * - returns count of entries removed
+ */
+static int service_registry_gossip_release(PServiceProvider psp, int index, uint64_t keep) {
+    PRegistryLease pl = NULL;
+    uint64_t bit = 1ULL << (index + 1);
+    int lease = 0, removed = 0;
+
+    for (lease = 0; lease < ARY_MAX_LEASES; lease++) {
+        pl = &psp->lease[lease];
+        if ((pl->in_use == 0) || ((pl->holders & bit) == 0) || ((pl->staged & keep) != 0)) {
+            continue;
+        }
+        pl->holders &= ~bit;
+        if ((pl->holders == 0) && (pl->pinned == 0)) {
+            pl->in_use = 0;
+            service_registry_provider_retire(psp, pl);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+/**
+ * service_registry_gossip_seed()
+ * - adds each ip:port of a comma separated list as a peer kept for good
+ *
+ * - returns count of peers | PLATFORM_ERROR when an item is malformed
+ */
+int service_registry_gossip_seed(PServiceProvider psp, const char *list) {
+    char item[SZ_CHAR_LABEL];
+    const char *pch = list, *next = NULL, *colon = NULL;
+    struct in_addr addr;
+    char *stop = NULL;
+    unsigned long port = 0;
+    int len = 0, count = 0;
+
+    while ((pch != NULL) && (*pch != 0)) {
+        next = strchr(pch, ',');
+        len = (int) (next != NULL ? next - pch : (int) strlen(pch));
+        if ((len < 1) || (len >= SZ_CHAR_LABEL)) {
+            return PLATFORM_ERROR;
+        }
+        memcpy(item, pch, len);
+        item[len] = 0;
+
+        colon = strchr(item, ':');
+        port = (colon != NULL ? strtoul(colon + 1, &stop, 10) : (unsigned long) gd_i_locator_port);
+        if (colon != NULL) {
+            if ((*stop != 0) || (port == 0) || (port > 0xFFFF)) {
+                return PLATFORM_ERROR;
+            }
+            item[colon - item] = 0;
+        }
+        if (inet_pton(AF_INET, item, &addr) != 1) {
+            return PLATFORM_ERROR;
+        }
+        if (service_registry_gossip_peer(psp, addr, (uint16_t) port, TRUE, TRUE) != NULL) {
+            count++;
+        }
+        pch = (next != NULL ? next + 1 : NULL);
+    }
+
+    return count;
+}
+
+/**
+ * service_registry_gossip_paginate()
+ * - lists the entries held by a holder in mask in pages for premaddr, or
+ *   with pages of zero only counts the pages; none held is still one page
+ * - caller holds the write lock
+ *
+ * - returns count of pages
+ */
+int service_registry_gossip_paginate(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, int pages, uint64_t mask) {
+    PRegistryLease pl = NULL;
+    char body[SKN_REGISTRY_PAGE - SKN_PAGE_HEADER];
+    char page[SKN_REGISTRY_PAGE];
+    char line[SZ_INFO_BUFF];
+    int index = 0, count = 0, blen = 0, llen = 0, len = 0;
+
+    for (index = 0; index <= ARY_MAX_LEASES; index++) {
+        pl = (index < ARY_MAX_LEASES ? &psp->lease[index] : NULL);
+        if ((pl != NULL) && ((pl->in_use == 0) || ((pl->holders & mask) == 0))) {
+            continue;
+        }
+        llen = (pl != NULL ? snprintf(line, sizeof(line), "name=%s,ip=%s,port=%d%c", pl->name, pl->ip, pl->port, psp->separator) : 0);
+
+        /* the page is full, or this is the last */
+        if ((pl == NULL) || ((blen > 0) && ((blen + llen) > (int) (sizeof(body) - 1)))) {
+            count++;
+            if (pages > 0) {
+                len = snprintf(page, SKN_PAGE_HEADER, "digest=%lu.%lu,page=%d/%d%c",
+                               psp->epoch, psp->claims, count, pages, psp->separator);
+                memcpy(&page[len], body, blen);
+                service_registry_gossip_send(psp, i_socket, premaddr, page, len + blen);
+            }
+            blen = 0;
+        }
+        if (pl != NULL) {
+            memcpy(&body[blen], line, llen);
+            blen += llen;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * service_registry_gossip_answer()
+ * - answers a SYNC: the peers known here, then this locator's own entries,
+ *   and those it relays, unless the requester's digest shows it holds them
+ * - the requester is added as a peer when it is on a local subnet; one
+ *   further away must be named by --replicate
+ * - caller holds the write lock
+ *
+ * - returns count of datagrams sent, 0 when request is malformed
+ */
+int service_registry_gossip_answer(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr, const char *request, int len) {
+    PGossipPeer ppeer = NULL, requester = NULL;
+    char reply[SKN_REGISTRY_PAGE];
+    unsigned long epoch = 0, claims = 0;
+    unsigned int port = 0;
+    int index = 0, rlen = 0, added = 0, listed = 0, sent = 1;
+
+    psp->gossip.received++;
+    psp->gossip.received_bytes += len;
+    if ((sscanf(request, SKN_SYNC_REQUEST " digest=%lu.%lu port=%u", &epoch, &claims, &port) != 3) ||
+        (port == 0) || (port > 0xFFFF)) {
+        skn_logger(SD_DEBUG, "Gossip: malformed request from %s:%d", inet_ntoa(premaddr->sin_addr), ntohs(premaddr->sin_port));
+        return 0;
+    }
+    requester = service_registry_gossip_peer(psp, premaddr->sin_addr, (uint16_t) port,
+                                             service_registry_gossip_is_local(premaddr->sin_addr), FALSE);
+
+    rlen = snprintf(reply, sizeof(reply), "%s digest=%lu.%lu known=", SKN_PEERS_REPLY, psp->epoch, psp->claims);
+    for (index = 0; index < ARY_MAX_PEERS; index++) {
+        ppeer = &psp->gossip.peer[index];
+        if ((ppeer->in_use == 0) || (ppeer == requester) || (ppeer->misses > SKN_GOSSIP_MISSES)) {
+            continue;
+        }
+        added = snprintf(&reply[rlen], sizeof(reply) - rlen, "%s%s:%d", (listed == 0 ? "" : ","),
+                         inet_ntoa(ppeer->addr.sin_addr), ntohs(ppeer->addr.sin_port));
+        if (added >= (int) (sizeof(reply) - rlen)) {
+            reply[rlen] = 0;
+            break;
+        }
+        rlen += added;
+        listed++;
+    }
+    service_registry_gossip_send(psp, i_socket, premaddr, reply, rlen);
+
+    if ((epoch != psp->epoch) || (claims != psp->claims)) {
+        sent += service_registry_gossip_paginate(psp, i_socket, premaddr,
+                                                 service_registry_gossip_paginate(psp, i_socket, premaddr, 0, 1 | SKN_RELAY_HOLDER),
+                                                 1 | SKN_RELAY_HOLDER);
+    }
+
+    return sent;
+}
+
+/*
+ * page scan callback: the peer holds this entry */
+static int service_registry_gossip_record(PRegistryRecord prec, void *context) {
+    PGossipScan pgs = (PGossipScan) context;
+    PServiceProvider psp = pgs->psp;
+    PRegistryLease pl = NULL, pfree = NULL;
+    uint16_t port = service_registry_span_port(&prec->port);
+    int index = 0;
+
+    if ((prec->name.len >= SZ_CHAR_LABEL) || (prec->ip.len >= SZ_CHAR_LABEL)) {
+        return EXIT_FAILURE;
+    }
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use == 0) {
+            if (pfree == NULL) {
+                pfree = pl;
+            }
+        } else if ((pl->port == port) &&
+                   (strncmp(pl->name, prec->name.start, prec->name.len) == 0) && (pl->name[prec->name.len] == 0) &&
+                   (strncmp(pl->ip, prec->ip.start, prec->ip.len) == 0) && (pl->ip[prec->ip.len] == 0)) {
+            pl->holders |= pgs->bit;
+            pl->staged |= pgs->bit;
+            return EXIT_SUCCESS;
+        }
+    }
+    if (pfree == NULL) {
+        pgs->rejected++;
+        return EXIT_FAILURE;
+    }
+
+    pl = pfree;
+    memset(pl, 0, sizeof(RegistryLease));
+    memcpy(pl->name, prec->name.start, prec->name.len);
+    memcpy(pl->ip, prec->ip.start, prec->ip.len);
+    pl->port = port;
+    pl->in_use = 1;
+    pl->holders = pgs->bit;
+    pl->staged = pgs->bit;
+    service_registry_provider_admit(psp, pl);
+    pgs->changed++;
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * PEERS reply: the peer is alive, and may know peers we do not */
+static void service_registry_gossip_on_peers(PServiceProvider psp, PGossipPeer ppeer, const char *reply) {
+    const char *known = strstr(reply, " known=");
+    char ip[INET_ADDRSTRLEN];
+    const char *item = NULL, *colon = NULL, *end = NULL;
+    struct in_addr addr;
+    unsigned long port = 0;
+    int len = 0;
+
+    ppeer->misses = 0;
+    for (item = (known != NULL ? known + 7 : NULL); (item != NULL) && (*item != 0) && !isspace((unsigned char) *item); item = end) {
+        end = item + strcspn(item, ", \t\r\n");
+        colon = memchr(item, ':', end - item);
+        len = (int) (colon != NULL ? colon - item : 0);
+        if ((len > 0) && (len < INET_ADDRSTRLEN)) {
+            memcpy(ip, item, len);
+            ip[len] = 0;
+            port = strtoul(colon + 1, NULL, 10);
+            if ((port > 0) && (port <= 0xFFFF) && (inet_pton(AF_INET, ip, &addr) == 1)) {
+                service_registry_gossip_peer(psp, addr, (uint16_t) port, TRUE, FALSE);
+            }
+        }
+        if (*end == ',') {
+            end++;
+        }
+    }
+}
+
+/**
+ * service_registry_gossip_on_page()
+ * - takes in one page of a peer's entries; once every page of that digest
+ *   has come in, entries the peer no longer lists are let go
+ * - a lost page leaves the old digest in place, so the next round asks again
+ * - caller holds the write lock
+ *
+ * - returns count of registry entries added and removed
+ */
+static int service_registry_gossip_on_page(PServiceProvider psp, PGossipPeer ppeer, const char *reply) {
+    GossipScan scan;
+    unsigned long epoch = 0, claims = 0;
+    int page = 0, pages = 0, lease = 0, index = (int) (ppeer - psp->gossip.peer);
+    const char *body = NULL;
+
+    if ((sscanf(reply, "digest=%lu.%lu,page=%d/%d", &epoch, &claims, &page, &pages) != 4) ||
+        (page < 1) || (page > pages) || (pages > ARY_MAX_PAGES) || ((body = strpbrk(reply, "|%;")) == NULL)) {
+        return 0;
+    }
+
+    memset(&scan, 0, sizeof(scan));
+    scan.psp = psp;
+    scan.bit = 1ULL << (index + 1);
+    if ((epoch != ppeer->staging_epoch) || (claims != ppeer->staging_claims)) {
+        ppeer->staging_epoch = epoch;
+        ppeer->staging_claims = claims;
+        ppeer->pages_seen = 0;
+        for (lease = 0; lease < ARY_MAX_LEASES; lease++) {
+            psp->lease[lease].staged &= ~scan.bit;
+        }
+    }
+    if (ppeer->pages_seen & (1ULL << (page - 1))) {
+        return 0;
+    }
+    ppeer->pages_seen |= (1ULL << (page - 1));
+
+    service_registry_response_scan(body + 1, service_registry_gossip_record, &scan, NULL);
+    if (scan.rejected > 0) {
+        skn_logger(SD_WARNING, "Gossip: %d entries of %s:%d rejected, all %d leases in use",
+                   scan.rejected, inet_ntoa(ppeer->addr.sin_addr), ntohs(ppeer->addr.sin_port), ARY_MAX_LEASES);
+    }
+
+    if (__builtin_popcountll(ppeer->pages_seen) == pages) {
+        scan.changed += service_registry_gossip_release(psp, index, scan.bit);
+        for (lease = 0; lease < ARY_MAX_LEASES; lease++) {
+            psp->lease[lease].staged &= ~scan.bit;
+        }
+        ppeer->epoch = epoch;
+        ppeer->claims = claims;
+        ppeer->staging_epoch = ppeer->staging_claims = 0;
+        ppeer->pages_seen = 0;
+        psp->gossip.applied++;
+        skn_logger(SD_INFO, "Gossip: %s:%d now at digest %lu.%lu, registry version %lu",
+                   inet_ntoa(ppeer->addr.sin_addr), ntohs(ppeer->addr.sin_port), epoch, claims, psp->version + scan.changed);
+    }
+
+    return scan.changed;
+}
+
+/**
+ * service_registry_gossip_on_round()
+ * - sends each peer a SYNC naming the digest held for it; a peer silent
+ *   too long has its entries dropped, and a learned one is forgotten
+ */
+static int service_registry_gossip_on_round(void *pem, void *pes) {
+    PServiceProvider psp = (PServiceProvider) ((PEventSource) pes)->context;
+    PGossipPeer ppeer = NULL;
+    char request[SZ_INFO_BUFF];
+    int index = 0, len = 0, changed = 0;
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    psp->gossip.rounds++;
+    for (index = 0; index < ARY_MAX_PEERS; index++) {
+        ppeer = &psp->gossip.peer[index];
+        if (ppeer->in_use == 0) {
+            continue;
+        }
+        if ((ppeer->misses >= SKN_GOSSIP_MISSES) && ((ppeer->epoch != 0) || (ppeer->claims != 0))) {
+            changed += service_registry_gossip_release(psp, index, 0);
+            ppeer->epoch = ppeer->claims = 0;
+            skn_logger(SD_NOTICE, "Gossip: peer %s:%d silent for %d rounds, its entries dropped",
+                       inet_ntoa(ppeer->addr.sin_addr), ntohs(ppeer->addr.sin_port), ppeer->misses);
+        }
+        if ((ppeer->seed == 0) && (ppeer->misses >= SKN_GOSSIP_FORGET)) {
+            skn_logger(SD_NOTICE, "Gossip: peer %s:%d forgotten", inet_ntoa(ppeer->addr.sin_addr), ntohs(ppeer->addr.sin_port));
+            ppeer->in_use = 0;
+            continue;
+        }
+
+        ppeer->misses++;
+        len = snprintf(request, sizeof(request), "%s digest=%lu.%lu port=%d", SKN_SYNC_REQUEST, ppeer->epoch, ppeer->claims, gd_i_locator_port);
+        service_registry_gossip_send(psp, psp->gossip.i_socket, &ppeer->addr, request, len);
+    }
+    if (changed > 0) {
+        service_registry_provider_rebuild(psp);
+    }
+    pthread_rwlock_unlock(&psp->rwlock);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_gossip_on_reply()
+ * - reads the PEERS replies and entry pages waiting on the gossip socket
+ */
+static int service_registry_gossip_on_reply(void *pem, void *pes) {
+    PServiceProvider psp = (PServiceProvider) ((PEventSource) pes)->context;
+    PGossipPeer ppeer = NULL;
+    struct sockaddr_in remaddr;
+    socklen_t addrlen = sizeof(remaddr);
+    char reply[SKN_REGISTRY_PAGE + 1];
+    int len = 0, changed = 0;
+
+    while ((len = (int) recvfrom(psp->gossip.i_socket, reply, SKN_REGISTRY_PAGE, MSG_DONTWAIT, (struct sockaddr *) &remaddr, &addrlen)) >= 0) {
+        reply[len] = 0;
+        addrlen = sizeof(remaddr);
+
+        pthread_rwlock_wrlock(&psp->rwlock);
+        psp->gossip.received++;
+        psp->gossip.received_bytes += len;
+        ppeer = service_registry_gossip_peer(psp, remaddr.sin_addr, ntohs(remaddr.sin_port), FALSE, FALSE);
+        if (ppeer == NULL) {
+            skn_logger(SD_DEBUG, "Gossip: reply from unknown peer %s:%d ignored", inet_ntoa(remaddr.sin_addr), ntohs(remaddr.sin_port));
+        } else if (strncmp(reply, SKN_PEERS_REPLY " ", sizeof(SKN_PEERS_REPLY)) == 0) {
+            service_registry_gossip_on_peers(psp, ppeer, reply);
+        } else if ((changed = service_registry_gossip_on_page(psp, ppeer, reply)) > 0) {
+            if (service_registry_provider_rebuild(psp) > 0) {
+                skn_logger(SD_NOTICE, "Gossip: replicated entries listed in paged replies only, text response is full");
+            }
+        }
+        pthread_rwlock_unlock(&psp->rwlock);
+    }
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+        skn_logger(SD_ERR, "Gossip: RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_gossip_start()
+ * - gives pem, worker 0's, the gossip socket and the round timer
+ * - a relay's rounds run at its --relay interval
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int service_registry_gossip_start(PServiceProvider psp, PEventManager pem) {
+    int i_socket = skn_udp_host_create_regular_socket(0, 0.0), round_fd = PLATFORM_ERROR;
+
+    if (i_socket == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if ((skn_event_manager_add_socket(pem, i_socket, service_registry_gossip_on_reply, psp) == EXIT_FAILURE) ||
+        ((round_fd = skn_event_manager_add_timer(pem, (gd_i_relay > 0 ? (double) gd_i_relay : SKN_GOSSIP_INTERVAL),
+                                                  service_registry_gossip_on_round, psp)) == PLATFORM_ERROR)) {
+        close(i_socket);
+        return EXIT_FAILURE;
+    }
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    psp->gossip.i_socket = i_socket;
+    psp->gossip.round_fd = round_fd;
+    pthread_rwlock_unlock(&psp->rwlock);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_gossip_stop()
+ * - closes the gossip socket; the round timer goes with the event manager
+ */
+void service_registry_gossip_stop(PServiceProvider psp) {
+    pthread_rwlock_wrlock(&psp->rwlock);
+    if (psp->gossip.i_socket != PLATFORM_ERROR) {
+        close(psp->gossip.i_socket);
+    }
+    psp->gossip.i_socket = PLATFORM_ERROR;
+    psp->gossip.round_fd = PLATFORM_ERROR;
+    pthread_rwlock_unlock(&psp->rwlock);
+}
+
+/**
+ * service_registry_gossip_log_counters()
+ */
+void service_registry_gossip_log_counters(PServiceProvider psp) {
+    int index = 0, peers = 0;
+
+    for (index = 0; index < ARY_MAX_PEERS; index++) {
+        peers += (psp->gossip.peer[index].in_use ? 1 : 0);
+    }
+    skn_logger(SD_NOTICE, "Gossip: %d peers, %lu rounds, %lu updates applied, sent %lu datagrams %lu bytes, received %lu datagrams %lu bytes",
+               peers, psp->gossip.rounds, psp->gossip.applied, psp->gossip.sent, psp->gossip.sent_bytes,
+               psp->gossip.received, psp->gossip.received_bytes);
+}
@@ -0,0 +1,163 @@
+/*
+ * skn_registry_query.c
+ *
+ *  Known-answer queries for discovery on busy subnets.
+ *  - a QUERY names the service wanted and the providers already known
+ *  - responders answer with what is left, or not at all
+ *  - requesters list what they have heard when they ask again
+ *  - a FIND asks for one service by name, or by name prefix
+ */
+
+#include "skn_network_helpers.h"
+
+static void service_registry_query_known(PRegistryQuery prq, const char *list, const char *end);
+
+/**
+ * service_registry_query_known()
+ * - adds each ip:port of a comma separated list, ending at end
+ * - malformed items, and any past ARY_MAX_KNOWN, are ignored
+ */
+static void service_registry_query_known(PRegistryQuery prq, const char *list, const char *end) {
+    const char *item = list, *next = NULL, *colon = NULL;
+    char ip[INET_ADDRSTRLEN];
+    struct in_addr addr;
+    char *stop = NULL;
+    unsigned long port = 0;
+    int len = 0;
+
+    while ((item < end) && (prq->known_count < ARY_MAX_KNOWN)) {
+        next = memchr(item, ',', end - item);
+        if (next == NULL) {
+            next = end;
+        }
+        colon = memchr(item, ':', next - item);
+        len = (int) (colon != NULL ? colon - item : 0);
+        if ((len > 0) && (len < INET_ADDRSTRLEN)) {
+            memcpy(ip, item, len);
+            ip[len] = 0;
+            port = strtoul(colon + 1, &stop, 10);
+            if ((stop == next) && (port > 0) && (port <= 0xFFFF) && (inet_pton(AF_INET, ip, &addr) == 1)) {
+                prq->known_addr[prq->known_count] = addr.s_addr;
+                prq->known_port[prq->known_count++] = (uint16_t) port;
+            }
+        }
+        item = next + 1;
+    }
+}
+
+/**
+ * service_registry_query_parse()
+ * - reads "QUERY want=<name> known=<ip>:<port>,..." into prq; both
+ *   fields are optional, unknown fields are ignored
+ * - reads "FIND name=<name> known=..." the same way; a name ending
+ *   in '*' sets prq->prefix
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when request is not a QUERY or FIND
+ */
+int service_registry_query_parse(const char *request, PRegistryQuery prq) {
+    const char *pch = NULL, *end = NULL;
+    int len = 0, find = FALSE;
+
+    memset(prq, 0, sizeof(RegistryQuery));
+    if (strncmp(request, SKN_QUERY_REQUEST, sizeof(SKN_QUERY_REQUEST) - 1) == 0) {
+        pch = &request[sizeof(SKN_QUERY_REQUEST) - 1];
+    } else if (strncmp(request, SKN_FIND_REQUEST, sizeof(SKN_FIND_REQUEST) - 1) == 0) {
+        pch = &request[sizeof(SKN_FIND_REQUEST) - 1];
+        find = TRUE;
+    }
+    if ((pch == NULL) || ((*pch != 0) && !isspace((unsigned char) *pch))) {
+        return EXIT_FAILURE;
+    }
+
+    while (*pch != 0) {
+        while (isspace((unsigned char) *pch)) {
+            pch++;
+        }
+        for (end = pch; (*end != 0) && !isspace((unsigned char) *end); end++)
+            ;
+        if (strncmp(pch, (find ? "name=" : "want="), 5) == 0) {
+            len = (int) (end - pch) - 5;
+            if (find && (len > 0) && (pch[4 + len] == '*')) {
+                prq->prefix = TRUE;
+                len--;
+            }
+            if (len > (SZ_CHAR_LABEL - 1)) {
+                len = SZ_CHAR_LABEL - 1;
+            }
+            memcpy(prq->want, &pch[5], len);
+            prq->want[len] = 0;
+        } else if (strncmp(pch, "known=", 6) == 0) {
+            service_registry_query_known(prq, &pch[6], end);
+        }
+        pch = end;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_query_wants()
+ * - returns TRUE when the entry belongs in the answer to prq
+ */
+int service_registry_query_wants(PRegistryQuery prq, const char *name, in_addr_t addr, uint16_t port) {
+    int index = 0;
+
+    if (prq->prefix) {
+        if (strncmp(prq->want, name, strlen(prq->want)) != 0) {
+            return FALSE;
+        }
+    } else if ((prq->want[0] != 0) && (strcmp(prq->want, name) != 0)) {
+        return FALSE;
+    }
+    for (index = 0; index < prq->known_count; index++) {
+        if ((prq->known_addr[index] == addr) && (prq->known_port[index] == port)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * service_registry_query_request()
+ * - writes a QUERY for want, NULL for every entry, listing the matching
+ *   entries of known
+ * - when they do not all fit, ARY_MAX_KNOWN or size, every unlisted one
+ *   would answer again, so no QUERY is written
+ *
+ * - returns length written, 0 when known does not fit
+ */
+int service_registry_query_request(char *request, int size, const char *want, PServiceRegistry known) {
+    PRegistryEntry pre = NULL;
+    int len = 0, added = 0, index = 0, listed = 0;
+
+    len = snprintf(request, size, "%s", SKN_QUERY_REQUEST);
+    if (want != NULL) {
+        added = snprintf(&request[len], size - len, " want=%s", want);
+        if (added >= (size - len)) {
+            request[len] = 0;
+            return len;
+        }
+        len += added;
+    }
+
+    for (index = 0; (known != NULL) && (index < known->count); index++) {
+        pre = known->entry[index];
+        if ((want != NULL) && (strcmp(pre->name, want) != 0)) {
+            continue;
+        }
+        if (listed == ARY_MAX_KNOWN) {
+            request[0] = 0;
+            return 0;
+        }
+        added = snprintf(&request[len], size - len, "%s%s:%d", (listed == 0 ? " known=" : ","), pre->ip, pre->port);
+        if (added >= (size - len)) {
+            request[0] = 0;
+            return 0;
+        }
+        len += added;
+        listed++;
+    }
+
+    return len;
+}
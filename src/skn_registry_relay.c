@@ -0,0 +1,272 @@
+/*
+ * skn_registry_relay.c
+ *
+ *  Relay mode, discovery across subnets.
+ *  - every --relay seconds the relay broadcasts RELAY on its own segments and
+ *    merges the answers into its registry under SKN_RELAY_HOLDER
+ *  - clients elsewhere ask the relay by unicast, see --relay-host, and other
+ *    relays take its entries by gossip, see --replicate
+ *  - polls are the only traffic a relay adds to its segment, one broadcast
+ *    per interface per interval however many clients ask
+ */
+
+#include "skn_network_helpers.h"
+
+/*
+ * answer scan context: what one datagram changed */
+typedef struct _relayScan {
+    PServiceProvider psp;
+    int changed;
+    int rejected;
+} RelayScan, *PRelayScan;
+
+static int service_registry_relay_record(PRegistryRecord prec, void *context);
+static int service_registry_relay_sweep(PServiceProvider psp);
+static int service_registry_relay_on_poll(void *pem, void *pes);
+static int service_registry_relay_on_reply(void *pem, void *pes);
+
+/*
+ * answer scan callback: a locator on this segment lists this entry */
+static int service_registry_relay_record(PRegistryRecord prec, void *context) {
+    PRelayScan prs = (PRelayScan) context;
+    PServiceProvider psp = prs->psp;
+    PRegistryLease pl = NULL, pfree = NULL;
+    uint16_t port = service_registry_span_port(&prec->port);
+    int index = 0;
+
+    if ((prec->name.len >= SZ_CHAR_LABEL) || (prec->ip.len >= SZ_CHAR_LABEL)) {
+        return EXIT_FAILURE;
+    }
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if (pl->in_use == 0) {
+            if (pfree == NULL) {
+                pfree = pl;
+            }
+        } else if ((pl->port == port) &&
+                   (strncmp(pl->name, prec->name.start, prec->name.len) == 0) && (pl->name[prec->name.len] == 0) &&
+                   (strncmp(pl->ip, prec->ip.start, prec->ip.len) == 0) && (pl->ip[prec->ip.len] == 0)) {
+            if ((pl->holders & SKN_RELAY_HOLDER) == 0) {
+                psp->claims++;  // now served to gossip peers
+            }
+            pl->holders |= SKN_RELAY_HOLDER;
+            pl->staged |= SKN_RELAY_HOLDER;
+            pl->relay_misses = 0;
+            return EXIT_SUCCESS;
+        }
+    }
+    if (pfree == NULL) {
+        prs->rejected++;
+        return EXIT_FAILURE;
+    }
+
+    pl = pfree;
+    memset(pl, 0, sizeof(RegistryLease));
+    memcpy(pl->name, prec->name.start, prec->name.len);
+    memcpy(pl->ip, prec->ip.start, prec->ip.len);
+    pl->port = port;
+    pl->in_use = 1;
+    pl->holders = SKN_RELAY_HOLDER;
+    pl->staged = SKN_RELAY_HOLDER;
+    service_registry_provider_admit(psp, pl);
+    psp->claims++;
+    psp->relay.added++;
+    prs->changed++;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_relay_sweep()
+ * - ends a poll: entries heard since the last one are kept, the rest count
+ *   a miss, and those missed SKN_RELAY_MISSES times in a row are let go
+ * - caller holds the write lock
+ *
+ * - returns count of registry entries removed
+ */
+static int service_registry_relay_sweep(PServiceProvider psp) {
+    PRegistryLease pl = NULL;
+    int index = 0, removed = 0;
+
+    for (index = 0; index < ARY_MAX_LEASES; index++) {
+        pl = &psp->lease[index];
+        if ((pl->in_use == 0) || ((pl->holders & SKN_RELAY_HOLDER) == 0)) {
+            continue;
+        }
+        if (pl->staged & SKN_RELAY_HOLDER) {
+            pl->staged &= ~SKN_RELAY_HOLDER;
+            continue;
+        }
+        if (++pl->relay_misses < SKN_RELAY_MISSES) {
+            continue;
+        }
+        pl->holders &= ~SKN_RELAY_HOLDER;
+        pl->relay_misses = 0;
+        psp->claims++;
+        psp->relay.dropped++;
+        if ((pl->holders == 0) && (pl->pinned == 0)) {
+            pl->in_use = 0;
+            service_registry_provider_retire(psp, pl);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+/**
+ * service_registry_relay_on_poll()
+ * - sweeps what the last poll missed, then broadcasts RELAY on every
+ *   interface's segment, to the locator port
+ */
+static int service_registry_relay_on_poll(void *pem, void *pes) {
+    PServiceProvider psp = (PServiceProvider) ((PEventSource) pes)->context;
+    PInterfaceSnapshot pis = skn_interface_cache_snapshot();
+    struct sockaddr_in remaddr;
+    int index = 0;
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    if (service_registry_relay_sweep(psp) > 0) {
+        service_registry_provider_rebuild(psp);
+    }
+    psp->relay.polls++;
+    pthread_rwlock_unlock(&psp->rwlock);
+
+    for (index = 0; (pis != NULL) && (index < pis->count); index++) {
+        memset(&remaddr, 0, sizeof(remaddr));
+        remaddr.sin_family = AF_INET;
+        remaddr.sin_addr = pis->entry[index].broadcast;
+        remaddr.sin_port = htons(SKN_FIND_RPI_PORT);
+        if (sendto(psp->relay.i_socket, SKN_RELAY_REQUEST, sizeof(SKN_RELAY_REQUEST) - 1, 0,
+                   (struct sockaddr *) &remaddr, sizeof(remaddr)) < 0) {
+            skn_logger(SD_WARNING, "Relay: poll on %s Failure code=%d, etext=%s", pis->entry[index].name, errno, strerror(errno));
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_relay_on_reply()
+ * - reads the answers waiting on the relay socket: gossip pages from
+ *   current locators, the text response from older ones
+ * - each answer is read and framed without the lock, which is only held
+ *   while its entries are merged, so workers keep answering meanwhile
+ */
+static int service_registry_relay_on_reply(void *pem, void *pes) {
+    PServiceProvider psp = (PServiceProvider) ((PEventSource) pes)->context;
+    RelayScan scan;
+    struct sockaddr_in remaddr;
+    socklen_t addrlen = sizeof(remaddr);
+    char reply[SKN_REGISTRY_PAGE + 1];
+    const char *body = NULL;
+    int len = 0;
+
+    memset(&scan, 0, sizeof(scan));
+    scan.psp = psp;
+
+    while ((len = (int) recvfrom(psp->relay.i_socket, reply, SKN_REGISTRY_PAGE, MSG_DONTWAIT, (struct sockaddr *) &remaddr, &addrlen)) >= 0) {
+        reply[len] = 0;
+        addrlen = sizeof(remaddr);
+        if (service_registry_gossip_is_self(remaddr.sin_addr, ntohs(remaddr.sin_port))) {
+            continue;
+        }
+        body = reply;
+        if (strncmp(reply, "digest=", sizeof("digest=") - 1) == 0) {
+            body = strpbrk(reply, "|%;");
+        }
+
+        pthread_rwlock_wrlock(&psp->rwlock);
+        psp->relay.answers++;
+        scan.changed = 0;
+        if (body == reply) {
+            service_registry_message_scan(reply, len, service_registry_relay_record, &scan, NULL);
+        } else if (body != NULL) {
+            service_registry_response_scan(body + 1, service_registry_relay_record, &scan, NULL);
+        }
+        if ((scan.changed > 0) && (service_registry_provider_rebuild(psp) > 0)) {
+            skn_logger(SD_NOTICE, "Relay: relayed entries listed in paged replies only, text response is full");
+        }
+        pthread_rwlock_unlock(&psp->rwlock);
+    }
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+        skn_logger(SD_ERR, "Relay: RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
+    }
+    if (scan.rejected > 0) {
+        skn_logger(SD_WARNING, "Relay: %d entries rejected, all %d leases in use", scan.rejected, ARY_MAX_LEASES);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_relay_answer()
+ * - answers a RELAY with the entries this locator holds itself, in pages
+ * - caller holds the write lock
+ *
+ * - returns count of pages sent
+ */
+int service_registry_relay_answer(PServiceProvider psp, int i_socket, struct sockaddr_in *premaddr) {
+    return service_registry_gossip_paginate(psp, i_socket, premaddr,
+                                            service_registry_gossip_paginate(psp, i_socket, premaddr, 0, 1), 1);
+}
+
+/**
+ * service_registry_relay_start()
+ * - gives pem, worker 0's, the relay socket and the poll timer, the first
+ *   poll going out at once; nothing when --relay is off
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE
+ */
+int service_registry_relay_start(PServiceProvider psp, PEventManager pem) {
+    int i_socket = PLATFORM_ERROR, poll_fd = PLATFORM_ERROR;
+
+    if (gd_i_relay == 0) {
+        return EXIT_SUCCESS;
+    }
+    if ((i_socket = skn_udp_host_create_broadcast_socket(0, 0.0)) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if ((skn_event_manager_add_socket(pem, i_socket, service_registry_relay_on_reply, psp) == EXIT_FAILURE) ||
+        ((poll_fd = skn_event_manager_add_timer(pem, (double) gd_i_relay, service_registry_relay_on_poll, psp)) == PLATFORM_ERROR) ||
+        (skn_event_timer_arm(poll_fd, 0.001, (double) gd_i_relay) == PLATFORM_ERROR)) {
+        close(i_socket);
+        return EXIT_FAILURE;
+    }
+
+    pthread_rwlock_wrlock(&psp->rwlock);
+    psp->relay.i_socket = i_socket;
+    psp->relay.poll_fd = poll_fd;
+    pthread_rwlock_unlock(&psp->rwlock);
+
+    skn_logger(SD_NOTICE, "Relay: polling the local segments every %ds", gd_i_relay);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_relay_stop()
+ * - closes the relay socket; the poll timer goes with the event manager
+ */
+void service_registry_relay_stop(PServiceProvider psp) {
+    pthread_rwlock_wrlock(&psp->rwlock);
+    if (psp->relay.i_socket != PLATFORM_ERROR) {
+        close(psp->relay.i_socket);
+    }
+    psp->relay.i_socket = PLATFORM_ERROR;
+    psp->relay.poll_fd = PLATFORM_ERROR;
+    pthread_rwlock_unlock(&psp->rwlock);
+}
+
+/**
+ * service_registry_relay_log_counters()
+ * - nothing when --relay is off
+ */
+void service_registry_relay_log_counters(PServiceProvider psp) {
+    if (gd_i_relay == 0) {
+        return;
+    }
+
+    skn_logger(SD_NOTICE, "Relay: %lu polls, %lu answers, %lu entries added, %lu dropped",
+               psp->relay.polls, psp->relay.answers, psp->relay.added, psp->relay.dropped);
+}
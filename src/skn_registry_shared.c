@@ -0,0 +1,268 @@
+/*
+ * skn_registry_shared.c
+ *
+ *  Registry lookups without the network, for clients on the locator's host.
+ *  - the locator publishes its merged registry to shared memory on every change
+ *  - clients copy out the entries they want under a seqlock, taking no lock
+ *  - a missing segment, or one left by a dead locator, falls back to discovery
+ */
+
+#include "skn_network_helpers.h"
+
+static PSharedRegistry service_registry_shared_map(const char *name, int writable);
+static int service_registry_shared_owner_alive(PSharedRegistry psr);
+static int service_registry_shared_copy(PSharedRegistry psr, const char *name, PSharedRegistryEntry copy);
+
+/**
+ * service_registry_shared_map()
+ * - maps the named segment, read-only unless writable
+ *
+ * - returns PSharedRegistry | NULL when missing or the wrong size
+ */
+static PSharedRegistry service_registry_shared_map(const char *name, int writable) {
+    PSharedRegistry psr = NULL;
+    struct stat st;
+    int fd = 0;
+
+    fd = shm_open(name, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC, 0);
+    if (fd == PLATFORM_ERROR) {
+        return NULL;
+    }
+    if ((fstat(fd, &st) == PLATFORM_ERROR) || (st.st_size != (off_t) sizeof(SharedRegistry))) {
+        close(fd);
+        return NULL;
+    }
+    psr = (PSharedRegistry) mmap(NULL, sizeof(SharedRegistry), (writable ? PROT_READ | PROT_WRITE : PROT_READ), MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (psr == MAP_FAILED ? NULL : psr);
+}
+
+static int service_registry_shared_owner_alive(PSharedRegistry psr) {
+    pid_t owner = (pid_t) __atomic_load_n(&psr->owner, __ATOMIC_ACQUIRE);
+
+    if ((psr->magic != SKN_SHARED_REGISTRY_MAGIC) || (psr->version != SKN_SHARED_REGISTRY_VERSION) || (owner <= 0)) {
+        return FALSE;
+    }
+
+    return ((kill(owner, 0) == 0) || (errno == EPERM));
+}
+
+/**
+ * service_registry_shared_copy()
+ * - copies the entries named name, every entry for NULL, into copy
+ * - retries while a copy overlapped a write; names are terminated here,
+ *   so a torn copy that is thrown away can never run off its buffer
+ *
+ * - returns entries copied | PLATFORM_ERROR when every try overlapped a write
+ */
+static int service_registry_shared_copy(PSharedRegistry psr, const char *name, PSharedRegistryEntry copy) {
+    uint32_t sequence = 0, count = 0;
+    int attempt = 0, index = 0, copied = 0;
+
+    for (attempt = 0; attempt < SKN_SHARED_REGISTRY_RETRIES; attempt++) {
+        sequence = __atomic_load_n(&psr->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            sched_yield();
+            continue;
+        }
+
+        count = psr->count;
+        if (count > ARY_MAX_SHARED_ENTRIES) {
+            count = ARY_MAX_SHARED_ENTRIES;
+        }
+        for (index = 0, copied = 0; index < (int) count; index++) {
+            copy[copied] = psr->entry[index];
+            copy[copied].name[SZ_CHAR_LABEL - 1] = 0;
+            if ((name == NULL) || (strcmp(copy[copied].name, name) == 0)) {
+                copied++;
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&psr->sequence, __ATOMIC_RELAXED) == sequence) {
+            return copied;
+        }
+    }
+
+    return PLATFORM_ERROR;
+}
+
+/**
+ * service_registry_shared_open()
+ * - creates the segment named by gd_pch_shared_registry for psp to publish
+ *   into; one left by a locator that has since died is replaced
+ *
+ * - returns EXIT_SUCCESS | EXIT_FAILURE when off, or another live locator owns it
+ */
+int service_registry_shared_open(PServiceProvider psp) {
+    PSharedRegistry psr = NULL;
+    int fd = PLATFORM_ERROR, attempt = 0;
+
+    if ((gd_pch_shared_registry == NULL) || (strcmp(gd_pch_shared_registry, "none") == 0)) {
+        return EXIT_FAILURE;
+    }
+
+    for (attempt = 0; (fd == PLATFORM_ERROR) && (attempt < 2); attempt++) {
+        fd = shm_open(gd_pch_shared_registry, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if ((fd == PLATFORM_ERROR) && (errno == EEXIST)) {
+            psr = service_registry_shared_map(gd_pch_shared_registry, 0);
+            if ((psr != NULL) && service_registry_shared_owner_alive(psr)) {
+                skn_logger(SD_NOTICE, "SharedRegistry: %s is published by pid %d, not publishing", gd_pch_shared_registry, (int) psr->owner);
+                munmap(psr, sizeof(SharedRegistry));
+                return EXIT_FAILURE;
+            }
+            if (psr != NULL) {
+                munmap(psr, sizeof(SharedRegistry));
+            }
+            shm_unlink(gd_pch_shared_registry);
+        } else if (fd == PLATFORM_ERROR) {
+            break;
+        }
+    }
+    if (fd == PLATFORM_ERROR) {
+        skn_logger(SD_WARNING, "SharedRegistry: shm_open(%s) Failure code=%d, etext=%s", gd_pch_shared_registry, errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    if (ftruncate(fd, sizeof(SharedRegistry)) == PLATFORM_ERROR) {
+        skn_logger(SD_WARNING, "SharedRegistry: ftruncate(%s) Failure code=%d, etext=%s", gd_pch_shared_registry, errno, strerror(errno));
+        close(fd);
+        shm_unlink(gd_pch_shared_registry);
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    psr = service_registry_shared_map(gd_pch_shared_registry, 1);
+    if (psr == NULL) {
+        skn_logger(SD_WARNING, "SharedRegistry: mmap(%s) Failure code=%d, etext=%s", gd_pch_shared_registry, errno, strerror(errno));
+        shm_unlink(gd_pch_shared_registry);
+        return EXIT_FAILURE;
+    }
+    psr->magic = SKN_SHARED_REGISTRY_MAGIC;
+    psr->version = SKN_SHARED_REGISTRY_VERSION;
+    __atomic_store_n(&psr->owner, (int64_t) getpid(), __ATOMIC_RELEASE);
+    psp->shared = psr;
+
+    skn_logger(SD_NOTICE, "SharedRegistry: publishing to %s", gd_pch_shared_registry);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * service_registry_shared_publish()
+ * - writes every live lease of psp into its segment under the seqlock
+ * - caller holds the write lock, so there is only ever one writer
+ */
+void service_registry_shared_publish(PServiceProvider psp) {
+    PSharedRegistry psr = psp->shared;
+    PSharedRegistryEntry pse = NULL;
+    PRegistryLease pl = NULL;
+    uint32_t sequence = 0, count = 0;
+    int index = 0;
+
+    if (psr == NULL) {
+        return;
+    }
+
+    sequence = psr->sequence;
+    __atomic_store_n(&psr->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (index = 0; (index < ARY_MAX_LEASES) && (count < ARY_MAX_SHARED_ENTRIES); index++) {
+        pl = &psp->lease[index];
+        pse = &psr->entry[count];
+        if ((pl->in_use == 0) || (inet_pton(AF_INET, pl->ip, &pse->addr) != 1)) {
+            continue;
+        }
+        memcpy(pse->name, pl->name, SZ_CHAR_LABEL);
+        pse->port = pl->port;
+        count++;
+    }
+    psr->count = count;
+    psr->epoch = psp->epoch;
+    psr->published = psp->version;
+
+    __atomic_store_n(&psr->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * service_registry_shared_close()
+ * - removes psp's segment, so clients stop reading it at once
+ */
+void service_registry_shared_close(PServiceProvider psp) {
+    if (psp->shared == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&psp->shared->owner, (int64_t) 0, __ATOMIC_RELEASE);
+    munmap(psp->shared, sizeof(SharedRegistry));
+    psp->shared = NULL;
+    shm_unlink(gd_pch_shared_registry);
+}
+
+/**
+ * service_registry_shared_lookup()
+ * - reads the entries of service_name, every entry for NULL, from the
+ *   segment of a live locator on this host; sends nothing
+ *
+ * - returns Populated Registry | NULL when off, unpublished or not listed
+ */
+PServiceRegistry service_registry_shared_lookup(const char *service_name) {
+    SharedRegistryEntry copy[ARY_MAX_SHARED_ENTRIES];
+    PSharedRegistry psr = NULL;
+    PServiceRegistry preg = NULL;
+    char ip[INET_ADDRSTRLEN], port[SZ_CHAR_LABEL];
+    int copied = 0, index = 0;
+
+    if ((gd_pch_shared_registry == NULL) || (strcmp(gd_pch_shared_registry, "none") == 0)) {
+        return NULL;
+    }
+    if ((psr = service_registry_shared_map(gd_pch_shared_registry, 0)) == NULL) {
+        return NULL;
+    }
+    if (service_registry_shared_owner_alive(psr)) {
+        copied = service_registry_shared_copy(psr, service_name, copy);
+    }
+    munmap(psr, sizeof(SharedRegistry));
+
+    if ((copied > 0) && ((preg = service_registry_create()) != NULL)) {
+        for (index = 0; index < copied; index++) {
+            inet_ntop(AF_INET, &copy[index].addr, ip, sizeof(ip));
+            snprintf(port, sizeof(port), "%d", copy[index].port);
+            service_registry_entry_create(preg, copy[index].name, ip, port, NULL);
+        }
+    }
+
+    return preg;
+}
+
+/**
+ * service_registry_discover_shared()
+ * - service_registry_discover_cached() that first looks in the shared
+ *   registry: when pdr wants a named service and the local locator lists
+ *   at least min_responders providers of it, no request is sent at all
+ * - a min_responders of 0 waits out the window for every responder, so
+ *   it always goes to the network
+ *
+ * - Returns Populated Registry
+ */
+PServiceRegistry service_registry_discover_shared(int i_socket, char *request, PDiscoveryRequest pdr) {
+    PServiceRegistry psr = NULL;
+    struct timeval start;
+
+    if ((pdr->service_name != NULL) && (pdr->min_responders > 0)) {
+        gettimeofday(&start, NULL);
+        psr = service_registry_shared_lookup(pdr->service_name);
+        if ((psr != NULL) && (service_registry_entry_count(psr) >= pdr->min_responders)) {
+            skn_logger(SD_NOTICE, "Discovery: %s found in %1.3fs, shared registry %s, no datagrams sent",
+                       pdr->service_name, skn_duration_in_milliseconds(&start, NULL), gd_pch_shared_registry);
+            return psr;
+        }
+        if (psr != NULL) {
+            service_registry_destroy(psr);
+        }
+    }
+
+    return service_registry_discover_cached(i_socket, request, pdr);
+}
@@ -0,0 +1,180 @@
+/**
+ * skn_render_benchmark.c
+ * - Developer tool, not installed
+ *
+ * Replays message streams through the display service's render core onto
+ * the sim device, frame by frame as the frame timer would, with no LCD and
+ * no wiringPi.  After every frame the simulated screen must match the
+ * framebuffer's shadow.
+ *
+ * Streams:
+ *   idle   - the welcome and host lines only, scrolling
+ *   chatty - a message every frame
+ *   burst  - twice the ring's slots every second, the overflow dropped
+ *   file   - one message per line of a file, a line every frame
+ *
+ * Reported per stream: render cost per frame, cells and cursor moves per
+ * frame, and the bytes a second a serial LCD and a PCF8574 I2C backpack
+ * would carry at the frame rate.
+ *
+ * cmdline: ./skn_render_benchmark [frames] [message file]
+*/
+
+#include "skn_network_helpers.h"
+
+#define BENCH_FRAMES      6000
+#define BENCH_MAX_LINES   256
+
+typedef struct _benchStream {
+    const char *name;
+    int every;                   // frames between publishes, 0 never
+    int count;                   // messages a publish
+} BenchStream, *PBenchStream;
+
+static char gs_line[BENCH_MAX_LINES][SZ_INFO_BUFF];
+static int gs_lines = 0;
+
+static const char *gs_sample[] = {
+    "rpi_locator_service on 10.100.1.5:48028",
+    "lcd_display_service",
+    "Load average 0.08 0.12 0.10",
+    "This is a Display Message from a Raspberry Pi client",
+    "temp=48.3'C",
+    "ok"
+};
+
+static long bench_ns(struct timespec *pstart, struct timespec *pend) {
+    return ((pend->tv_sec - pstart->tv_sec) * 1000000000L) + (pend->tv_nsec - pstart->tv_nsec);
+}
+
+static int bench_load(const char *path) {
+    FILE *fp = NULL;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        skn_logger(SD_ERR, "Benchmark: cannot open %s %d:%s", path, errno, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    while ((gs_lines < BENCH_MAX_LINES) && (fgets(gs_line[gs_lines], SZ_INFO_BUFF, fp) != NULL)) {
+        gs_line[gs_lines][strcspn(gs_line[gs_lines], "\r\n")] = 0;
+        if (gs_line[gs_lines][0] != 0) {
+            gs_lines++;
+        }
+    }
+    fclose(fp);
+
+    return ((gs_lines > 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/**
+ * bench_stream()
+ * - renders frames of one stream onto a fresh display manager
+ *
+ * - returns count of frames where the sim screen and the shadow differ
+ */
+static int bench_stream(PBenchStream pbs, int frames, const char **lines, int count) {
+    PDisplayManager pdm = NULL;
+    struct timespec start, end;
+    double interval = 1.0 / gd_i_frame_rate, seconds = frames * interval;
+    long ns = 0;
+    unsigned long serial = 0, i2c = 0;
+    int frame = 0, index = 0, next = 0, differ = 0, quiet = open("/dev/null", O_WRONLY), log = dup(STDERR_FILENO);
+
+    if ((pdm = skn_display_manager_create("Render benchmark, the welcome message")) == NULL) {
+        return frames;
+    }
+    if (skn_device_manager_Simulator(pdm) == NULL) {
+        skn_display_manager_destroy(pdm);
+        return frames;
+    }
+    skn_display_frame_init(pdm);
+
+    dup2(quiet, STDERR_FILENO);  // add_line logs every message, still paid for in the timing
+    for (frame = 0; frame < frames; frame++) {
+        if ((pbs->every > 0) && ((frame % pbs->every) == 0)) {
+            for (index = 0; index < pbs->count; index++) {
+                skn_display_ring_publish(&pdm->ring, lines[next++ % count]);
+            }
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        skn_display_manager_render_frame(pdm, interval);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns += bench_ns(&start, &end);
+
+        if (skn_display_sim_compare(pdm) != 0) {
+            if (differ++ == 0) {
+                dup2(log, STDERR_FILENO);
+                skn_logger(SD_ERR, "Differs: %s frame %d, simulated screen against shadow", pbs->name, frame);
+                skn_display_sim_dump(pdm);
+                dup2(quiet, STDERR_FILENO);
+            }
+        }
+    }
+    dup2(log, STDERR_FILENO);
+    close(log);
+    close(quiet);
+
+    serial = (pdm->lcd.sim->commands * SKN_SIM_SERIAL_MOVE) + pdm->lcd.sim->cells;
+    i2c = (pdm->lcd.sim->commands + pdm->lcd.sim->cells) * SKN_SIM_I2C_BYTES;
+    skn_logger(" ", "%-7s %9.1f %7.2f %7.2f %8lu %9.1f %9.1f %8.1f%%",
+               pbs->name, (double) ns / frames,
+               (double) pdm->fb.cells / frames, (double) pdm->fb.moves / frames, pdm->ring.dropped,
+               serial / seconds, i2c / seconds,
+               (i2c * 9.0 / seconds) / 1000.0);   // 9 clocks a byte at 100kHz, as a percentage
+
+    skn_display_sim_destroy(pdm);
+    skn_display_manager_destroy(pdm);
+
+    return differ;
+}
+
+int main(int argc, char *argv[]) {
+    BenchStream stream[] = {
+        { "idle",   0, 0 },
+        { "chatty", 1, 1 },
+        { "burst",  SKN_DISPLAY_FRAME_RATE, ARY_MAX_DM_MESSAGES * 2 },
+        { "file",   1, 1 }
+    };
+    const char *lines[BENCH_MAX_LINES];
+    int frames = BENCH_FRAMES, index = 0, streams = 3, differ = 0;
+
+    skn_program_name_and_description_set(
+            "skn_render_benchmark",
+            "Display render cost and LCD bus load on the simulated LCD."
+            );
+
+    if (argc > 1) {
+        frames = atoi(argv[1]);
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+    if (argc > 2) {
+        if (bench_load(argv[2]) == EXIT_FAILURE) {
+            exit(EXIT_FAILURE);
+        }
+        streams = 4;
+    }
+    for (index = 0; index < gs_lines; index++) {
+        lines[index] = gs_line[index];
+    }
+
+    gd_pch_device_name = "sim";
+    skn_logger(" ", "Render core on the simulated %dx%d LCD, %d frames at %d/s, %1.1f cells/s scroll",
+               gd_i_cols, gd_i_rows, frames, gd_i_frame_rate, gd_d_scroll_speed[0]);
+    skn_logger(" ", "%-7s %9s %7s %7s %8s %9s %9s %9s",
+               "stream", "ns/frame", "cells", "moves", "dropped", "serial-B/s", "i2c-B/s", "i2c-load");
+    for (index = 0; index < streams; index++) {
+        if (index < 3) {
+            differ += bench_stream(&stream[index], frames, gs_sample, (int) (sizeof(gs_sample) / sizeof(gs_sample[0])));
+        } else {
+            differ += bench_stream(&stream[index], frames, lines, gs_lines);
+        }
+    }
+    if (differ > 0) {
+        skn_logger(SD_ERR, "%d frames left the simulated screen unlike the shadow", differ);
+        exit(EXIT_FAILURE);
+    }
+
+    exit(EXIT_SUCCESS);
+}
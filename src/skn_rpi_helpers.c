@@ -5,70 +5,35 @@
 #include "skn_network_helpers.h"
 #include "skn_rpi_helpers.h"
 
-/*
- *  Global lcd handle:
- */
-int gd_i_rows = 4;
-int gd_i_cols = 20;
-char *gd_pch_serial_port;
-char *gd_pch_device_name = "pcf";
-PDisplayManager gp_structure_pdm = NULL;
-
 static void skn_display_print_usage();
-static PDisplayManager skn_display_manager_create(char * welcome);
-static void skn_display_manager_destroy(PDisplayManager pdm);
+static int skn_display_chipset_built(const char *name);
+static int skn_display_parse_scroll_speeds(const char *list);
 static void * skn_display_manager_message_consumer_thread(void * ptr);
+static int skn_display_manager_on_message(void *pem, void *pes);
+static int skn_display_manager_on_frame(void *pem, void *pes);
+static int skn_display_manager_on_host_update(void *pem, void *pes);
+static void skn_display_manager_add_host_lines(PDisplayManager pdm);
+
+#ifdef SKN_HAVE_WIRINGPI
 static PLCDDevice skn_device_manager_init_i2c(PDisplayManager pdm);
+static void skn_device_manager_i2c_move(PLCDDevice plcd, int row, int col);
+static void skn_device_manager_i2c_put(PLCDDevice plcd, const char *cells, int len);
 
 /*
  * Device Methods
 */
-PLCDDevice skn_device_manager_SerialPort(PDisplayManager pdm) {
-    PLCDDevice plcd =  NULL;
-
-    if (pdm == NULL) {
-        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources. %d:%s", errno, strerror(errno));
-        return NULL;
-    }
-
-    plcd = (PLCDDevice)&pdm->lcd;
-    strncpy(plcd->cbName, "LCDDevice#SerialPort", SZ_CHAR_BUFF-1);
-    if (gd_pch_serial_port != NULL) {
-        strncpy(plcd->ch_serial_port_name, gd_pch_serial_port, SZ_CHAR_BUFF-1);
-    } else {
-        strncpy(plcd->ch_serial_port_name, "/dev/ttyACM0", SZ_CHAR_BUFF-1);
-    }
-
-    skn_logger(SD_NOTICE, "DeviceManager using  device [%s](%s)", plcd->cbName, gd_pch_serial_port);
-
-    pdm->lcd_handle = plcd->lcd_handle =  serialOpen (plcd->ch_serial_port_name, 9600);
-    if (plcd->lcd_handle == PLATFORM_ERROR) {
-        skn_logger(SD_ERR, "DeviceManager failed to acquire needed resources: SerialPort=%s %d:%s",
-                   plcd->ch_serial_port_name, errno, strerror(errno));
-        return NULL;
-    }
+static void skn_device_manager_i2c_move(PLCDDevice plcd, int row, int col) {
+    lcdPosition(plcd->lcd_handle, col, row);
+}
 
-    // set backlight & clear screen
-    char display_on[] = { 0xfe, 0x42 };
-    char  cls[]   = { 0xfe, 0x58 };
-    char home[]  = { 0xfe, 0x48 };
-//    char set_cols_rows[] = {0xfe, 0xd1, gd_i_cols, gd_i_rows };
-    char set_contrast[] = {0xfe, 0x50, 0xdc};
-    char cursor_off[] = {0xfe, 0x4B };
-
-    write(pdm->lcd_handle, set_contrast, sizeof(set_contrast));
-        sleep(1);
-    write(pdm->lcd_handle, home, sizeof(home));
-        sleep(1);
-    write(pdm->lcd_handle, cursor_off, sizeof(cursor_off));
-        sleep(1);
-    write(pdm->lcd_handle, cls, sizeof(cls));
-        sleep(1);
-    write(pdm->lcd_handle, display_on, sizeof(display_on));
-        sleep(1);
+static void skn_device_manager_i2c_put(PLCDDevice plcd, const char *cells, int len) {
+    char run[ARY_MAX_LCD_COLS + 1];
 
-    return plcd;
+    memcpy(run, cells, len);
+    run[len] = 0;
+    lcdPuts(plcd->lcd_handle, run);
 }
+
 PLCDDevice skn_device_manager_MCP23017(PDisplayManager pdm) {
     PLCDDevice plcd =  NULL;
     int base = 0;
@@ -188,6 +153,9 @@ void skn_device_manager_backlight(int af_backlight, int state) {
 static PLCDDevice skn_device_manager_init_i2c(PDisplayManager pdm) {
     PLCDDevice plcd = (PLCDDevice)&pdm->lcd;
 
+    plcd->move = skn_device_manager_i2c_move;
+    plcd->put = skn_device_manager_i2c_put;
+
     // call the initializer
     plcd->setup(plcd->af_base, plcd->i2c_address);
 
@@ -225,6 +193,8 @@ static PLCDDevice skn_device_manager_init_i2c(PDisplayManager pdm) {
 
     return plcd;
 }
+#endif // SKN_HAVE_WIRINGPI
+
 /*
  * LCDSetup:
  *  Setup the pcf8574 or mcp23008 lcd by making sure the additional pins are
@@ -234,6 +204,16 @@ static PLCDDevice skn_device_manager_init_i2c(PDisplayManager pdm) {
 int skn_device_manager_LCD_setup(PDisplayManager pdm, char *device_name) {
     PLCDDevice rc = NULL;
 
+    if (strcmp(device_name, "sim") == 0) {
+        rc = skn_device_manager_Simulator(pdm);
+        return ((rc == NULL) ? PLATFORM_ERROR : pdm->lcd_handle);
+    }
+    if (strcmp(device_name, "ser") == 0) {
+        rc = skn_device_manager_SerialPort(pdm);
+        return ((rc == NULL) ? PLATFORM_ERROR : pdm->lcd_handle);
+    }
+
+#ifdef SKN_HAVE_WIRINGPI
     /*
      * Initial I2C Services */
     wiringPiSetupSys();
@@ -242,11 +222,12 @@ int skn_device_manager_LCD_setup(PDisplayManager pdm, char *device_name) {
         rc = skn_device_manager_MCP23008(pdm);
     } else if (strcmp(device_name, "mc7") == 0) {
         rc = skn_device_manager_MCP23017(pdm);
-    } else if (strcmp(device_name, "ser") == 0) {
-        rc = skn_device_manager_SerialPort(pdm);
     } else { // PCF8574
         rc = skn_device_manager_PCF8574(pdm);
     }
+#else
+    skn_logger(SD_ERR, "DeviceManager: chipset %s needs wiringPi, this build has %s only", device_name, SKN_DISPLAY_CHIPSETS);
+#endif
 
     if (rc == NULL) {
         return PLATFORM_ERROR;
@@ -255,16 +236,14 @@ int skn_device_manager_LCD_setup(PDisplayManager pdm, char *device_name) {
     }
 }
 int skn_device_manager_LCD_shutdown(PDisplayManager pdm) {
-    if (strcmp("ser", gd_pch_device_name) == 0) {
-        char display_off[] = { 0xfe, 0x46 };
-        char cls[]   = { 0xfe, 0x58 };
-
-        write(pdm->lcd_handle, display_off, sizeof(display_off));
-            sleep(1);
-        write(pdm->lcd_handle, cls, sizeof(cls));
-
-        serialClose(pdm->lcd_handle);
+    if (strcmp("sim", gd_pch_device_name) == 0) {
+        skn_display_sim_dump(pdm);
+        skn_display_sim_log_counters(pdm);
+        skn_display_sim_destroy(pdm);
+    } else if (strcmp("ser", gd_pch_device_name) == 0) {
+        skn_device_manager_serial_shutdown(pdm);
     } else {
+#ifdef SKN_HAVE_WIRINGPI
         lcdClear(pdm->lcd_handle);
         if (strcmp(gd_pch_device_name, "mc7") == 0) {
             skn_device_manager_backlight(pdm->lcd.af_red, LOW);
@@ -273,6 +252,7 @@ int skn_device_manager_LCD_shutdown(PDisplayManager pdm) {
         } else {
             skn_device_manager_backlight(pdm->lcd.af_backlight, LOW);
         }
+#endif
     }
     return EXIT_SUCCESS;
 }
@@ -326,6 +306,15 @@ long getCpuTemps(PCpuTemps temps) {
  * Message Builders exclusively for Raspberry Pis
  */
 int generate_rpi_model_info(char *msg) {
+#ifndef SKN_HAVE_WIRINGPI
+    struct utsname info;
+
+    if (uname(&info) != 0) {
+        strcpy(info.machine, "unknown");
+    }
+    return snprintf(msg, SZ_INFO_BUFF -1, "Device: %s, Cpus: %ld, %s:%s", info.machine,
+                    skn_get_number_of_cpu_cores(), gd_ch_intfName, gd_ch_ipAddress);
+#else
     int model = 0, rev = 0, mem = 0, maker = 0, overVolted = 0, mLen = 0;
     char * message = "Device has an unknown model type.\n";
 
@@ -338,6 +327,7 @@ int generate_rpi_model_info(char *msg) {
                         gd_ch_ipAddress);
     }
     return mLen;
+#endif
 }
 
 /**
@@ -360,180 +350,45 @@ int generate_cpu_temps_info(char *msg) {
 }
 
 /**
- * skn_scroller_pad_right
- * - fills remaining with spaces and 0 terminates
- * - buffer   message to adjust
+ * skn_display_manager_add_host_lines()
+ * - date, model, uname and load average lines
  */
-char * skn_scroller_pad_right(char *buffer) {
-    int hIndex = 0;
-
-    for (hIndex = strlen(buffer); hIndex < gd_i_cols; hIndex++) {
-        buffer[hIndex] = ' ';
-    }
-    buffer[gd_i_cols] = 0;
+static void skn_display_manager_add_host_lines(PDisplayManager pdm) {
+    char ch_lcd_message[4][SZ_INFO_BUFF];
 
-    return buffer;
+    generate_datetime_info (ch_lcd_message[0]);
+    generate_rpi_model_info(ch_lcd_message[1]);
+//    generate_cpu_temps_info(ch_lcd_message[2]);
+    generate_uname_info    (ch_lcd_message[2]);
+    generate_loadavg_info  (ch_lcd_message[3]);
+    skn_display_manager_add_line(pdm, ch_lcd_message[0]);
+    skn_display_manager_add_line(pdm, ch_lcd_message[1]);
+    skn_display_manager_add_line(pdm, ch_lcd_message[2]);
+    skn_display_manager_add_line(pdm, ch_lcd_message[3]);
 }
 
 /**
- * skn_scroller_wrap_blanks
- *  - builds str with 20 chars in front, and 20 at right end
+ * skn_display_manager_on_frame()
+ * - frame timer: takes in the messages waiting in the ring, then scrolls
+ *   each visible line by its row's speed for the time the frame covers,
+ *   and sends what changed
  */
-char * skn_scroller_wrap_blanks(char *buffer) {
-    char worker[SZ_INFO_BUFF];
-    char col_width_padding[16];
-
-    if (buffer == NULL || strlen(buffer) > SZ_INFO_BUFF) {
-        return NULL;
-    }
-
-    snprintf(col_width_padding, 16, "%%%ds%%s%%%ds", gd_i_cols, gd_i_cols);
-    snprintf(worker, (SZ_INFO_BUFF - 1), col_width_padding, " ", buffer, " ");
-    memmove(buffer, worker, SZ_INFO_BUFF-1);
-    buffer[SZ_INFO_BUFF - 1] = 0;
+static int skn_display_manager_on_frame(void *pem, void *pes) {
+    PDisplayManager pdm = (PDisplayManager) ((PEventSource) pes)->context;
 
-    return buffer;
-}
-
-/**
- * Scrolls a single line across the lcd display
- * - best when wrapped in column chars on each side
- */
-int skn_scroller_scroll_lines(PDisplayLine pdl, int lcd_handle, int line)
-{
-    char buf[40];
-    signed int hAdjust = 0, mLen = 0, mfLen = 0;
-    char set_col_row_position[] = {0xfe, 0x47, 0x01, 0x01};
-
-    mLen = strlen(&(pdl->ch_display_msg[pdl->display_pos]));
-    if (gd_i_cols < mLen) {
-        mfLen = pdl->msg_len;
-        hAdjust = (mfLen - gd_i_cols);
-    }
-
-    snprintf(buf, sizeof(buf) - 1, "%s", &(pdl->ch_display_msg[pdl->display_pos]));
-    skn_scroller_pad_right(buf);
-
-    if (strcmp("ser", gd_pch_device_name) == 0 ) {
-        set_col_row_position[3] = (unsigned int)line + 1;
-        write(lcd_handle, set_col_row_position, sizeof(set_col_row_position));
-        skn_time_delay(0.2); // delay(200);
-        write(lcd_handle, buf, gd_i_cols - 1);
-    } else {
-        lcdPosition(lcd_handle, 0, line);
-        lcdPuts(lcd_handle, buf);
-    }
-    if (++pdl->display_pos > hAdjust) {
-        pdl->display_pos = 0;
-    }
+    skn_display_manager_render_frame(pdm, skn_display_frame_tick(pdm, ((PEventSource) pes)->expirations));
 
-    return pdl->display_pos;
+    return EXIT_SUCCESS;
 }
 
-/**
- * skn_display_manager_select_set
- * - adds newest to top of double-linked-list
- * - only keeps 8 in collections
- * - reuses in top down fashion
- */
-static PDisplayManager skn_display_manager_create(char * welcome) {
-    int index = 0, next = 0, prev = 0;
-    PDisplayManager pdm = NULL;
-    PDisplayLine pdl = NULL;
-
-    pdm = (PDisplayManager) malloc(sizeof(DisplayManager));
-    if (pdm == NULL) {
-        skn_logger(SD_ERR, "Display Manager cannot acquire needed resources. %d:%s", errno, strerror(errno));
-        return NULL;
-    }
-
-    memset(pdm, 0, sizeof(DisplayManager));
-    strcpy(pdm->cbName, "PDisplayManager");
-    memmove(pdm->ch_welcome_msg, welcome, SZ_INFO_BUFF-1);
-    pdm->msg_len = strlen(welcome);
-
-    pdm->dsp_cols = gd_i_cols;
-    pdm->dsp_rows = gd_i_rows;
-    pdm->current_line = 0;
-    pdm->next_line = gd_i_rows;
-
-    for (index = 0; index < ARY_MAX_DM_LINES; index++) {
-        pdl = pdm->pdsp_collection[index] = (PDisplayLine) malloc(sizeof(DisplayLine)); // line x
-        memset(pdl, 0, sizeof(DisplayLine));
-        strcpy(pdl->cbName, "PDisplayLine");
-        strncpy(pdl->ch_display_msg, welcome, (SZ_INFO_BUFF -1));  // load all with welcome message
-        pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
-        pdl->msg_len = pdm->msg_len;
-        pdl->active = 1;
-        if (pdl->msg_len > gd_i_cols) {
-            pdl->scroll_enabled = 1;
-            skn_scroller_wrap_blanks(pdl->ch_display_msg);
-            pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
-            pdl->msg_len = strlen(pdl->ch_display_msg);
-        }
-    }
-    for (index = 0; index < ARY_MAX_DM_LINES; index++) {               // enable link list routing
-            next = (((index + 1) == ARY_MAX_DM_LINES) ? 0 : (index + 1));
-            prev = (((index - 1) == -1) ? (ARY_MAX_DM_LINES - 1) : (index - 1));
-            pdm->pdsp_collection[index]->next = pdm->pdsp_collection[next];
-            pdm->pdsp_collection[index]->prev = pdm->pdsp_collection[prev];
-    }
-    return pdm;
+static int skn_display_manager_on_host_update(void *pem, void *pes) {
+    skn_display_manager_add_host_lines((PDisplayManager) ((PEventSource) pes)->context);
+    return EXIT_SUCCESS;
 }
-PDisplayLine skn_display_manager_add_line(PDisplayManager pdmx, char * client_request_message) {
-    PDisplayLine pdl = NULL;
-    PDisplayManager pdm = NULL;
-
-    pdm = ((pdmx == NULL) ? skn_get_display_manager_ref() : pdmx);
-    if (pdm == NULL || client_request_message == NULL) {
-        return NULL;
-    }
-
-    /*
-     * manage next index */
-    pdl = pdm->pdsp_collection[pdm->next_line++]; // manage next index
-    if (pdm->next_line == ARY_MAX_DM_LINES) {
-        pdm->next_line = 0; // roll it
-    }
-
-    /*
-     * load new message */
-    strncpy(pdl->ch_display_msg, client_request_message, (SZ_INFO_BUFF-1));
-    pdl->ch_display_msg[SZ_INFO_BUFF - 1] = 0;    // terminate string in case
-    pdl->msg_len = strlen(pdl->ch_display_msg);
-    pdl->active = 1;
-    pdl->display_pos = 0;
-    if (pdl->msg_len > gd_i_cols) {
-        pdl->scroll_enabled = 1;
-        skn_scroller_wrap_blanks(pdl->ch_display_msg);
-        pdl->ch_display_msg[(SZ_INFO_BUFF - 1)] = 0;    // terminate string in case
-        pdl->msg_len = strlen(pdl->ch_display_msg);
-    } else {
-        pdl->scroll_enabled = 0;
-    }
-
-    /*
-     * manage current_line */
-    pdm->pdsp_collection[pdm->current_line]->active = 0;
-    pdm->pdsp_collection[pdm->current_line++]->msg_len = 0;
-    if (pdm->current_line == ARY_MAX_DM_LINES) {
-        pdm->current_line = 0;
-    }
-
-    skn_logger(SD_DEBUG, "DM Added msg=%d:%d:[%s]", ((pdm->next_line - 1) < 0 ? 0 : (pdm->next_line - 1)), pdl->msg_len, pdl->ch_display_msg);
 
-    /* return this line's pointer */
-    return pdl;
-}
-PDisplayManager skn_get_display_manager_ref() {
-    return gp_structure_pdm;
-}
 int skn_display_manager_do_work(char * client_request_message) {
-    int index = 0, dsp_line_number = 0;
     PDisplayManager pdm = NULL;
-    PDisplayLine pdl = NULL;
-    char ch_lcd_message[4][SZ_INFO_BUFF];
-    long host_update_cycle = 0;
+    PEventManager pem = NULL;
 
     gp_structure_pdm = pdm = skn_display_manager_create(client_request_message);
     if (pdm == NULL) {
@@ -541,15 +396,7 @@ int skn_display_manager_do_work(char * client_request_message) {
         skn_logger(SD_ERR, "Display Manager cannot acquire needed resources. DMCreate()");
         return gi_exit_flag;
     }
-    generate_datetime_info (ch_lcd_message[0]);
-    generate_rpi_model_info(ch_lcd_message[1]);
-//    generate_cpu_temps_info(ch_lcd_message[2]);
-    generate_uname_info    (ch_lcd_message[2]);
-    generate_loadavg_info  (ch_lcd_message[3]);
-    skn_display_manager_add_line(pdm, ch_lcd_message[0]);
-    skn_display_manager_add_line(pdm, ch_lcd_message[1]);
-    skn_display_manager_add_line(pdm, ch_lcd_message[2]);
-    skn_display_manager_add_line(pdm, ch_lcd_message[3]);
+    skn_display_manager_add_host_lines(pdm);
 
     if (skn_device_manager_LCD_setup(pdm, gd_pch_device_name) == PLATFORM_ERROR) {
         gi_exit_flag = SKN_RUN_MODE_STOP;
@@ -557,10 +404,25 @@ int skn_display_manager_do_work(char * client_request_message) {
         skn_display_manager_destroy(pdm);
         return gi_exit_flag;
     }
+    skn_display_frame_init(pdm);
+    skn_display_frame_schedule(pdm, 1.0 / gd_i_frame_rate);
+
+    pem = skn_event_manager_create("DisplayRender");
+    if ((pem == NULL) ||
+        (skn_event_manager_add_timer(pem, pdm->frame.interval, skn_display_manager_on_frame, pdm) == PLATFORM_ERROR) ||
+        (skn_event_manager_add_timer(pem, SKN_DISPLAY_HOST_INTERVAL, skn_display_manager_on_host_update, pdm) == PLATFORM_ERROR)) {
+        gi_exit_flag = SKN_RUN_MODE_STOP;
+        skn_logger(SD_ERR, "Display Manager cannot acquire needed resources: EventManager().");
+        skn_event_manager_destroy(pem);
+        skn_device_manager_LCD_shutdown(pdm);
+        skn_display_manager_destroy(pdm);
+        return gi_exit_flag;
+    }
 
     if (skn_display_manager_message_consumer_startup(pdm) == EXIT_FAILURE) {
         gi_exit_flag = SKN_RUN_MODE_STOP;
         skn_logger(SD_ERR, "Display Manager cannot acquire needed resources: Consumer().");
+        skn_event_manager_destroy(pem);
         skn_display_manager_destroy(pdm);
         return gi_exit_flag;
     }
@@ -569,30 +431,10 @@ int skn_display_manager_do_work(char * client_request_message) {
 
     /*
      *  Do the Work
+     *  - sleeps between frames; a signal or QUIT! ends it through the shutdown eventfd
      */
-    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
-        dsp_line_number = 0;
-        pdl = pdm->pdsp_collection[pdm->current_line];
-	
-        for (index = 0; index < pdm->dsp_rows; index++) {
-            if (pdl->active == 1) {
-                skn_scroller_scroll_lines(pdl, pdm->lcd_handle, dsp_line_number++);
-                skn_time_delay(0.18); // delay(180);
-            }
-            pdl = (PDisplayLine) pdl->next;
-        }
-
-        if ((host_update_cycle++ % 900) == 0) {  // roughly every fifteen minutes
-            generate_datetime_info (ch_lcd_message[0]);
-//            generate_cpu_temps_info(ch_lcd_message[2]);
-            generate_loadavg_info  (ch_lcd_message[3]);
-            skn_display_manager_add_line(pdm, ch_lcd_message[0]);
-            skn_display_manager_add_line(pdm, ch_lcd_message[1]);
-            skn_display_manager_add_line(pdm, ch_lcd_message[2]);
-            skn_display_manager_add_line(pdm, ch_lcd_message[3]);
-            host_update_cycle = 1;
-        }
-    }
+    skn_event_manager_run(pem);
+    skn_event_manager_destroy(pem);
 
     skn_device_manager_LCD_shutdown(pdm);
 
@@ -602,25 +444,15 @@ int skn_display_manager_do_work(char * client_request_message) {
      * Stop UDP Listener
      */
     skn_display_manager_message_consumer_shutdown(pdm);
+    skn_display_manager_log_counters(pdm);
+    skn_resolver_shutdown();
+    skn_interface_cache_shutdown();
 
     skn_display_manager_destroy(pdm);
     gp_structure_pdm = pdm = NULL;
 
     return gi_exit_flag;
 }
-static void skn_display_manager_destroy(PDisplayManager pdm) {
-    int index = 0;
-
-    // free collection
-    for (index = 0; index < ARY_MAX_DM_LINES; index++) {
-        if (pdm->pdsp_collection[index] != NULL) {
-            free(pdm->pdsp_collection[index]);
-        }
-    }
-    // free manager
-    if (pdm != NULL)
-        free(pdm);
-}
 
 /**
  * skn_display_manager_message_consumer(PDisplayManager pdm)
@@ -629,7 +461,7 @@ static void skn_display_manager_destroy(PDisplayManager pdm) {
 int skn_display_manager_message_consumer_startup(PDisplayManager pdm) {
     /*
      * Start UDP Listener */
-    pdm->i_socket = skn_udp_host_create_regular_socket(SKN_RPI_DISPLAY_SERVICE_PORT, 30.0);
+    pdm->i_socket = skn_udp_host_create_regular_socket(SKN_RPI_DISPLAY_SERVICE_PORT, 0.0);
     if (pdm->i_socket == EXIT_FAILURE) {
         skn_logger(SD_EMERG, "DisplayManager: Host Init Failed!");
         return EXIT_FAILURE;
@@ -643,7 +475,6 @@ int skn_display_manager_message_consumer_startup(PDisplayManager pdm) {
         close(pdm->i_socket);
         return EXIT_FAILURE;
     }
-    sleep(1); // give thread a chance to start
 
     skn_logger(SD_NOTICE, "DisplayManager: Thread startup successful... ");
 
@@ -655,9 +486,8 @@ void skn_display_manager_message_consumer_shutdown(PDisplayManager pdm) {
     void *trc = NULL;
 
     if (pdm->thread_complete != 0) {
-        skn_logger(SD_WARNING, "DisplayManager: Canceling thread.");
-        pthread_cancel(pdm->dm_thread);
-        sleep(1);
+        skn_logger(SD_WARNING, "DisplayManager: Stopping thread.");
+        skn_event_manager_request_shutdown();
     } else {
         skn_logger(SD_WARNING, "DisplayManager: Thread was already stopped.");
     }
@@ -672,84 +502,132 @@ void skn_display_manager_message_consumer_shutdown(PDisplayManager pdm) {
 
 static void * skn_display_manager_message_consumer_thread(void * ptr) {
     PDisplayManager pdm = (PDisplayManager) ptr;
-    struct sockaddr_in remaddr; /* remote address */
-    socklen_t addrlen = sizeof(remaddr); /* length of addresses */
-    IPBroadcastArray aB;
+    PEventManager pem = NULL;
+    long int exit_code = EXIT_SUCCESS;
+
+    if (skn_interface_cache_snapshot() == NULL) {
+        exit_code = PLATFORM_ERROR;
+        pthread_exit((void *) exit_code);
+    }
+
+    pdm->pb = skn_udp_batch_create(gd_i_batch_size);
+    if (pdm->pb == NULL) {
+        exit_code = EXIT_FAILURE;
+        pthread_exit((void *) exit_code);
+    }
+
+    pdm->limiter = skn_rate_limiter_create(gd_i_rate_limit);
+    pdm->thread_complete = 1;
+
+    pem = skn_event_manager_create("DisplayManager");
+    if ((pem == NULL) ||
+        (skn_event_manager_add_socket(pem, pdm->i_socket, skn_display_manager_on_message, pdm) == EXIT_FAILURE)) {
+        exit_code = EXIT_FAILURE;
+    } else {
+        exit_code = skn_event_manager_run(pem);
+    }
+    skn_event_manager_destroy(pem);
+
+    skn_udp_batch_destroy(pdm->pb);
+    pdm->pb = NULL;
+    skn_rate_limiter_log_counters(pdm->limiter, "DisplayManager");
+    skn_rate_limiter_destroy(pdm->limiter);
+    pdm->limiter = NULL;
+
+    if (gi_exit_flag == SKN_RUN_MODE_RUN) {
+        gi_exit_flag = SKN_RUN_MODE_STOP;  // shutdown
+    }
+    skn_event_manager_request_shutdown();
+
+    skn_logger(SD_NOTICE, "Display Manager Thread: shutdown complete: (%ld)", exit_code);
+
+    pdm->thread_complete = 0;
+
+    pthread_exit((void *) exit_code);
+
+}
+
+/**
+ * skn_display_manager_on_message()
+ * - adds one batch of messages to the display set, each time the socket is readable
+ *
+ * - returns EXIT_SUCCESS | errno
+ */
+static int skn_display_manager_on_message(void *pem, void *pes) {
+    PDisplayManager pdm = (PDisplayManager) ((PEventSource) pes)->context;
+    PUDPBatch pb = pdm->pb;
+    struct sockaddr_in *premaddr = NULL;
     char strPrefix[SZ_INFO_BUFF];
-    char request[SZ_INFO_BUFF];
+    char *request = NULL;
     char recvHostName[SZ_INFO_BUFF];
     char *pch = NULL;
-    signed int rLen = 0, rc = 0;
-    long int exit_code = EXIT_SUCCESS;
+    const char *accepted = "200 Accepted; " SKN_WIRE_ADVERT;
+    char status[SKN_WIRE_HEADER + 32];
+    signed int count = 0, index = 0, quit = 0, resolved = FALSE, binary = FALSE, status_len = 0, admit = 0;
+    double now = 0.0;
 
-    bzero(request, sizeof(request));
     memset(recvHostName, 0, sizeof(recvHostName));
+    status_len = skn_wire_encode_text(status, sizeof(status), SKN_WIRE_STATUS, 200, "200 Accepted");
 
-    rc = get_broadcast_ip_array(&aB);
-    if (rc == -1) {
-        exit_code = rc;
-        pthread_exit((void *) exit_code);
+    if ((count = skn_udp_batch_receive(pb, pdm->i_socket)) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return EXIT_SUCCESS;
+        }
+        skn_logger(SD_ERR, "DisplayManager: RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
+        return errno;
+    }
+    if (pdm->limiter != NULL) {
+        now = skn_rate_limiter_now();
     }
 
-    pdm->thread_complete = 1;
+    for (index = 0; index < count; index++) {
+        request = pb->request[index];
+        premaddr = &pb->raddr[index];
 
-    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
-        memset(&remaddr, 0, sizeof(remaddr));
-        remaddr.sin_family = AF_INET;
-        remaddr.sin_port = htons(SKN_RPI_DISPLAY_SERVICE_PORT);
-        remaddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        addrlen = sizeof(remaddr);
-//                                                                        V- MSG_DONTWAIT or O_NONBLOCK flag with the F_SETFL fcntl(2)
-        if ((rLen = recvfrom(pdm->i_socket, request, sizeof(request) - 1, 0, (struct sockaddr *) &remaddr, &addrlen)) < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                continue;
+        /* a flooding sender is turned away before its message is decoded or its name resolved */
+        if ((admit = skn_rate_limiter_admit(pdm->limiter, premaddr->sin_addr.s_addr, now)) != SKN_RATE_ADMITTED) {
+            if (admit == SKN_RATE_BUSY) {
+                skn_udp_batch_reply(pb, index, SKN_RATE_BUSY_REPLY, sizeof(SKN_RATE_BUSY_REPLY) - 1);
             }
-            skn_logger(SD_ERR, "DisplayManager: RcvFrom() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = errno;
-            break;
+            continue;
         }
-        request[rLen] = 0;
 
-        rc = getnameinfo(((struct sockaddr *) &remaddr), sizeof(struct sockaddr_in), recvHostName, sizeof(recvHostName) - 1, NULL, 0, NI_DGRAM);
-        if (rc != 0) {
-            skn_logger(SD_ERR, "GetNameInfo() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = errno;
-            break;
-        }
-        skn_logger(SD_NOTICE, "Received request from %s @ %s:%d", recvHostName, inet_ntoa(remaddr.sin_addr), ntohs(remaddr.sin_port));
+        /* binary messages are displayed as their text and answered in binary */
+        binary = (skn_wire_decode_text(request, pb->rmsgs[index].msg_len, NULL, request, SZ_INFO_BUFF) == SKN_WIRE_MESSAGE);
+
+        resolved = skn_resolver_host_name(premaddr, recvHostName, sizeof(recvHostName));
+        skn_logger(SD_NOTICE, "Received request from %s @ %s:%d", recvHostName, inet_ntoa(premaddr->sin_addr), ntohs(premaddr->sin_port));
 
         /*
-         * Add receive data to display set */
-        pch = strtok(recvHostName, ".");
+         * Hand receive data to the render loop */
+        pch = resolved ? strtok(recvHostName, ".") : recvHostName;
         snprintf(strPrefix, sizeof(strPrefix) -1 , "%s|%s", pch, request);
-        skn_display_manager_add_line(pdm, strPrefix);
+        skn_display_ring_publish(&pdm->ring, strPrefix);
 
-        if (sendto(pdm->i_socket, "200 Accepted", strlen("200 Accepted"), 0, (struct sockaddr *) &remaddr, addrlen) < 0) {
-            skn_logger(SD_ERR, "SendTo() Failure code=%d, etext=%s", errno, strerror(errno));
-            exit_code = errno;
-            break;
+        if (binary) {
+            skn_udp_batch_reply(pb, index, status, status_len);
+        } else {
+            skn_udp_batch_reply(pb, index, accepted, strlen(accepted));
         }
 
         /*
          * Shutdown by command */
         if (strcmp("QUIT!", request) == 0) {
-            exit_code = 0;
-            gi_exit_flag = SKN_RUN_MODE_STOP;  // shutdown
-            skn_logger(SD_NOTICE, "COMMAND: Shutdown Requested! exit code=%d", exit_code);
+            skn_logger(SD_NOTICE, "COMMAND: Shutdown Requested! exit code=%d", EXIT_SUCCESS);
+            quit = 1;
             break;
         }
-
     }
-    gi_exit_flag = SKN_RUN_MODE_STOP;  // shutdown
-//    kill(getpid(), SIGUSR1); // cause a shutdown
-    skn_time_delay(0.5);
 
-    skn_logger(SD_NOTICE, "Display Manager Thread: shutdown complete: (%ld)", exit_code);
-
-    pdm->thread_complete = 0;
-
-    pthread_exit((void *) exit_code);
+    if (skn_udp_batch_send(pb, pdm->i_socket) < 0) {
+        skn_logger(SD_ERR, "SendTo() Failure code=%d, etext=%s", errno, strerror(errno));
+        return errno;
+    }
+    if (quit) {
+        skn_event_manager_stop((PEventManager) pem);
+    }
 
+    return EXIT_SUCCESS;
 }
 
 /**************************************************************************
@@ -764,24 +642,77 @@ static void * skn_display_manager_message_consumer_thread(void * ptr) {
 static void skn_display_print_usage() {
     skn_logger(" ", "%s -- %s", gd_ch_program_name, gd_ch_program_desc);
     skn_logger(" ", "\tSkoona Development <skoona@gmail.com>");
-    skn_logger(" ", "Usage:\n  %s [-v] [-m 'Welcome Message'] [-r 4|2] [-c 20|16] [-i 39|32] [-t pcf|mcp|mc7|ser] [-p string] [-h|--help]", gd_ch_program_name);
+    skn_logger(" ", "Usage:\n  %s [-v] [-m 'Welcome Message'] [-r 4|2] [-c 20|16] [-i 39|32] [-t " SKN_DISPLAY_CHIPSETS "] [-p string] [-b dd] [-x dd] [-o oldest|newest] [-f dd] [-s cps,...] [-B baud] [-P us] [-h|--help]", gd_ch_program_name);
     skn_logger(" ", "\nOptions:");
     skn_logger(" ", "  -r, --rows=dd\t\tNumber of rows in physical display.");
     skn_logger(" ", "  -c, --cols=dd\t\tNumber of columns in physical display.");
     skn_logger(" ", "  -m, --message\tWelcome Message for line 1.");
     skn_logger(" ", "  -p, --serial-port=string\tSerial port.      | ['/dev/ttyACM0']");
     skn_logger(" ", "  -i, --i2c-address=ddd\tI2C decimal address. | [0x27=39, 0x20=32]");
-    skn_logger(" ", "  -t, --i2c-chipset=pcf\tI2C Chipset.         | [pcf|mc7|mcp|ser]");
+    skn_logger(" ", "  -t, --i2c-chipset=%s\tI2C Chipset, sim is in memory. | [%s]", SKN_DISPLAY_CHIPSET, SKN_DISPLAY_CHIPSETS);
+    skn_logger(" ", "  -b, --batch-size=dd\tDatagrams per recvmmsg/sendmmsg. | [1=no batching, 16]");
+    skn_logger(" ", "  -x, --rate-limit=dd\tMessages/sec taken from one address, the rest shed. | [%d, 0=unlimited]", SKN_RATE_LIMIT);
+    skn_logger(" ", "  -o, --overflow=oldest\tMessage dropped when %d wait between frames. | [oldest|newest]", ARY_MAX_DM_MESSAGES);
+    skn_logger(" ", "  -f, --frame-rate=dd\tFrames drawn a second. | [%d, 1-%d]", SKN_DISPLAY_FRAME_RATE, SKN_MAX_FRAME_RATE);
+    skn_logger(" ", "  -s, --scroll-speed=cps,...\tCells a second each row scrolls, the last repeats. | [%1.1f]", SKN_DISPLAY_SCROLL_SPEED);
+    skn_logger(" ", "  -B, --baud=dd\tSerial LCD line rate. | [%d, 1200-115200]", SKN_SERIAL_BAUD);
+    skn_logger(" ", "  -P, --pacing=us\tMicroseconds the serial LCD takes a character. | [%d, 0-%d]", SKN_SERIAL_PACING, SKN_MAX_SERIAL_PACING);
     skn_logger(" ", "  -v, --version\tVersion printout.");
     skn_logger(" ", "  -h, --help\t\tShow this help screen.");
 }
 
+/*
+ * --scroll-speed: a speed for each row from the top, the last repeated
+ * for the rows after it */
+static int skn_display_parse_scroll_speeds(const char *list) {
+    double speed[ARY_MAX_LCD_ROWS];
+    const char *item = list;
+    char *end = NULL;
+    int index = 0, count = 0;
+
+    while ((count < ARY_MAX_LCD_ROWS) && (*item != 0)) {
+        speed[count] = strtod(item, &end);
+        if ((end == item) || (speed[count] < 0.1) || (speed[count] > SKN_MAX_SCROLL_SPEED) || ((*end != ',') && (*end != 0))) {
+            return EXIT_FAILURE;
+        }
+        count++;
+        item = ((*end == ',') ? end + 1 : end);
+    }
+    if ((count == 0) || (*item != 0)) {
+        return EXIT_FAILURE;
+    }
+    for (index = 0; index < ARY_MAX_LCD_ROWS; index++) {
+        gd_d_scroll_speed[index] = speed[(index < count) ? index : (count - 1)];
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /* *****************************************************
  *  Parse out the command line options from argc,argv
  *  results go to globals
  *  EXIT_FAILURE on any error, or version and help
  *  EXIT_SUCCESS on normal completion
  */
+/*
+ * TRUE when name is one of SKN_DISPLAY_CHIPSETS, the devices this build has */
+static int skn_display_chipset_built(const char *name) {
+    const char *item = SKN_DISPLAY_CHIPSETS;
+    size_t len = strlen(name);
+
+    while (item != NULL) {
+        if ((len > 0) && (strncmp(item, name, len) == 0) && ((item[len] == '|') || (item[len] == 0))) {
+            return TRUE;
+        }
+        item = strchr(item, '|');
+        if (item != NULL) {
+            item++;
+        }
+    }
+
+    return FALSE;
+}
+
 int skn_handle_display_command_line(int argc, char **argv) {
     int opt = 0;
     int longindex = 0;
@@ -793,10 +724,19 @@ int skn_handle_display_command_line(int argc, char **argv) {
             { "i2c-address", 1, NULL, 'i' }, /* required param if */
             { "12c-chipset", 1, NULL, 't' }, /* required param if */
             { "serial-port", 1, NULL, 'p' }, /* required param if */
+            { "batch-size", 1, NULL, 'b' }, /* required param if */
+            { "rate-limit", 1, NULL, 'x' }, /* required param if */
+            { "overflow", 1, NULL, 'o' }, /* required param if */
+            { "frame-rate", 1, NULL, 'f' }, /* required param if */
+            { "scroll-speed", 1, NULL, 's' }, /* required param if */
+            { "baud", 1, NULL, 'B' }, /* required param if */
+            { "pacing", 1, NULL, 'P' }, /* required param if */
             { "version", 0, NULL, 'v' }, /* set true if present */
             { "help", 0, NULL, 'h' }, /* set true if present */
             { 0, 0, 0, 0 } };
 
+    gd_pch_device_name = SKN_DISPLAY_CHIPSET;  // sim in a build without wiringPi
+
     /*
      * Get commandline options
      *  longindex is the current index into longopts
@@ -804,7 +744,7 @@ int skn_handle_display_command_line(int argc, char **argv) {
      *  optarg is value attached(-d88) or next element(-d 88) of argv
      *  opterr flags a scanning error
      */
-    while ((opt = getopt_long(argc, argv, "d:m:r:c:i:t:p:vh", longopts, &longindex)) != -1) {
+    while ((opt = getopt_long(argc, argv, "d:m:r:c:i:t:p:b:x:o:f:s:B:P:vh", longopts, &longindex)) != -1) {
         switch (opt) {
             case 'd':
                 if (optarg) {
@@ -874,10 +814,7 @@ int skn_handle_display_command_line(int argc, char **argv) {
             case 't':
                 if (optarg) {
                     gd_pch_device_name = strdup(optarg);
-                    if ( (strcmp(gd_pch_device_name, "mcp") != 0) &&
-                         (strcmp(gd_pch_device_name, "mc7") != 0) &&
-                         (strcmp(gd_pch_device_name, "pcf") != 0) &&
-                         (strcmp(gd_pch_device_name, "ser") != 0)) {
+                    if (skn_display_chipset_built(gd_pch_device_name) == FALSE) {
                         skn_logger(SD_ERR, "%s: unsupported option was invalid! %c[%d:%d:%d] %s\n", gd_ch_program_name, (char) opt, longindex, optind, opterr, gd_pch_device_name);
                         return EXIT_FAILURE;
                     }
@@ -899,6 +836,83 @@ int skn_handle_display_command_line(int argc, char **argv) {
                     return (EXIT_FAILURE);
                 }
                 break;
+            case 'b':
+                if (optarg) {
+                    gd_i_batch_size = atoi(optarg);
+                    if (gd_i_batch_size < 1 || gd_i_batch_size > ARY_MAX_BATCH) {
+                        skn_logger(SD_ERR, "%s: input param was invalid! (allowed 1-%d) %c[%d:%d:%d]\n", gd_ch_program_name, ARY_MAX_BATCH, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'x':
+                if (optarg) {
+                    gd_i_rate_limit = atoi(optarg);
+                    if (gd_i_rate_limit < 0 || gd_i_rate_limit > SKN_MAX_RATE_LIMIT) {
+                        skn_logger(SD_ERR, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_RATE_LIMIT, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'o':
+                if (optarg && (strcmp(optarg, "oldest") == 0)) {
+                    gd_i_ring_policy = SKN_RING_DROP_OLDEST;
+                } else if (optarg && (strcmp(optarg, "newest") == 0)) {
+                    gd_i_ring_policy = SKN_RING_DROP_NEWEST;
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! (allowed oldest|newest) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+                if (optarg) {
+                    gd_i_frame_rate = atoi(optarg);
+                    if (gd_i_frame_rate < 1 || gd_i_frame_rate > SKN_MAX_FRAME_RATE) {
+                        skn_logger(SD_ERR, "%s: input param was invalid! (allowed 1-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_FRAME_RATE, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 's':
+                if (optarg && (skn_display_parse_scroll_speeds(optarg) == EXIT_SUCCESS)) {
+                    break;
+                }
+                skn_logger(SD_ERR, "%s: input param was invalid! (allowed cps[,cps...] each 0.1-%1.0f) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_SCROLL_SPEED, (char) opt, longindex, optind, opterr);
+                return (EXIT_FAILURE);
+                break;
+            case 'B':
+                if (optarg) {
+                    gd_i_serial_baud = atoi(optarg);
+                    if (skn_display_serial_baud_valid(gd_i_serial_baud) == PLATFORM_ERROR) {
+                        skn_logger(SD_ERR, "%s: input param was invalid! (allowed 1200-115200, a standard rate) %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
+            case 'P':
+                if (optarg) {
+                    gd_i_serial_pacing = atoi(optarg);
+                    if (gd_i_serial_pacing < 0 || gd_i_serial_pacing > SKN_MAX_SERIAL_PACING) {
+                        skn_logger(SD_ERR, "%s: input param was invalid! (allowed 0-%d) %c[%d:%d:%d]\n", gd_ch_program_name, SKN_MAX_SERIAL_PACING, (char) opt, longindex, optind, opterr);
+                        return (EXIT_FAILURE);
+                    }
+                } else {
+                    skn_logger(SD_ERR, "%s: input param was invalid! %c[%d:%d:%d]\n", gd_ch_program_name, (char) opt, longindex, optind, opterr);
+                    return (EXIT_FAILURE);
+                }
+                break;
             case 'v':
                 skn_logger(SD_ERR, "\n\tProgram => %s\n\tVersion => %s\n\tSkoona Development\n\t<skoona@gmail.com>\n", gd_ch_program_name,
                                 PACKAGE_VERSION);
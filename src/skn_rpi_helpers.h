@@ -9,6 +9,11 @@
 
 #include <sys/utsname.h>
 
+/*
+ * SKN_HAVE_WIRINGPI is set by configure when libwiringPi is found; without
+ * it only the serial and sim devices are built, so the service can still be
+ * run and load tested on a build host */
+#ifdef SKN_HAVE_WIRINGPI
 #include <wiringPi.h>
 #include <pcf8574.h>
 #include <mcp23008.h>
@@ -16,28 +21,26 @@
 #include <wiringSerial.h>   // http://wiringpi.com/reference/serial-library/
 #include <lcd.h>
 
+#define SKN_DISPLAY_CHIPSETS  "pcf|mc7|mcp|ser|sim"
+#define SKN_DISPLAY_CHIPSET   "pcf"
+#else
+#define SKN_DISPLAY_CHIPSETS  "ser|sim"
+#define SKN_DISPLAY_CHIPSET   "sim"
+#endif
+
 
 /*
  *  Global Defines */
-extern int gd_i_rows;
-extern int gd_i_cols;
 extern int gd_i_i2c_address;
-extern char *gd_pch_serial_port;
-extern char *gd_pch_device_name;
-extern PDisplayManager gp_structure_pdm;
 
 /*
  * Display Manager Routines */
-extern PLCDDevice skn_device_manager_SerialPort(PDisplayManager pdm);
+#ifdef SKN_HAVE_WIRINGPI
 extern PLCDDevice skn_device_manager_MCP23008(PDisplayManager pdm);
 extern PLCDDevice skn_device_manager_MCP23017(PDisplayManager pdm);
 extern PLCDDevice skn_device_manager_PCF8574(PDisplayManager pdm);
-extern PDisplayManager skn_get_display_manager_ref();
+#endif
 extern int skn_display_manager_do_work(char * client_request_message);
-extern PDisplayLine skn_display_manager_add_line(PDisplayManager pdmx, char * client_request_message);
-extern int skn_scroller_scroll_lines(PDisplayLine pdl, int lcd_handle, int line);
-extern char * skn_scroller_pad_right(char *buffer);
-extern char * skn_scroller_wrap_blanks(char *buffer);
 
 /*
  * Display Manager Communications Routines */
@@ -47,7 +50,9 @@ extern int skn_signal_manager_shutdown(pthread_t sig_thread, sigset_t *psignal_s
 
 /* WiringPi LCD Interfaces
 */
+#ifdef SKN_HAVE_WIRINGPI
 extern void skn_device_manager_backlight(int af_backlight, int state);
+#endif
 extern int skn_device_manager_LCD_setup (PDisplayManager pdm, char *device_name);
 extern int skn_device_manager_LCD_shutdown(PDisplayManager pdm);
 
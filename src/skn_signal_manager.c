@@ -10,6 +10,7 @@
 
 
 static int skn_signal_manager_process_signals(siginfo_t *signal_info);
+static int skn_signal_manager_on_signal(void *pem, void *pes);
 static void *skn_signal_manager_handler_thread(void *l_thread_complete);
 
 /*
@@ -146,6 +147,33 @@ static int skn_signal_manager_process_signals(siginfo_t *signal_info) {
     return rval;
 }
 
+/**
+ * on_signal()
+ * - signalfd source: hands the caught signal to process_signals()
+ * - any exit request wakes every EventManager through the shutdown eventfd
+ */
+static int skn_signal_manager_on_signal(void *pem, void *pes) {
+    struct signalfd_siginfo *psi = &((PEventSource) pes)->siginfo;
+    siginfo_t signal_info;
+
+    memset(&signal_info, 0, sizeof(signal_info));
+    signal_info.si_signo = psi->ssi_signo;
+    signal_info.si_code = psi->ssi_code;
+    signal_info.si_pid = psi->ssi_pid;
+    signal_info.si_uid = psi->ssi_uid;
+    signal_info.si_status = psi->ssi_status;
+
+    *((int *) ((PEventSource) pes)->context) = psi->ssi_signo;
+
+    /* when we get this far, we've  caught a signal */
+    gi_exit_flag = skn_signal_manager_process_signals(&signal_info);
+    if (gi_exit_flag != SKN_RUN_MODE_RUN) {
+        skn_event_manager_request_shutdown();
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /**
  *  handler_thread()
  *
@@ -159,37 +187,26 @@ static int skn_signal_manager_process_signals(siginfo_t *signal_info) {
  *      returns last signal
  */
 static void *skn_signal_manager_handler_thread(void *l_thread_complete) {
+    PEventManager pem = NULL;
     sigset_t signal_set;
-    siginfo_t signal_info;
-//    struct timespec timeout;
     int sig = 0;
-    int rval = 0;
     long *threadC = (long *)l_thread_complete;
 
     *threadC = 1;
 
-//    timeout.tv_nsec = 0;
-//    timeout.tv_sec = 8;
+    /* wait for any and all signals, on a signalfd */
     sigfillset(&signal_set);
-    skn_logger(SD_NOTICE, "SignalManager: Startup Successful...");
-
-    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
-        /* wait for any and all signals */
-        /* OLD: sigwait (&signal_set, &sig); */
-        sig = sigwaitinfo(&signal_set, &signal_info);
-        if (sig == PLATFORM_ERROR) {
-            if (errno == EAGAIN) {
-                continue;
-            }
-            skn_logger(SD_WARNING, "SignalManager: sigwaitinfo() returned an error => {%s}", strerror(errno));
-            gi_exit_flag = SKN_RUN_MODE_STOP;
-            break;
-        }
-        /* when we get this far, we've  caught a signal */
-        rval = skn_signal_manager_process_signals(&signal_info);
-        gi_exit_flag = rval;
-
-    } /* end-while */
+    pem = skn_event_manager_create("SignalManager");
+    if ((pem == NULL) ||
+        (skn_event_manager_add_signals(pem, &signal_set, skn_signal_manager_on_signal, &sig) == EXIT_FAILURE)) {
+        skn_logger(SD_WARNING, "SignalManager: signalfd() setup failed => {%s}", strerror(errno));
+        gi_exit_flag = SKN_RUN_MODE_STOP;
+        skn_event_manager_request_shutdown();
+    } else {
+        skn_logger(SD_NOTICE, "SignalManager: Startup Successful...");
+        skn_event_manager_run(pem);
+    }
+    skn_event_manager_destroy(pem);
 
     pthread_sigmask(SIG_UNBLOCK, &signal_set, NULL);
 
@@ -212,13 +229,9 @@ int skn_signal_manager_shutdown(pthread_t sig_thread, sigset_t *psignal_set, lon
 
     if (gi_exit_flag <= SKN_RUN_MODE_STOP) {
         gi_exit_flag = SKN_RUN_MODE_STOP; /* shut down the system -- work is done */
-        // need to force theads down or interrupt them
+        // wake the signal thread; it is waiting on the shutdown eventfd too
         skn_logger(SD_WARNING, "shutdown caused by application!");
-        sleep(1);
-        if (*l_thread_complete != 0) {
-            pthread_cancel(sig_thread);
-            sleep(1);
-        }
+        skn_event_manager_request_shutdown();
         skn_logger(SD_WARNING, "Collecting (cleanup) threads.");
         pthread_join(sig_thread, &trc);
     } else {
@@ -247,7 +260,6 @@ int skn_signal_manager_startup(pthread_t *psig_thread, sigset_t *psignal_set, lo
         pthread_sigmask(SIG_UNBLOCK, psignal_set, NULL);
         i_thread_rc = EXIT_FAILURE;
     }
-    sleep(1); // give thread a chance to start
 
     return i_thread_rc;
 }
@@ -0,0 +1,133 @@
+/*
+ * skn_timer_wheel.c
+ *
+ *  Hierarchical timer wheel for the locator's registry leases.
+ *  - a timer lands in the lowest level whose span reaches its expiry
+ *  - higher level slots are cascaded down as the level below wraps
+ *  - callers own the timers and any locking
+ */
+
+#include "skn_network_helpers.h"
+
+static void skn_timer_wheel_place(PTimerWheel ptw, PWheelTimer pwt);
+static void skn_timer_wheel_cascade(PTimerWheel ptw, int level);
+
+/**
+ * skn_timer_wheel_place()
+ * - links pwt into the slot matching its expiry; already due goes in the
+ *   current slot, which is about to be swept
+ */
+static void skn_timer_wheel_place(PTimerWheel ptw, PWheelTimer pwt) {
+    unsigned long delta = 0, expires = pwt->expires;
+    int level = 0, slot = 0;
+
+    if (expires < ptw->now) {
+        expires = ptw->now;
+    }
+    delta = expires - ptw->now;
+    for (level = 0; level < (SKN_WHEEL_LEVELS - 1); level++) {
+        if (delta < (1UL << (SKN_WHEEL_BITS * (level + 1)))) {
+            break;
+        }
+    }
+    slot = (int) ((expires >> (SKN_WHEEL_BITS * level)) & SKN_WHEEL_MASK);
+
+    pwt->slot = &ptw->slot[level][slot];
+    pwt->prev = NULL;
+    pwt->next = *pwt->slot;
+    if (pwt->next != NULL) {
+        pwt->next->prev = pwt;
+    }
+    *pwt->slot = pwt;
+}
+
+/**
+ * skn_timer_wheel_cascade()
+ * - re-places every timer in level's current slot into the levels below
+ */
+static void skn_timer_wheel_cascade(PTimerWheel ptw, int level) {
+    PWheelTimer pwt = NULL, next = NULL;
+    int slot = (int) ((ptw->now >> (SKN_WHEEL_BITS * level)) & SKN_WHEEL_MASK);
+
+    pwt = ptw->slot[level][slot];
+    ptw->slot[level][slot] = NULL;
+    while (pwt != NULL) {
+        next = pwt->next;
+        skn_timer_wheel_place(ptw, pwt);
+        pwt = next;
+    }
+}
+
+void skn_timer_wheel_init(PTimerWheel ptw) {
+    memset(ptw, 0, sizeof(TimerWheel));
+    strcpy(ptw->cbName, "PTimerWheel");
+}
+
+/**
+ * skn_timer_wheel_add()
+ * - (re)schedules pwt to fire after ticks, at least one, at most SKN_WHEEL_SPAN - 1
+ */
+void skn_timer_wheel_add(PTimerWheel ptw, PWheelTimer pwt, unsigned long ticks) {
+    if (pwt->slot != NULL) {
+        skn_timer_wheel_remove(ptw, pwt);
+    }
+    if (ticks < 1) {
+        ticks = 1;
+    } else if (ticks >= SKN_WHEEL_SPAN) {
+        ticks = SKN_WHEEL_SPAN - 1;
+    }
+
+    pwt->expires = ptw->now + ticks;
+    skn_timer_wheel_place(ptw, pwt);
+    ptw->pending++;
+}
+
+void skn_timer_wheel_remove(PTimerWheel ptw, PWheelTimer pwt) {
+    if (pwt->slot == NULL) {
+        return;
+    }
+    if (pwt->prev != NULL) {
+        pwt->prev->next = pwt->next;
+    } else {
+        *pwt->slot = pwt->next;
+    }
+    if (pwt->next != NULL) {
+        pwt->next->prev = pwt->prev;
+    }
+    pwt->next = pwt->prev = NULL;
+    pwt->slot = NULL;
+    ptw->pending--;
+}
+
+/**
+ * skn_timer_wheel_advance()
+ * - moves the wheel forward one tick and hands each timer now due to expire()
+ * - expire() may add or remove timers, including the one it was given
+ *
+ * - returns count of timers fired
+ */
+int skn_timer_wheel_advance(PTimerWheel ptw, void (*expire)(PWheelTimer pwt, void *context), void *context) {
+    PWheelTimer pwt = NULL;
+    int level = 0, fired = 0, slot = 0;
+
+    ptw->now++;
+
+    /* at a wrap, pull the next span down from the levels above, highest first */
+    for (level = 1; level < SKN_WHEEL_LEVELS; level++) {
+        if ((ptw->now & ((1UL << (SKN_WHEEL_BITS * level)) - 1)) != 0) {
+            break;
+        }
+    }
+    for (level = level - 1; level > 0; level--) {
+        skn_timer_wheel_cascade(ptw, level);
+    }
+
+    slot = (int) (ptw->now & SKN_WHEEL_MASK);
+    while ((pwt = ptw->slot[0][slot]) != NULL) {
+        skn_timer_wheel_remove(ptw, pwt);
+        fired++;
+        expire(pwt, context);
+    }
+
+    return fired;
+}
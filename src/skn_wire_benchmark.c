@@ -0,0 +1,216 @@
+/**
+ * skn_wire_benchmark.c
+ * - Developer tool, not installed
+ *
+ * Compares the binary wire format against the text format for registry
+ * responses of several sizes and for a display message: both must decode
+ * to the same records, then encode and decode cost per message and bytes
+ * on the wire are reported.
+ *
+ * cmdline: ./skn_wire_benchmark [rounds]
+*/
+
+#include "skn_network_helpers.h"
+
+#define BENCH_MESSAGES 1000
+#define BENCH_MAX_RECORDS 48
+
+typedef struct _benchEntry {
+    char name[SZ_CHAR_LABEL];
+    char ip[SZ_CHAR_LABEL];
+    struct in_addr addr;
+    uint16_t port;
+} BenchEntry, *PBenchEntry;
+
+typedef struct _benchRecords {
+    int count;
+    char line[BENCH_MAX_RECORDS][SZ_INFO_BUFF];
+} BenchRecords, *PBenchRecords;
+
+static BenchEntry gs_entry[BENCH_MAX_RECORDS];
+static char gs_text[SKN_REGISTRY_PAGE * 4];
+static char gs_binary[SKN_REGISTRY_PAGE * 4];
+static volatile int gs_sink = 0;
+
+static void bench_entries(int count) {
+    int index = 0;
+
+    for (index = 0; index < count; index++) {
+        snprintf(gs_entry[index].name, SZ_CHAR_LABEL, "%s_%02d", (index % 2 ? "lcd_display_service" : "rpi_locator_service"), index);
+        snprintf(gs_entry[index].ip, SZ_CHAR_LABEL, "10.100.%d.%d", 1 + (index / 200), 1 + (index % 200));
+        gs_entry[index].addr.s_addr = inet_addr(gs_entry[index].ip);
+        gs_entry[index].port = (uint16_t) (48028 + index);
+    }
+}
+
+/*
+ * Text encoding, as the locator builds its response */
+static int bench_encode_text(int count) {
+    int index = 0, len = 0;
+
+    for (index = 0; index < count; index++) {
+        len += snprintf(&gs_text[len], sizeof(gs_text) - len, "name=%s,ip=%s,port=%d|",
+                        gs_entry[index].name, gs_entry[index].ip, gs_entry[index].port);
+    }
+
+    return len;
+}
+
+static int bench_encode_binary(int count) {
+    int index = 0, len = skn_wire_registry_begin(gs_binary, sizeof(gs_binary));
+
+    for (index = 0; index < count; index++) {
+        len = skn_wire_registry_add(gs_binary, sizeof(gs_binary), len, gs_entry[index].name, gs_entry[index].addr, gs_entry[index].port);
+    }
+
+    return len;
+}
+
+static int bench_count(PRegistryRecord prec, void *context) {
+    gs_sink += prec->name.len + prec->ip.len + prec->port.len;
+    return EXIT_SUCCESS;
+}
+
+static int bench_collect(PRegistryRecord prec, void *context) {
+    PBenchRecords pbr = (PBenchRecords) context;
+
+    if (pbr->count < BENCH_MAX_RECORDS) {
+        snprintf(pbr->line[pbr->count++], SZ_INFO_BUFF, "%.*s,%.*s,%.*s",
+                 prec->name.len, prec->name.start, prec->ip.len, prec->ip.start, prec->port.len, prec->port.start);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Returns count of records where the two formats disagree */
+static int bench_compare(int count, int tlen, int blen) {
+    static BenchRecords text, binary;
+    int index = 0, diffs = 0, errors = 0;
+
+    memset(&text, 0, sizeof(text));
+    memset(&binary, 0, sizeof(binary));
+    service_registry_message_scan(gs_text, tlen, bench_collect, &text, &errors);
+    service_registry_message_scan(gs_binary, blen, bench_collect, &binary, &errors);
+
+    if ((text.count != count) || (binary.count != count) || (errors != 0)) {
+        skn_logger(SD_ERR, "Differs: records text %d binary %d of %d, %d errors", text.count, binary.count, count, errors);
+        return count;
+    }
+    for (index = 0; index < count; index++) {
+        if (strcmp(text.line[index], binary.line[index]) != 0) {
+            skn_logger(SD_ERR, "Differs: record %d [%s]/[%s]", index, text.line[index], binary.line[index]);
+            diffs++;
+        }
+    }
+
+    return diffs;
+}
+
+static double bench_ns(struct timeval *pstart, int rounds) {
+    return skn_duration_in_milliseconds(pstart, NULL) * 1.0e9 / ((double) rounds * BENCH_MESSAGES);
+}
+
+static int bench_registry(int count, int rounds) {
+    struct timeval start;
+    double tenc = 0.0, tdec = 0.0, benc = 0.0, bdec = 0.0;
+    int round = 0, index = 0, tlen = 0, blen = 0, diffs = 0;
+
+    bench_entries(count);
+    tlen = bench_encode_text(count);
+    blen = bench_encode_binary(count);
+    if ((diffs = bench_compare(count, tlen, blen)) > 0) {
+        return diffs;
+    }
+
+    for (round = 0; round < rounds; round++) {
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += bench_encode_text(count);
+        }
+        tenc += bench_ns(&start, rounds);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += service_registry_message_scan(gs_text, tlen, bench_count, NULL, NULL);
+        }
+        tdec += bench_ns(&start, rounds);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += bench_encode_binary(count);
+        }
+        benc += bench_ns(&start, rounds);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += service_registry_message_scan(gs_binary, blen, bench_count, NULL, NULL);
+        }
+        bdec += bench_ns(&start, rounds);
+    }
+
+    skn_logger(" ", "%8d %7d %10.1f %10.1f   %7d %10.1f %10.1f", count, tlen, tenc, tdec, blen, benc, bdec);
+
+    return 0;
+}
+
+static void bench_message(int rounds) {
+    const char *text = "This is a Display Message from a Raspberry Pi client";
+    char binary[SZ_INFO_BUFF];
+    char decoded[SZ_INFO_BUFF];
+    struct timeval start;
+    double enc = 0.0, dec = 0.0;
+    int round = 0, index = 0, blen = 0;
+
+    blen = skn_wire_encode_text(binary, sizeof(binary), SKN_WIRE_MESSAGE, 0, text);
+    if ((skn_wire_decode_text(binary, blen, NULL, decoded, sizeof(decoded)) != SKN_WIRE_MESSAGE) || (strcmp(text, decoded) != 0)) {
+        skn_logger(SD_ERR, "Differs: message [%s]/[%s]", text, decoded);
+        exit(EXIT_FAILURE);
+    }
+
+    for (round = 0; round < rounds; round++) {
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += skn_wire_encode_text(binary, sizeof(binary), SKN_WIRE_MESSAGE, 0, text);
+        }
+        enc += bench_ns(&start, rounds);
+
+        gettimeofday(&start, NULL);
+        for (index = 0; index < BENCH_MESSAGES; index++) {
+            gs_sink += skn_wire_decode_text(binary, blen, NULL, decoded, sizeof(decoded));
+        }
+        dec += bench_ns(&start, rounds);
+    }
+
+    skn_logger(" ", "\nDisplay message: text %d bytes, binary %d bytes, encode %1.1f ns, decode %1.1f ns",
+               (int) strlen(text), blen, enc, dec);
+}
+
+int main(int argc, char *argv[]) {
+    int sizes[] = { 1, 2, 8, 32 };
+    int rounds = 20, index = 0, diffs = 0;
+
+    skn_program_name_and_description_set(
+            "skn_wire_benchmark",
+            "Binary against text wire format benchmark."
+            );
+
+    if (argc > 1) {
+        rounds = atoi(argv[1]);
+    }
+    if (rounds < 1) {
+        rounds = 1;
+    }
+
+    skn_logger(" ", "Registry wire formats, %d rounds of %d messages, ns per message", rounds, BENCH_MESSAGES);
+    skn_logger(" ", "%8s %7s %10s %10s   %7s %10s %10s", "entries", "text-B", "encode", "decode", "bin-B", "encode", "decode");
+    for (index = 0; index < (int) (sizeof(sizes) / sizeof(sizes[0])); index++) {
+        diffs += bench_registry(sizes[index], rounds);
+    }
+    if (diffs > 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    bench_message(rounds);
+
+    exit(EXIT_SUCCESS);
+}
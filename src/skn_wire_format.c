@@ -0,0 +1,230 @@
+/*
+ * skn_wire_format.c
+ *
+ *  Optional binary encoding of locator and display traffic.
+ *  - fixed width IPv4 address and port, length prefixed strings
+ *  - decoded registry entries are handed to the same record() callbacks
+ *    as the text parser, so every consumer takes either format
+ */
+
+#include "skn_network_helpers.h"
+
+static int skn_wire_format_decimal(char *text, unsigned int value);
+
+/*
+ * writes value in decimal, unterminated; returns digits written */
+static int skn_wire_format_decimal(char *text, unsigned int value) {
+    char digits[8];
+    int count = 0, len = 0;
+
+    do {
+        digits[count++] = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+        text[len++] = digits[--count];
+    }
+
+    return len;
+}
+
+/**
+ * skn_wire_is_binary()
+ * - returns the message type when message is binary, else zero for text
+ */
+int skn_wire_is_binary(const char *message, int len) {
+    const unsigned char *pch = (const unsigned char *) message;
+
+    if ((len < SKN_WIRE_HEADER) || (pch[0] != SKN_WIRE_MAGIC) || (pch[1] != SKN_WIRE_VERSION)) {
+        return 0;
+    }
+
+    return pch[2];
+}
+
+/**
+ * skn_wire_encode_text()
+ * - encodes a query, message or status; code is only sent with a status
+ *
+ * - returns length encoded | PLATFORM_ERROR when buffer is too small
+ */
+int skn_wire_encode_text(char *buffer, int size, int type, int code, const char *text) {
+    unsigned char *pch = (unsigned char *) buffer;
+    int len = (int) strlen(text), used = SKN_WIRE_HEADER;
+
+    if ((len > 0xFFFF) || ((SKN_WIRE_HEADER + 4 + len) > size)) {
+        return PLATFORM_ERROR;
+    }
+
+    pch[0] = SKN_WIRE_MAGIC;
+    pch[1] = SKN_WIRE_VERSION;
+    pch[2] = (unsigned char) type;
+    pch[3] = 0;
+    if (type == SKN_WIRE_STATUS) {
+        pch[used++] = (unsigned char) (code >> 8);
+        pch[used++] = (unsigned char) code;
+    }
+    pch[used++] = (unsigned char) (len >> 8);
+    pch[used++] = (unsigned char) len;
+    memcpy(&pch[used], text, len);
+
+    return used + len;
+}
+
+/**
+ * skn_wire_decode_text()
+ * - copies the text of a query, message or status into text, terminated
+ *   and cut to size; code receives a status code when not NULL
+ *
+ * - returns message type | PLATFORM_ERROR when malformed
+ */
+int skn_wire_decode_text(const char *message, int len, int *code, char *text, int size) {
+    const unsigned char *pch = (const unsigned char *) message;
+    int type = skn_wire_is_binary(message, len), used = SKN_WIRE_HEADER, tlen = 0;
+
+    if ((type != SKN_WIRE_QUERY) && (type != SKN_WIRE_MESSAGE) && (type != SKN_WIRE_STATUS)) {
+        return PLATFORM_ERROR;
+    }
+    if (type == SKN_WIRE_STATUS) {
+        if ((used + 2) > len) {
+            return PLATFORM_ERROR;
+        }
+        if (code != NULL) {
+            *code = (pch[used] << 8) | pch[used + 1];
+        }
+        used += 2;
+    }
+    if ((used + 2) > len) {
+        return PLATFORM_ERROR;
+    }
+    tlen = (pch[used] << 8) | pch[used + 1];
+    used += 2;
+    if ((used + tlen) > len) {
+        return PLATFORM_ERROR;
+    }
+
+    if (tlen > (size - 1)) {
+        tlen = size - 1;
+    }
+    memmove(text, &pch[used], tlen);
+    text[tlen] = 0;
+
+    return type;
+}
+
+/**
+ * skn_wire_registry_begin()
+ * - starts an empty registry message
+ *
+ * - returns length encoded
+ */
+int skn_wire_registry_begin(char *buffer, int size) {
+    unsigned char *pch = (unsigned char *) buffer;
+
+    pch[0] = SKN_WIRE_MAGIC;
+    pch[1] = SKN_WIRE_VERSION;
+    pch[2] = SKN_WIRE_REGISTRY;
+    pch[3] = 0;
+
+    return SKN_WIRE_HEADER;
+}
+
+/**
+ * skn_wire_registry_add()
+ * - appends one entry to the registry message of len bytes in buffer
+ *
+ * - returns the new length | PLATFORM_ERROR when it does not fit
+ */
+int skn_wire_registry_add(char *buffer, int size, int len, const char *name, struct in_addr addr, uint16_t port) {
+    unsigned char *pch = (unsigned char *) buffer;
+    int nlen = (int) strlen(name);
+
+    if ((pch[3] == 0xFF) || (nlen > 0xFF) || ((len + SKN_WIRE_ENTRY + nlen) > size)) {
+        return PLATFORM_ERROR;
+    }
+
+    memcpy(&pch[len], &addr.s_addr, 4);     // already network order
+    pch[len + 4] = (unsigned char) (port >> 8);
+    pch[len + 5] = (unsigned char) port;
+    pch[len + 6] = (unsigned char) nlen;
+    memcpy(&pch[len + SKN_WIRE_ENTRY], name, nlen);
+    pch[3]++;
+
+    return len + SKN_WIRE_ENTRY + nlen;
+}
+
+/**
+ * skn_wire_registry_scan()
+ * - service_registry_response_scan() for a binary registry: record() sees
+ *   the name in place, ip and port as text formatted per entry
+ * - a truncated entry or empty name is an error and ends the scan
+ *
+ * - Returns count of complete entries, errors holds the failed ones
+ */
+int skn_wire_registry_scan(const char *message, int len, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors) {
+    const unsigned char *pch = (const unsigned char *) message;
+    RegistryRecord rec;
+    char ip[INET_ADDRSTRLEN];
+    char port[8];
+    int count = 0, index = 0, used = SKN_WIRE_HEADER, nlen = 0, records = 0, failures = 0, octet = 0;
+
+    if (skn_wire_is_binary(message, len) != SKN_WIRE_REGISTRY) {
+        if (errors != NULL) {
+            (*errors)++;
+        }
+        return 0;
+    }
+
+    count = pch[3];
+    for (index = 0; index < count; index++) {
+        if ((used + SKN_WIRE_ENTRY) > len) {
+            failures++;
+            break;
+        }
+        nlen = pch[used + 6];
+        if ((nlen == 0) || ((used + SKN_WIRE_ENTRY + nlen) > len)) {
+            failures++;
+            skn_logger(SD_DEBUG, "Binary response failure: entry %d of %d truncated", index + 1, count);
+            break;
+        }
+
+        rec.ip.start = ip;
+        rec.ip.len = 0;
+        for (octet = 0; octet < 4; octet++) {
+            if (octet > 0) {
+                ip[rec.ip.len++] = '.';
+            }
+            rec.ip.len += skn_wire_format_decimal(&ip[rec.ip.len], pch[used + octet]);
+        }
+        rec.port.start = port;
+        rec.port.len = skn_wire_format_decimal(port, (pch[used + 4] << 8) | pch[used + 5]);
+        rec.name.start = (const char *) &pch[used + SKN_WIRE_ENTRY];
+        rec.name.len = nlen;
+        used += SKN_WIRE_ENTRY + nlen;
+
+        records++;
+        if ((record != NULL) && (record(&rec, context) != EXIT_SUCCESS)) {
+            failures++;
+        }
+    }
+
+    if (errors != NULL) {
+        (*errors) += failures;
+    }
+
+    return records;
+}
+
+/**
+ * service_registry_message_scan()
+ * - scans a received registry response of either format
+ *
+ * - Returns count of complete entries, errors holds the failed ones
+ */
+int service_registry_message_scan(const char *message, int len, int (*record)(PRegistryRecord prec, void *context), void *context, int *errors) {
+    if (skn_wire_is_binary(message, len)) {
+        return skn_wire_registry_scan(message, len, record, context, errors);
+    }
+
+    return service_registry_response_scan(message, record, context, errors);
+}
@@ -7,10 +7,42 @@
 
 #include "skn_network_helpers.h"
 
+/*
+ * Streams each response as it is parsed, in --quorum mode */
+static int on_discovery_response(PDiscoveryRequest pdr, PServiceRegistry psr, struct sockaddr_in *premaddr, int records) {
+    skn_logger(SD_INFO, "Discovery: %d records from %s, %d of %d responders, %d entries",
+               records, inet_ntoa(premaddr->sin_addr), pdr->responders, pdr->min_responders,
+               service_registry_entry_count(psr));
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Keeps a paged copy of one locator's registry, asking only for changes
+ * after the first refresh; runs until ctrl-break */
+static void refresh_registry_view(int i_socket, int interval) {
+    RegistryView view;
+
+    service_registry_view_init(&view);
+    while (gi_exit_flag == SKN_RUN_MODE_RUN) {
+        if (service_registry_view_refresh(i_socket, &view, 2.0) == EXIT_SUCCESS) {
+            skn_logger(SD_NOTICE, "RegistryView: %s version %lu.%lu, %d entries, %d changes in %d pages, %d bytes",
+                       inet_ntoa(view.locator), view.epoch, view.version,
+                       service_registry_entry_count(view.psr), view.changes, view.pages, view.bytes);
+            if (view.changes > 0) {
+                service_registry_list_entries(view.psr);
+            }
+        }
+        sleep(interval);
+    }
+    service_registry_view_destroy(&view);
+}
 
 int main(int argc, char *argv[])
 {
     char request[SZ_COMM_BUFF];
+    char *service_name = "lcd_display_service";
+    DiscoveryRequest discovery;
+    PServiceRegistry psr = NULL;
 
     memset(request, 0, sizeof(request));
 	strcpy(request, "Raspberry Pi where are you?");
@@ -44,16 +76,25 @@ int main(int argc, char *argv[])
     	exit(EXIT_FAILURE);		
 	}
 
+    if (gd_pch_service_name != NULL) {
+        service_name = gd_pch_service_name;
+    }
+
 	/* Get the ServiceRegistry from Provider
+	 * - waits out the socket timeout, unless --quorum names how many providers suffice
+	 * - --relay-host asks that relay alone
+	 * - --non-stop keeps refreshing a paged copy instead
 	 * - could return null if error */
-	PServiceRegistry psr = service_registry_get_via_udp_broadcast(gd_i_socket, request);
+    if (gd_i_update > 0) {
+        refresh_registry_view(gd_i_socket, gd_i_update);
+    } else if ((gd_i_quorum > 0) || (gd_pch_relay_host != NULL)) {
+        service_registry_discovery_init(&discovery, service_name, gd_i_quorum, 8.0);
+        discovery.on_response = on_discovery_response;
+        psr = service_registry_discover(gd_i_socket, request, &discovery);
+    } else {
+        psr = service_registry_get_via_udp_broadcast(gd_i_socket, request);
+    }
 	if (psr != NULL && service_registry_entry_count(psr) != 0) {
-        char *service_name = "lcd_display_service";
-
-        if (gd_pch_service_name != NULL) {
-            service_name = gd_pch_service_name;
-        }
-
 		service_registry_list_entries(psr);
 
 		/* find a single entry */
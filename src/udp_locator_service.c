@@ -49,17 +49,10 @@ int main(int argc, char *argv[])
     /* Initialize Signal handler */
     signals_init();
 
-	gd_i_socket = skn_udp_host_create_broadcast_socket(SKN_FIND_RPI_PORT, 20.0);
-	if (gd_i_socket == EXIT_FAILURE) {
-		skn_logger(SD_EMERG, "Application Host Init Failed! ExitCode=%d", exit_code);
-        signals_cleanup(gi_exit_flag);
-    	exit(EXIT_FAILURE);		
-	}
-
-	exit_code = service_registry_provider(gd_i_socket, response);
+	/* Each worker owns a SO_REUSEPORT socket on SKN_FIND_RPI_PORT */
+	exit_code = service_registry_provider_workers(response, gd_i_workers);
 		skn_logger(SD_NOTICE, "Application ExitCode=%d", exit_code);
-	
-    if (gd_i_socket) close(gd_i_socket);
+
     signals_cleanup(gi_exit_flag);
 
     skn_logger(SD_NOTICE, "\n============================\nShutdown Complete\n============================\n");